@@ -33,14 +33,19 @@ int main( int argc, char** argv )
 //        _CrtSetBreakAlloc( 0 );
 	#endif
 	
-	// run asset builder on commandline switches -build, -rebuild, clean
+	// run asset builder on commandline switches -build, -rebuild, clean, -watch (keep rebuilding as files change), and 
+	// optionally -pack to also write a pack file
 	pixie_build::build_action build = pixie_build::BUILD_ACTION_UNDEFINED;
+	char const* pack_filename = 0;
 	for( int i = 1; i < argc; ++i ) 
 		{
 		if( stricmp( argv[ i ], "-build" ) == 0 ) build = pixie_build::BUILD_ACTION_BUILD;
 		if( stricmp( argv[ i ], "-rebuild" ) == 0 ) build = pixie_build::BUILD_ACTION_REBUILD;
 		if( stricmp( argv[ i ], "-clean" ) == 0 ) build = pixie_build::BUILD_ACTION_CLEAN;
+		if( stricmp( argv[ i ], "-watch" ) == 0 ) build = pixie_build::BUILD_ACTION_WATCH;
+		if( stricmp( argv[ i ], "-pack" ) == 0 ) pack_filename = "data.pak";
 		}
+	if( pack_filename && build == pixie_build::BUILD_ACTION_UNDEFINED ) build = pixie_build::BUILD_ACTION_BUILD;
 	if( build != pixie_build::BUILD_ACTION_UNDEFINED ) //return pixie_build::build( build, "../source_data", "../.buildtemp/data", "data" );
 		{
 		pixie_build::compiler_list compiler_list[] = 
@@ -52,7 +57,7 @@ int main( int argc, char** argv )
 		//	{ "afterworld_texture", afterworld_build::compiler_afterworld_texture, },
 			};
 		return pixie_build::build( build, "../source_data", "../.build_temp/data", "data", 
-			compiler_list, sizeof( compiler_list ) / sizeof( *compiler_list ) );
+			compiler_list, sizeof( compiler_list ) / sizeof( *compiler_list ), pack_filename );
 		}
 	}
 
@@ -19,6 +19,10 @@ namespace internal { template< typename T > struct align_helper { align_helper(
 
 enum POD_ENUM { IS_POD, NOT_POD };
 
+// specialize for types which can be moved to a new address with a plain memcpy (no pointers into themselves), to make 
+// non-POD arrays of them grow, insert and remove without calling copy constructors and destructors
+template< typename T > struct is_relocatable { enum { value = 0 }; };
+
 template< typename T, int CAPACITY, POD_ENUM POD > 
 struct array_type
 	{
@@ -43,6 +47,13 @@ struct array_type
 	void resize( int new_count, T const& item );
 	void resize( int new_count );	
 	void capacity_set( int capacity ) const;
+	void reserve( int capacity );
+	void shrink_to_fit();
+
+	template< typename P0 > T& emplace( P0 const& p0 );
+	template< typename P0, typename P1 > T& emplace( P0 const& p0, P1 const& p1 );
+	template< typename P0, typename P1, typename P2 > T& emplace( P0 const& p0, P1 const& p1, P2 const& p2 );
+	template< typename P0, typename P1, typename P2, typename P3 > T& emplace( P0 const& p0, P1 const& p1, P2 const& p2, P3 const& p3 );
 
 	int capacity() const;
 	int count() const;
@@ -63,6 +74,11 @@ struct array_type
 		// Specialized implementations for POD/NON-POD
 
 		template< POD_ENUM P > struct implementation { };
+		template< int RELOCATABLE > struct relocation { };
+
+		static void move_items( relocation<0>, T* dst, T* src, int count );
+		static void move_items( relocation<1>, T* dst, T* src, int count );
+		void reallocate( int new_capacity );
 
 		void ensure_capacity( implementation<NOT_POD>, int capacity );
 		void ensure_capacity( implementation<IS_POD>, int capacity );
@@ -329,31 +345,67 @@ void array_type<T, CAPACITY, POD>::ensure_capacity( implementation<NOT_POD>, int
 		int new_capacity = capacity_;
 		while( new_capacity < min_capacity ) new_capacity *= 2;
 
-		T* new_data = (T*) internal::array_malloc( memctx_, sizeof( T ) * new_capacity );
-		ARRAY_ASSERT( new_data, "Allocation failed when allocating memory for array" );
+		reallocate( new_capacity );
+		}
+
+	}
 
-		// copy each item from the old array to the new one
-		for( int i = 0; i < count_; ++i )
-			{
-			// copy using placement new and copy constructor
-			new ( new_data + i ) T( items_[ i ] );
 
-			// Call destructor manually on items to be deleted
-			items_[ i ].~T();
+// move_items, copy constructing each item to its new place and destroying the old one. Ranges may overlap.
+template< typename T, int CAPACITY, POD_ENUM POD >
+void array_type<T, CAPACITY, POD>::move_items( relocation<0>, T* dst, T* src, int count )
+	{
+	if( dst < src )
+		{
+		for( int i = 0; i < count; ++i )
+			{
+			new ( dst + i ) T( src[ i ] );
+			src[ i ].~T();
+			}
+		}
+	else if( dst > src )
+		{
+		for( int i = count - 1; i >= 0; --i )
+			{
+			new ( dst + i ) T( src[ i ] );
+			src[ i ].~T();
 			}
+		}
+	}
 
-		
-		// Release memory for the old array
-		if( data_large_ ) internal::array_free( memctx_, data_large_ );
 
-		// Store the pointer to the new array instead of the old
-		data_large_ = new_data;
-		items_ = data_large_;
+// move_items for relocatable types, just moving the bytes. Ranges may overlap.
+template< typename T, int CAPACITY, POD_ENUM POD >
+void array_type<T, CAPACITY, POD>::move_items( relocation<1>, T* dst, T* src, int count )
+	{
+	if( count > 0 && dst != src ) memmove( (void*) dst, (void*) src, sizeof( T ) * count );
+	}
 
-		// Increase the maximum number of items
-		capacity_ = new_capacity;
+
+// reallocate, moving the items to new storage (or back to the internal storage, if it is big enough)
+template< typename T, int CAPACITY, POD_ENUM POD >
+void array_type<T, CAPACITY, POD>::reallocate( int new_capacity )
+	{
+	T* new_data = 0;
+	T* new_items = internal::aligned_pointer( (T*) data_ );
+	if( new_capacity > CAPACITY )
+		{
+		new_data = (T*) internal::array_malloc( memctx_, sizeof( T ) * new_capacity );
+		ARRAY_ASSERT( new_data, "Allocation failed when allocating memory for array" );
+		new_items = new_data;
 		}
 
+	if( new_items != items_ ) 
+		move_items( relocation<POD == IS_POD || is_relocatable<T>::value>(), new_items, items_, count_ );
+		
+	// Release memory for the old array
+	if( data_large_ ) internal::array_free( memctx_, data_large_ );
+
+	// Store the pointer to the new array instead of the old
+	data_large_ = new_data;
+	items_ = new_items;
+
+	capacity_ = new_capacity > CAPACITY ? new_capacity : CAPACITY > 0 ? CAPACITY : 1;
 	}
 
 
@@ -500,15 +552,11 @@ T& array_type<T, CAPACITY, POD>::insert( implementation<NOT_POD>, int index, T c
 	add( implementation<NOT_POD>() );
 
 	// Shift existing items 
-	for( int i = count_ - 1; i > index; --i )
-		{
-		items_[ i ].~T();
-		new ( items_ + i ) T( items_[ i - 1 ] );
-		}
+	items_[ count_ - 1 ].~T();
+	move_items( relocation<is_relocatable<T>::value>(), items_ + index + 1, items_ + index, count_ - 1 - index );
 
 	// set the item
 	T* slot = items_ + index;
-	slot->~T();
 
 	new ( slot ) T( item ); // Placement new to copy item
 
@@ -559,15 +607,11 @@ T& array_type<T, CAPACITY, POD>::insert( implementation<NOT_POD>, int index )
 	add( implementation<NOT_POD>() );
 
 	// Shift existing items 
-	for( int i = count_ - 1; i > index; --i )
-		{
-		items_[ i ].~T();
-		new ( items_ + i ) T( items_[ i - 1 ] );
-		}
+	items_[ count_ - 1 ].~T();
+	move_items( relocation<is_relocatable<T>::value>(), items_ + index + 1, items_ + index, count_ - 1 - index );
 
 	// set the item
 	T* slot = items_ + index;
-	slot->~T();
 
 	#pragma warning( push ) 
 	#pragma warning( disable: 4619 ) // there is no warning number '4345'
@@ -617,18 +661,12 @@ void array_type<T, CAPACITY, POD>::remove( implementation<NOT_POD>, int index )
 	ARRAY_ASSERT( index < count_, "Index out of range" );
 	if( index >= count_ ) return;
 
-	// Move items after the item to be removed
-	for( int i = index; i < count_ - 1; ++i )
-		{
-		items_[ i ].~T();
-		new ( items_ + i ) T( items_[ i + 1 ] );
-		}
+	// Destroy the removed item, and move items after it into its place
+	items_[ index ].~T();
+	move_items( relocation<is_relocatable<T>::value>(), items_ + index, items_ + index + 1, count_ - index - 1 );
 	
 	// Decrease the total number of items
 	--count_;
-
-	// Call destructor on removed object
-	items_[ count_ ].~T();	
 	}
 
 
@@ -665,10 +703,9 @@ void array_type<T, CAPACITY, POD>::unordered_remove( implementation<NOT_POD>, in
 	ARRAY_ASSERT( index < count_, "Index out of range" );
 	if( index >= count_ ) return;
 
-	--count;
+	--count_;
 	items_[ index ].~T();
-	new ( items_ + index ) T( items_[ count ] );
-	items_[ count ].~T();		
+	move_items( relocation<is_relocatable<T>::value>(), items_ + index, items_ + count_, index < count_ ? 1 : 0 );
 	}
 
 
@@ -842,6 +879,67 @@ void array_type<T, CAPACITY, POD>::resize( implementation<IS_POD>, int new_count
 	}
 
 
+// reserve
+template< typename T, int CAPACITY, POD_ENUM POD > 
+void array_type<T, CAPACITY, POD>::reserve( int capacity )
+	{
+	ensure_capacity( implementation<POD>(), capacity );
+	}
+
+
+// shrink_to_fit
+template< typename T, int CAPACITY, POD_ENUM POD > 
+void array_type<T, CAPACITY, POD>::shrink_to_fit()
+	{
+	if( !data_large_ || capacity_ == count_ ) return;
+	reallocate( count_ );
+	}
+
+
+// emplace
+template< typename T, int CAPACITY, POD_ENUM POD > template< typename P0 > 
+T& array_type<T, CAPACITY, POD>::emplace( P0 const& p0 )
+	{
+	ensure_capacity( implementation<POD>(), count_ + 1 );
+	T* slot = new ( items_ + count_ ) T( p0 );
+	++count_;
+	return *slot;
+	}
+
+
+// emplace
+template< typename T, int CAPACITY, POD_ENUM POD > template< typename P0, typename P1 > 
+T& array_type<T, CAPACITY, POD>::emplace( P0 const& p0, P1 const& p1 )
+	{
+	ensure_capacity( implementation<POD>(), count_ + 1 );
+	T* slot = new ( items_ + count_ ) T( p0, p1 );
+	++count_;
+	return *slot;
+	}
+
+
+// emplace
+template< typename T, int CAPACITY, POD_ENUM POD > template< typename P0, typename P1, typename P2 > 
+T& array_type<T, CAPACITY, POD>::emplace( P0 const& p0, P1 const& p1, P2 const& p2 )
+	{
+	ensure_capacity( implementation<POD>(), count_ + 1 );
+	T* slot = new ( items_ + count_ ) T( p0, p1, p2 );
+	++count_;
+	return *slot;
+	}
+
+
+// emplace
+template< typename T, int CAPACITY, POD_ENUM POD > template< typename P0, typename P1, typename P2, typename P3 > 
+T& array_type<T, CAPACITY, POD>::emplace( P0 const& p0, P1 const& p1, P2 const& p2, P3 const& p3 )
+	{
+	ensure_capacity( implementation<POD>(), count_ + 1 );
+	T* slot = new ( items_ + count_ ) T( p0, p1, p2, p3 );
+	++count_;
+	return *slot;
+	}
+
+
 // capacity
 template< typename T, int CAPACITY, POD_ENUM POD > 
 int array_type<T, CAPACITY, POD>::capacity() const
@@ -108,6 +108,13 @@ int binary_rw_reader_u64( binary_rw_reader_t* reader, BINARY_RW_U64* value, int
 int binary_rw_reader_float( binary_rw_reader_t* reader, BINARY_RW_FLOAT* value, int count );
 int binary_rw_reader_double( binary_rw_reader_t* reader, BINARY_RW_DOUBLE* value, int count );
 
+// raw bytes, copied as they are with no endian conversion
+size_t binary_rw_reader_bytes( binary_rw_reader_t* reader, void* data, size_t size );
+
+// view mode: returns a pointer to the next `size` bytes in place, and moves past them, or returns 0 if there's not 
+// enough data left. the pointer is only valid for as long as the underlying data is
+void const* binary_rw_reader_view( binary_rw_reader_t* reader, size_t size );
+
 
 typedef void (*binary_rw_resize_func_t)( binary_rw_data_t* binary, size_t new_size, void* resize_context ); 
 
@@ -146,6 +153,9 @@ int binary_rw_writer_u32( binary_rw_writer_t* writer, BINARY_RW_U32 const* value
 int binary_rw_writer_u64( binary_rw_writer_t* writer, BINARY_RW_U64 const* value, int count );
 int binary_rw_writer_float( binary_rw_writer_t* writer, BINARY_RW_FLOAT const* value, int count );
 int binary_rw_writer_double( binary_rw_writer_t* writer, BINARY_RW_DOUBLE const* value, int count );
+
+// raw bytes, copied as they are with no endian conversion
+size_t binary_rw_writer_bytes( binary_rw_writer_t* writer, void const* data, size_t size );
 	
 
 #endif /* binary_rw_h */
@@ -192,175 +202,166 @@ size_t binary_rw_reader_position( binary_rw_reader_t* reader )
 	}
 
 
-#ifdef BINARY_RW_CHAR
-	int binary_rw_reader_char( binary_rw_reader_t* reader, BINARY_RW_CHAR* value, int count )
+#include <string.h>
+
+// data is stored little endian. on little endian platforms, arrays of values are copied as a single block, and on big
+// endian platforms each value is byte swapped as it is copied
+#if defined( __BYTE_ORDER__ ) && defined( __ORDER_BIG_ENDIAN__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	#define BINARY_RW_INTERNAL_BIG_ENDIAN
+#endif
+
+
+static void binary_rw_internal_copy( void* dst, void const* src, size_t element_size, size_t count )
+	{
+	// single values are the most common case, and copying them with a constant size lets the compiler use a plain move
+	if( count == 1 )
 		{
-		if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-		BINARY_RW_CHAR* ptr = (BINARY_RW_CHAR*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-		for( int i = 0; i < count; ++i ) 
+		#ifdef BINARY_RW_INTERNAL_BIG_ENDIAN
+			if( element_size == 1 ) { memcpy( dst, src, 1 ); return; }
+		#else
+			switch( element_size )
+				{
+				case 1: memcpy( dst, src, 1 ); return;
+				case 2: memcpy( dst, src, 2 ); return;
+				case 4: memcpy( dst, src, 4 ); return;
+				case 8: memcpy( dst, src, 8 ); return;
+				}
+		#endif
+		}
+
+	#ifdef BINARY_RW_INTERNAL_BIG_ENDIAN
+		if( element_size > 1 )
 			{
-			reader->position += sizeof( *ptr );
-			if( reader->position > reader->binary->size ) return i;
-			*value++ = *ptr++;
+			unsigned char* d = (unsigned char*) dst;
+			unsigned char const* s = (unsigned char const*) src;
+			for( size_t i = 0; i < count; ++i, d += element_size, s += element_size )
+				for( size_t j = 0; j < element_size; ++j ) d[ j ] = s[ element_size - 1 - j ];
+			return;
 			}
-		return count;
+	#endif
+	memcpy( dst, src, element_size * count );
+	}
+
+
+// the number of whole elements, up to `count`, which can be read from the current position
+static int binary_rw_internal_readable( binary_rw_reader_t* reader, size_t element_size, int count )
+	{
+	if( reader->binary->data == 0 || reader->binary->size == 0 || count <= 0 ) return 0;
+	if( reader->position >= reader->binary->size ) return 0;
+	size_t available = reader->binary->size - reader->position;
+	if( element_size * count <= available ) return count;
+	return (int)( available / element_size );
+	}
+
+
+static int binary_rw_internal_read( binary_rw_reader_t* reader, void* value, size_t element_size, int count )
+	{
+	int readable = binary_rw_internal_readable( reader, element_size, count );
+	binary_rw_internal_copy( value, (void const*)( ( (uintptr_t)reader->binary->data ) + reader->position ), 
+		element_size, (size_t) readable );
+	reader->position += element_size * readable;
+	return readable;
+	}
+
+
+#ifdef BINARY_RW_CHAR
+	int binary_rw_reader_char( binary_rw_reader_t* reader, BINARY_RW_CHAR* value, int count )
+		{
+		return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 		}
 #endif		
-
 	
 #ifdef BINARY_RW_BOOL
 	int binary_rw_reader_bool( binary_rw_reader_t* reader, BINARY_RW_BOOL* value, int count )
 	    {
-	    if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	    BINARY_RW_U8* ptr = (BINARY_RW_U8*)( ( (uintptr_t)reader->binary->data ) + reader->position ); // BOOL is stored as 8 bit unsigned
-	    for( int i = 0; i < count; ++i ) 
-		    {
-		    reader->position += sizeof( *ptr );
-		    if( reader->position > reader->binary->size ) return i;
+	    int readable = binary_rw_internal_readable( reader, sizeof( BINARY_RW_U8 ), count ); // BOOL is stored as 8 bit unsigned
+	    BINARY_RW_U8* ptr = (BINARY_RW_U8*)( ( (uintptr_t)reader->binary->data ) + reader->position ); 
+	    for( int i = 0; i < readable; ++i ) 
 		    *value++ = ( *ptr++ ) != 0; // translate between bool and u8
-		    }
-	    return count;
+	    reader->position += readable;
+	    return readable;
 	    }
 #endif		
 		
 	
 int binary_rw_reader_i8( binary_rw_reader_t* reader, BINARY_RW_I8* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_I8* ptr = (BINARY_RW_I8*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_i16( binary_rw_reader_t* reader, BINARY_RW_I16* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_I16* ptr = (BINARY_RW_I16*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_i32( binary_rw_reader_t* reader, BINARY_RW_I32* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_I32* ptr = (BINARY_RW_I32*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_i64( binary_rw_reader_t* reader, BINARY_RW_I64* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_I64* ptr = (BINARY_RW_I64*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_u8( binary_rw_reader_t* reader, BINARY_RW_U8* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_U8* ptr = (BINARY_RW_U8*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_u16( binary_rw_reader_t* reader, BINARY_RW_U16* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_U16* ptr = (BINARY_RW_U16*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_u32( binary_rw_reader_t* reader, BINARY_RW_U32* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_U32* ptr = (BINARY_RW_U32*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_u64( binary_rw_reader_t* reader, BINARY_RW_U64* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_U64* ptr = (BINARY_RW_U64*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_float( binary_rw_reader_t* reader, BINARY_RW_FLOAT* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_FLOAT* ptr = (BINARY_RW_FLOAT*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_reader_double( binary_rw_reader_t* reader, BINARY_RW_DOUBLE* value, int count )
 	{
-	if( reader->binary->data == 0 || reader->binary->size == 0 ) return 0;
-	BINARY_RW_DOUBLE* ptr = (BINARY_RW_DOUBLE*)( ( (uintptr_t)reader->binary->data ) + reader->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		reader->position += sizeof( *ptr );
-		if( reader->position > reader->binary->size ) return i;
-		*value++ = *ptr++;
-		}
-	return count;
+	return binary_rw_internal_read( reader, value, sizeof( *value ), count );
+	}
+	
+	
+size_t binary_rw_reader_bytes( binary_rw_reader_t* reader, void* data, size_t size )
+	{
+	if( reader->binary->data == 0 || reader->position >= reader->binary->size ) return 0;
+	size_t available = reader->binary->size - reader->position;
+	if( size > available ) size = available;
+	memcpy( data, (void const*)( ( (uintptr_t)reader->binary->data ) + reader->position ), size );
+	reader->position += size;
+	return size;
+	}
+
+
+void const* binary_rw_reader_view( binary_rw_reader_t* reader, size_t size )
+	{
+	if( reader->binary->data == 0 || reader->position > reader->binary->size ) return 0;
+	if( size > reader->binary->size - reader->position ) return 0;
+	void const* ptr = (void const*)( ( (uintptr_t)reader->binary->data ) + reader->position );
+	reader->position += size;
+	return ptr;
 	}
 	
 
@@ -400,248 +401,126 @@ size_t binary_rw_writer_position( binary_rw_writer_t* writer )
 
 
 
-#ifdef BINARY_RW_CHAR
-	int binary_rw_writer_char( binary_rw_writer_t* writer, BINARY_RW_CHAR const* value, int count )
+// makes room for up to `count` elements at the current position, growing the buffer geometrically if there is a resize 
+// callback, and returns how many whole elements fit
+static int binary_rw_internal_writable( binary_rw_writer_t* writer, size_t element_size, int count )
+	{
+	if( writer->binary->data == 0 || writer->binary->size == 0 || count <= 0 ) return 0;
+	size_t required = writer->position + element_size * count;
+	if( required > writer->binary->size )
 		{
-		if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-		
-		BINARY_RW_CHAR* ptr = (BINARY_RW_CHAR*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-		for( int i = 0; i < count; ++i ) 
+		if( writer->resize )
 			{
-			writer->position += sizeof( *ptr );
-			if( writer->position > writer->binary->size ) 
-				{
-				if( writer->resize )
-					writer->resize( writer->binary, writer->position, writer->resize_context );
-				else
-					return i;
-				}
-			*ptr++ = *value++;
+			size_t new_size = writer->binary->size * 2;
+			writer->resize( writer->binary, new_size > required ? new_size : required, writer->resize_context );
+			}
+		if( required > writer->binary->size )
+			{
+			if( writer->position >= writer->binary->size ) return 0;
+			return (int)( ( writer->binary->size - writer->position ) / element_size );
 			}
-		return count;
+		}
+	return count;
+	}
+
+
+static int binary_rw_internal_write( binary_rw_writer_t* writer, void const* value, size_t element_size, int count )
+	{
+	int writable = binary_rw_internal_writable( writer, element_size, count );
+	binary_rw_internal_copy( (void*)( ( (uintptr_t)writer->binary->data ) + writer->position ), value, 
+		element_size, (size_t) writable );
+	writer->position += element_size * writable;
+	return writable;
+	}
+
+
+#ifdef BINARY_RW_CHAR
+	int binary_rw_writer_char( binary_rw_writer_t* writer, BINARY_RW_CHAR const* value, int count )
+		{
+		return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 		}
 #endif		
 	
-
 #ifdef BINARY_RW_BOOL
 	int binary_rw_writer_bool( binary_rw_writer_t* writer, BINARY_RW_BOOL const* value, int count )
 	    {
-	    if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	    BINARY_RW_U8* ptr = (BINARY_RW_U8*)( ( (uintptr_t)writer->binary->data ) + writer->position ); // BOOL is stored as 8 bit unsigned
-	    for( int i = 0; i < count; ++i ) 
-		    {
-		    writer->position += sizeof( *ptr );
-			if( writer->position > writer->binary->size ) 
-				{
-				if( writer->resize )
-					writer->resize( writer->binary, writer->position, writer->resize_context );
-				else
-					return i;
-				}
+	    int writable = binary_rw_internal_writable( writer, sizeof( BINARY_RW_U8 ), count ); // BOOL is stored as 8 bit unsigned
+	    BINARY_RW_U8* ptr = (BINARY_RW_U8*)( ( (uintptr_t)writer->binary->data ) + writer->position ); 
+	    for( int i = 0; i < writable; ++i ) 
 		    *ptr++ = (BINARY_RW_U8)( (*value++) == 0 ? 0 : 1 ); // translate between bool and u8
-		    }
-	    return count;
+	    writer->position += writable;
+	    return writable;
 	    }	
 #endif		
 
 
 int binary_rw_writer_i8( binary_rw_writer_t* writer, BINARY_RW_I8 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_I8* ptr = (BINARY_RW_I8*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_i16( binary_rw_writer_t* writer, BINARY_RW_I16 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_I16* ptr = (BINARY_RW_I16*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_i32( binary_rw_writer_t* writer, BINARY_RW_I32 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_I32* ptr = (BINARY_RW_I32*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_i64( binary_rw_writer_t* writer, BINARY_RW_I64 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_I64* ptr = (BINARY_RW_I64*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_u8( binary_rw_writer_t* writer, BINARY_RW_U8 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_U8* ptr = (BINARY_RW_U8*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_u16( binary_rw_writer_t* writer, BINARY_RW_U16 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_U16* ptr = (BINARY_RW_U16*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_u32( binary_rw_writer_t* writer, BINARY_RW_U32 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_U32* ptr = (BINARY_RW_U32*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_u64( binary_rw_writer_t* writer, BINARY_RW_U64 const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_U64* ptr = (BINARY_RW_U64*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_float( binary_rw_writer_t* writer, BINARY_RW_FLOAT const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_FLOAT* ptr = (BINARY_RW_FLOAT*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
 	}
 	
 	
 int binary_rw_writer_double( binary_rw_writer_t* writer, BINARY_RW_DOUBLE const* value, int count )
 	{
-	if( writer->binary->data == 0 || writer->binary->size == 0 ) return 0;
-	BINARY_RW_DOUBLE* ptr = (BINARY_RW_DOUBLE*)( ( (uintptr_t)writer->binary->data ) + writer->position );
-	for( int i = 0; i < count; ++i ) 
-		{
-		writer->position += sizeof( *ptr );
-		if( writer->position > writer->binary->size ) 
-			{
-			if( writer->resize )
-				writer->resize( writer->binary, writer->position, writer->resize_context );
-			else
-				return i;
-			}
-		*ptr++ = *value++;
-		}
-	return count;
+	return binary_rw_internal_write( writer, value, sizeof( *value ), count );
+	}
+	
+	
+size_t binary_rw_writer_bytes( binary_rw_writer_t* writer, void const* data, size_t size )
+	{
+	if( size > (size_t) 0x7fffffff ) size = (size_t) 0x7fffffff;
+	int writable = binary_rw_internal_writable( writer, 1, (int) size );
+	memcpy( (void*)( ( (uintptr_t)writer->binary->data ) + writer->position ), data, (size_t) writable );
+	writer->position += (size_t) writable;
+	return (size_t) writable;
 	}
 	
 	
@@ -2,17 +2,55 @@
 #define dictionary_hpp
 
 
-/* TODO: proper implementation using hash table */
+/* Entries are kept in insertion order in an array (so iteration is by index, as before), with an open addressing hash
+   table (linear probing) of entry indices on the side for lookups. Strings are hashed by their (lowercase) characters,
+   any other key type is hashed by its bytes. */
 
+#include <stddef.h>
 #include "array.hpp"
 
+namespace strpool { template< typename POOL > struct string_type; }
+
 namespace dictionary_ns {
 
 template<typename KEY, typename T> struct entry_t 
 	{
 	KEY key;
 	T value;
+	unsigned int hash;
 	};
+
+
+inline unsigned int hash_bytes( void const* data, size_t size )
+	{
+	// FNV-1a
+	unsigned char const* bytes = (unsigned char const*) data;
+	unsigned int hash = 2166136261u;
+	for( size_t i = 0; i < size; ++i )
+		hash = ( hash ^ bytes[ i ] ) * 16777619u;
+	return hash;
+	}
+
+
+template< typename KEY > unsigned int hash_key( KEY const& key )
+	{
+	return hash_bytes( &key, sizeof( key ) );
+	}
+
+
+// the string id pool is case insensitive, so strings are always hashed as lowercase to give equal strings equal hashes
+template< typename POOL > unsigned int hash_key( strpool::string_type<POOL> const& key )
+	{
+	unsigned int hash = 2166136261u;
+	for( char const* str = key.c_str(); str && *str; ++str )
+		{
+		unsigned char c = (unsigned char) *str;
+		if( c >= 'A' && c <= 'Z' ) c = (unsigned char)( c - 'A' + 'a' );
+		hash = ( hash ^ c ) * 16777619u;
+		}
+	return hash;
+	}
+
 		
 #pragma warning( push ) 
 #pragma warning( disable: 4619 ) // pragma warning : there is no warning number 'number'
@@ -20,76 +58,164 @@ template<typename KEY, typename T> struct entry_t
 
 
 template< typename KEY, typename T, int CAPACITY = 16 > 
-struct dictionary : array_ns::array_type< entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD >
+struct dictionary : private array_ns::array_type< entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD >
 	{ 
+	typedef array_ns::array_type< entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD > entries_t;
+
 	explicit dictionary() : 
-		array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>( CAPACITY, pixie::internal::memctx() )
+		entries_t( CAPACITY, pixie::internal::memctx() ),
+		slots_( CAPACITY * 2, pixie::internal::memctx() )
 		{ 
 		}
 		
 		
 	template< typename U > dictionary( U const& other ) : 
-		array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>( other ) 
+		entries_t( other ),
+		slots_( CAPACITY * 2, pixie::internal::memctx() )
 		{			
+		rehash_keys();
 		}
 		
 		
 	template< typename U > explicit dictionary( U const* items, int count ) :
-		array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>( items, count ) 
+		entries_t( items, count ),
+		slots_( CAPACITY * 2, pixie::internal::memctx() )
 		{		
+		rehash_keys();
 		}
 		
 
 	T const* find( KEY const& key ) const
 		{
-		for( int i = 0; i < count(); ++i )
-			if( array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( i ).key == key )
-				return &( array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( i ).value );
+		int const slot = find_slot( key, hash_key( key ) );
+		if( slot < 0 ) return 0;
+		return &( entries_t::operator[]( slots_[ slot ] ).value );
 		}
 
 	T* find( KEY const& key ) 
 		{
-		for( int i = 0; i < count(); ++i )
-			if( array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[](i).key == key )
-				return &( array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( i ).value );
-		return 0;
+		int const slot = find_slot( key, hash_key( key ) );
+		if( slot < 0 ) return 0;
+		return &( entries_t::operator[]( slots_[ slot ] ).value );
 		}
 
 	void remove( KEY const& key ) 
 		{
-		for( int i = 0; i < count(); ++i )
-			if( array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( i ).key == key )
-				array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::remove( i );
+		int slot = find_slot( key, hash_key( key ) );
+		if( slot < 0 ) return;
+		int const index = slots_[ slot ];
+
+		// backward shift deletion, moving up any following entries which would no longer be reachable
+		int const mask = slots_.count() - 1;
+		slots_[ slot ] = -1;
+		for( int next = ( slot + 1 ) & mask; slots_[ next ] >= 0; next = ( next + 1 ) & mask )
+			{
+			int const ideal = (int)( entries_t::operator[]( slots_[ next ] ).hash & (unsigned int) mask );
+			if( ( ( next - ideal ) & mask ) >= ( ( next - slot ) & mask ) )
+				{
+				slots_[ slot ] = slots_[ next ];
+				slots_[ next ] = -1;
+				slot = next;
+				}
+			}
+
+		// remove the entry, keeping the order of the remaining ones
+		entries_t::remove( index );
+		for( int i = 0; i < slots_.count(); ++i )
+			if( slots_[ i ] > index ) --slots_[ i ];
+		}
+
+	void clear()
+		{
+		entries_t::clear();
+		slots_.clear();
 		}
+
+	// the array is private, as adding or removing entries through it would bypass the lookup table
+	using entries_t::count;
+	using entries_t::capacity;
+	using entries_t::reserve;
 		
 		
 	KEY const& key( int index ) const
 		{
-		return array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( index ).key;
+		return entries_t::operator[]( index ).key;
 		} 
 
 	T& item( int index )
 		{
-		return array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( index ).value;
+		return entries_t::operator[]( index ).value;
 		} 
 
 	T const& item( int index ) const
 		{
-		return array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( index ).value;
+		return entries_t::operator[]( index ).value;
 		} 
 
 	T& operator[]( KEY const& key )
 		{
-		for( int i = 0; i < count(); ++i )
-			if( array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( i ).key == key )
-				return array_ns::array_type<entry_t<KEY, T>, CAPACITY, array_ns::NOT_POD>::operator[]( i ).value;
+		unsigned int const hash = hash_key( key );
+		int const slot = find_slot( key, hash );
+		if( slot >= 0 ) return entries_t::operator[]( slots_[ slot ] ).value;
 			
-		entry_t<KEY, T>& entry = add();
+		// keep the load factor at or below one half
+		if( ( entries_t::count() + 1 ) * 2 > slots_.count() )
+			rebuild( slots_.count() > 0 ? slots_.count() * 2 : initial_slot_count() );
+
+		entry_t<KEY, T>& entry = entries_t::add();
 		entry.key = key;
 		entry.value = T();
+		entry.hash = hash;
+		insert_slot( entries_t::count() - 1 );
 		return entry.value;
 		}
 
+	private:
+		int find_slot( KEY const& key, unsigned int hash ) const
+			{
+			if( slots_.count() == 0 ) return -1;
+			int const mask = slots_.count() - 1;
+			for( int slot = (int)( hash & (unsigned int) mask ); slots_[ slot ] >= 0; slot = ( slot + 1 ) & mask )
+				{
+				entry_t<KEY, T> const& entry = entries_t::operator[]( slots_[ slot ] );
+				if( entry.hash == hash && entry.key == key ) return slot;
+				}
+			return -1;
+			}
+
+		void insert_slot( int index )
+			{
+			int const mask = slots_.count() - 1;
+			int slot = (int)( entries_t::operator[]( index ).hash & (unsigned int) mask );
+			while( slots_[ slot ] >= 0 ) slot = ( slot + 1 ) & mask;
+			slots_[ slot ] = index;
+			}
+
+		void rebuild( int slot_count ) // slot_count must be a power of two
+			{
+			slots_.clear();
+			slots_.resize( slot_count, -1 );
+			for( int i = 0; i < entries_t::count(); ++i )
+				insert_slot( i );
+			}
+
+		static int initial_slot_count()
+			{
+			int slot_count = 1;
+			while( slot_count < CAPACITY * 2 ) slot_count *= 2;
+			return slot_count;
+			}
+
+		void rehash_keys()
+			{
+			int slot_count = initial_slot_count();
+			while( entries_t::count() * 2 > slot_count ) slot_count *= 2;
+			for( int i = 0; i < entries_t::count(); ++i )
+				entries_t::operator[]( i ).hash = hash_key( entries_t::operator[]( i ).key );
+			rebuild( slot_count );
+			}
+
+		array_ns::array_type< int, CAPACITY * 2, array_ns::IS_POD > slots_; // entry index, or -1 for empty slots
 	};
 
 #pragma warning( pop ) 
@@ -98,4 +224,3 @@ struct dictionary : array_ns::array_type< entry_t<KEY, T>, CAPACITY, array_ns::N
 
 
 #endif // dictionary_hpp
-
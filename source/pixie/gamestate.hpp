@@ -23,6 +23,11 @@ enum transition
 	};
 
 
+// Called with TRANSITION_IN right before a gamestate is entered, and with TRANSITION_OUT right after it has been left.
+// The state id is the same as internal::type_id<STATE>()
+typedef void (*transition_listener_t)( void* user_data, transition type, void const* state_id );
+
+
 template< typename CTX = void > struct game_state_system
 	{
 	game_state_system( CTX* context, void* memctx = 0 );
@@ -64,6 +69,9 @@ template< typename CTX = void > struct game_state_system
 	transition transition_type() const;
 	float transition_progress() const;
 
+	// Get notified when gamestates are entered and left
+	void listener( transition_listener_t func, void* user_data = 0 );
+
 	private:
 		internal::system_t system_;
 	};
@@ -109,9 +117,12 @@ template<> struct game_state_system<void>
 	inline transition transition_type() const;
 	inline float transition_progress() const;
 
+	// Get notified when gamestates are entered and left
+	inline void listener( transition_listener_t func, void* user_data = 0 );
+
 	private:
 		internal::system_t* system_;
-		int storage_[ 20 ];
+		int storage_[ 24 ];
 	};
 
 
@@ -157,6 +168,9 @@ struct system_t
 	float transition_step;
 	int pop_count;
 
+	transition_listener_t listener;
+	void* listener_user_data;
+
 	struct registered_state_t
 		{
 		type_id_t state_id;
@@ -208,6 +222,7 @@ void reg( system_t* sys, type_id_t state_id, void* instance, init_func_t init, t
 void unreg( system_t* sys, type_id_t state_id );
 
 void update(system_t* sys, float delta_time );
+void listener( system_t* sys, transition_listener_t func, void* user_data );
 
 transition transition_type( system_t const* sys );
 float transition_progress( system_t const* sys );
@@ -654,6 +669,19 @@ void game_state_system<void>::update( float delta_time )
 	}
 
 
+template< typename CTX > 
+void game_state_system<CTX>::listener( transition_listener_t func, void* user_data )
+	{
+	internal::listener( &system_, func, user_data );
+	}
+
+
+void game_state_system<void>::listener( transition_listener_t func, void* user_data )
+	{
+	internal::listener( system_, func, user_data );
+	}
+
+
 template< typename CTX > 
 transition game_state_system<CTX>::transition_type() const
 	{
@@ -733,6 +761,9 @@ void init( system_t* sys, void* context, void* memctx )
 	sys->transition_step = 0.0f;
 	sys->pop_count = 0;
 
+	sys->listener = 0;
+	sys->listener_user_data = 0;
+
 	sys->registered_states_count = 0;
 	sys->registered_states_capacity = 128;
 	sys->registered_states = (system_t::registered_state_t*) GAMESTATE_MALLOC( sys->memctx, sys->registered_states_capacity * sizeof( *sys->registered_states ) );
@@ -837,6 +868,8 @@ void push( system_t* sys, type_id_t state_id )
 		sys->active_states_stack = new_stack;
 		}
 
+	if( sys->listener ) sys->listener( sys->listener_user_data, TRANSITION_IN, state_id );
+
 	system_t::active_state_t* state = &sys->active_states_stack[ sys->active_states_stack_count++ ];
 	state->state_id = state_id;
 	state->instance = init_state( sys, state_id, &state->state );
@@ -849,6 +882,7 @@ void pop( system_t* sys )
 
 	system_t::active_state_t* state = &sys->active_states_stack[ --sys->active_states_stack_count  ];
 	term_state( sys, state->state_id, state->instance );
+	if( sys->listener ) sys->listener( sys->listener_user_data, TRANSITION_OUT, state->state_id );
 	}
 
 
@@ -984,6 +1018,13 @@ void update( system_t* sys, float delta_time )
 	}
 
 
+void listener( system_t* sys, transition_listener_t func, void* user_data )
+	{
+	sys->listener = func;
+	sys->listener_user_data = user_data;
+	}
+
+
 transition transition_type( system_t const* sys )
 	{
 	return sys->transition_type;
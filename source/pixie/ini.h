@@ -3,7 +3,7 @@
 		  Licensing information can be found at the end of the file.
 ------------------------------------------------------------------------------
 
-ini.h - v1.2 - Simple ini-file reader for C/C++.
+ini.h - v1.3 - Simple ini-file reader for C/C++.
 
 Do this:
 	#define INI_IMPLEMENTATION
@@ -43,6 +43,21 @@ void ini_section_name_set( ini_t* ini, int section, char const* name, int length
 void ini_property_name_set( ini_t* ini, int section, int property, char const* name, int length );
 void ini_property_value_set( ini_t* ini, int section, int property, char const* value, int length  );
 
+typedef struct ini_view_t ini_view_t;
+
+ini_view_t* ini_view_load( char const* data, int size, void* memctx );
+void ini_view_destroy( ini_view_t* ini );
+
+int ini_view_section_count( ini_view_t const* ini );
+char const* ini_view_section_name( ini_view_t const* ini, int section, int* length );
+
+int ini_view_property_count( ini_view_t const* ini, int section );
+char const* ini_view_property_name( ini_view_t const* ini, int section, int property, int* length );
+char const* ini_view_property_value( ini_view_t const* ini, int section, int property, int* length );
+
+int ini_view_find_section( ini_view_t const* ini, char const* name, int name_length );
+int ini_view_find_property( ini_view_t const* ini, int section, char const* name, int name_length );
+
 #endif /* ini_h */
 
 
@@ -374,6 +389,70 @@ returned by `ini_property_count`. The defined constant `INI_GLOBAL_SECTION` can
 `length` specifies the number of characters in `value`, which does not have to be zero-terminated. If `length` is zero, 
 the length is determined automatically, but in this case `value` has to be zero-terminated.
 
+
+Read-only views
+---------------
+
+For large files which only need to be read, ini.h can parse into an `ini_view_t` instead of an `ini_t`. A view does not 
+copy any names or values, it just references them in the original data, which must be kept alive (and unchanged) for 
+as long as the view is used. The strings returned are not zero-terminated, so their length is returned separately. 
+Sections and properties are indexed by hashes of their names, so finding them takes constant time regardless of the
+size of the file. Names are compared without regard to case, and must match in full. If several sections or properties 
+share a name, the first one is found.
+
+
+ini_view_load
+-------------
+
+	ini_view_t* ini_view_load( char const* data, int size, void* memctx )
+
+Parse the string `data` containing an ini-file, and create a new read-only view of it. `size` specifies the number of 
+characters in `data`, which does not have to be zero-terminated. If `size` is zero, the length is determined 
+automatically, but in this case `data` has to be zero-terminated. Sections and properties are parsed the same way as by 
+`ini_load`, and are numbered the same way. When no longer needed, the view can be destroyed by calling 
+`ini_view_destroy`. `memctx` is a pointer to user defined data which will be passed through to the custom 
+INI_MALLOC/INI_FREE calls. It can be NULL if no user defined data is needed.
+
+
+ini_view_destroy
+----------------
+
+	void ini_view_destroy( ini_view_t* ini )
+
+Destroy an `ini_view_t` instance created by calling `ini_view_load`, releasing the memory allocated by it. The data it
+was loaded from is not touched.
+
+
+ini_view_section_count / ini_view_property_count
+------------------------------------------------
+
+	int ini_view_section_count( ini_view_t const* ini )
+	int ini_view_property_count( ini_view_t const* ini, int section )
+
+Works the same as `ini_section_count` and `ini_property_count`, except that `ini_view_property_count` does not have to 
+look through all the properties to count them.
+
+
+ini_view_section_name / ini_view_property_name / ini_view_property_value
+------------------------------------------------------------------------
+
+	char const* ini_view_section_name( ini_view_t const* ini, int section, int* length )
+	char const* ini_view_property_name( ini_view_t const* ini, int section, int property, int* length )
+	char const* ini_view_property_value( ini_view_t const* ini, int section, int property, int* length )
+
+Returns a pointer into the original data, at the start of the section name, property name or property value, and 
+stores the number of characters in it in `length` (which may be NULL, if not needed). The returned string is not 
+zero-terminated. If the section or property index is out of range, NULL is returned and `length` is set to zero.
+
+
+ini_view_find_section / ini_view_find_property
+----------------------------------------------
+
+	int ini_view_find_section( ini_view_t const* ini, char const* name, int name_length )
+	int ini_view_find_property( ini_view_t const* ini, int section, char const* name, int name_length )
+
+Works the same as `ini_find_section` and `ini_find_property`, but looks the name up in a hash table. 
+
 **/
 
 
@@ -552,10 +631,13 @@ ini_t* ini_load( char const* data, void* memctx )
 					start2 = ptr;
 					while( *ptr && *ptr != '\n' )
 						++ptr;
-					while( *(--ptr) <= ' ' ) 
-						(void)ptr;
-					ptr++;
-					ini_property_add( ini, s, start, l, start2, (int)( ptr - start2) );
+					while( ptr > start2 && *( ptr - 1 ) <= ' ' ) 
+						--ptr;
+					/* a length of zero means zero-terminated to ini_property_add, so pass empty values as an empty string */
+					if( ptr > start2 )
+						ini_property_add( ini, s, start, l, start2, (int)( ptr - start2) );
+					else
+						ini_property_add( ini, s, start, l, "", 0 );
 					}
 				}
 			}
@@ -985,6 +1067,386 @@ void ini_property_value_set( ini_t* ini, int section, int property, char const*
 	}
 
 
+struct ini_internal_view_section_t
+	{
+	char const* name;
+	int name_length;
+	unsigned int hash;
+	int first_property;
+	int property_count;
+	};
+
+
+struct ini_internal_view_property_t
+	{
+	int section;
+	unsigned int hash;
+	char const* name;
+	int name_length;
+	char const* value;
+	int value_length;
+	};
+
+
+struct ini_view_t
+	{
+	struct ini_internal_view_section_t* sections;
+	int section_capacity;
+	int section_count;
+
+	struct ini_internal_view_property_t* properties;
+	int property_capacity;
+	int property_count;
+
+	/* open addressing hash tables, holding section/property indices or INI_NOT_FOUND for empty slots */
+	int* section_table;
+	int section_table_size;
+	int* property_table;
+	int property_table_size;
+
+	void* memctx;
+	};
+
+
+static unsigned int ini_internal_hash( char const* str, int length )
+	{
+	unsigned int hash;
+	int i;
+	char c;
+
+	hash = 2166136261u;
+	for( i = 0; i < length; ++i )
+		{
+		c = str[ i ];
+		if( c >= 'A' && c <= 'Z' ) c = (char)( c - 'A' + 'a' );
+		hash = ( hash ^ (unsigned char) c ) * 16777619u;
+		}
+	return hash;
+	}
+
+
+static unsigned int ini_internal_property_hash( int section, char const* name, int length )
+	{
+	return ini_internal_hash( name, length ) ^ ( (unsigned int) section * 2654435761u );
+	}
+
+
+static int ini_internal_names_equal( char const* a, int a_length, char const* b, int b_length )
+	{
+	return a_length == b_length && ( a_length == 0 || INI_STRNICMP( a, b, (size_t) a_length ) == 0 );
+	}
+
+
+static int* ini_internal_table_create( void* memctx, int count, int* size )
+	{
+	int* table;
+	int i;
+
+	(void) memctx;
+	*size = 16;
+	while( *size < count * 2 ) *size *= 2;
+	table = (int*) INI_MALLOC( memctx, *size * sizeof( int ) );
+	for( i = 0; i < *size; ++i ) table[ i ] = INI_NOT_FOUND;
+	return table;
+	}
+
+
+static int ini_internal_view_section_slot( ini_view_t const* ini, unsigned int hash, char const* name, int length )
+	{
+	unsigned int mask;
+	unsigned int slot;
+	struct ini_internal_view_section_t const* section;
+
+	mask = (unsigned int)( ini->section_table_size - 1 );
+	slot = hash & mask;
+	while( ini->section_table[ slot ] != INI_NOT_FOUND )
+		{
+		section = &ini->sections[ ini->section_table[ slot ] ];
+		if( section->hash == hash && ini_internal_names_equal( section->name, section->name_length, name, length ) ) break;
+		slot = ( slot + 1 ) & mask;
+		}
+	return (int) slot;
+	}
+
+
+static int ini_internal_view_property_slot( ini_view_t const* ini, int section, unsigned int hash, char const* name, 
+	int length )
+	{
+	unsigned int mask;
+	unsigned int slot;
+	struct ini_internal_view_property_t const* property;
+
+	mask = (unsigned int)( ini->property_table_size - 1 );
+	slot = hash & mask;
+	while( ini->property_table[ slot ] != INI_NOT_FOUND )
+		{
+		property = &ini->properties[ ini->property_table[ slot ] ];
+		if( property->hash == hash && property->section == section && 
+			ini_internal_names_equal( property->name, property->name_length, name, length ) ) 
+			break;
+		slot = ( slot + 1 ) & mask;
+		}
+	return (int) slot;
+	}
+
+
+static void ini_internal_view_section_add( ini_view_t* ini, char const* name, int length )
+	{
+	struct ini_internal_view_section_t* new_sections;
+	struct ini_internal_view_section_t* section;
+
+	if( ini->section_count >= ini->section_capacity )
+		{
+		ini->section_capacity *= 2;
+		new_sections = (struct ini_internal_view_section_t*) INI_MALLOC( ini->memctx, 
+			ini->section_capacity * sizeof( ini->sections[ 0 ] ) );
+		INI_MEMCPY( new_sections, ini->sections, ini->section_count * sizeof( ini->sections[ 0 ] ) );
+		INI_FREE( ini->memctx, ini->sections );
+		ini->sections = new_sections;
+		}
+
+	section = &ini->sections[ ini->section_count++ ];
+	section->name = name;
+	section->name_length = length;
+	section->hash = ini_internal_hash( name, length );
+	section->first_property = ini->property_count;
+	section->property_count = 0;
+	}
+
+
+static void ini_internal_view_property_add( ini_view_t* ini, char const* name, int name_length, char const* value, 
+	int value_length )
+	{
+	struct ini_internal_view_property_t* new_properties;
+	struct ini_internal_view_property_t* property;
+	int section;
+
+	if( ini->property_count >= ini->property_capacity )
+		{
+		ini->property_capacity *= 2;
+		new_properties = (struct ini_internal_view_property_t*) INI_MALLOC( ini->memctx, 
+			ini->property_capacity * sizeof( ini->properties[ 0 ] ) );
+		INI_MEMCPY( new_properties, ini->properties, ini->property_count * sizeof( ini->properties[ 0 ] ) );
+		INI_FREE( ini->memctx, ini->properties );
+		ini->properties = new_properties;
+		}
+
+	/* properties always belong to the most recently added section, so each section's properties are contiguous */
+	section = ini->section_count - 1;
+	++ini->sections[ section ].property_count;
+	property = &ini->properties[ ini->property_count++ ];
+	property->section = section;
+	property->hash = ini_internal_property_hash( section, name, name_length );
+	property->name = name;
+	property->name_length = name_length;
+	property->value = value;
+	property->value_length = value_length;
+	}
+
+
+ini_view_t* ini_view_load( char const* data, int size, void* memctx )
+	{
+	ini_view_t* ini;
+	char const* ptr;
+	char const* end;
+	char const* start;
+	char const* start2;
+	int l;
+	int i;
+	int slot;
+
+	ini = (ini_view_t*) INI_MALLOC( memctx, sizeof( ini_view_t ) );
+	ini->memctx = memctx;
+	ini->sections = (struct ini_internal_view_section_t*) INI_MALLOC( ini->memctx, INITIAL_CAPACITY * sizeof( ini->sections[ 0 ] ) );
+	ini->section_capacity = INITIAL_CAPACITY;
+	ini->section_count = 0;
+	ini->properties = (struct ini_internal_view_property_t*) INI_MALLOC( ini->memctx, INITIAL_CAPACITY * sizeof( ini->properties[ 0 ] ) );
+	ini->property_capacity = INITIAL_CAPACITY;
+	ini->property_count = 0;
+	ini_internal_view_section_add( ini, "", 0 ); /* global section */
+
+	ptr = data;
+	if( ptr )
+		{
+		if( size <= 0 ) size = (int) INI_STRLEN( data );
+		end = data + size;
+		while( ptr < end )
+			{
+			/* trim leading whitespace */
+			while( ptr < end && *ptr <=' ' )
+				++ptr;
+			
+			/* done? */
+			if( ptr >= end ) break;
+
+			/* comment */
+			else if( *ptr == ';' )
+				{
+				while( ptr < end && *ptr !='\n' )
+					++ptr;
+				}
+			/* section */
+			else if( *ptr == '[' )
+				{
+				++ptr;
+				start = ptr;
+				while( ptr < end && *ptr !=']' && *ptr != '\n' )
+					++ptr;
+
+				if( ptr < end && *ptr == ']' )
+					{
+					ini_internal_view_section_add( ini, start, (int)( ptr - start) );
+					++ptr;
+					}
+				}
+			/* property */
+			else
+				{
+				start = ptr;
+				while( ptr < end && *ptr !='=' && *ptr != '\n' )
+					++ptr;
+
+				if( ptr < end && *ptr == '=' )
+					{
+					l = (int)( ptr - start);
+					++ptr;
+					while( ptr < end && *ptr <= ' ' && *ptr != '\n' ) 
+						ptr++;
+					start2 = ptr;
+					while( ptr < end && *ptr != '\n' )
+						++ptr;
+					while( ptr > start2 && *( ptr - 1 ) <= ' ' ) 
+						--ptr;
+					ini_internal_view_property_add( ini, start, l, start2, (int)( ptr - start2) );
+					}
+				}
+			}
+		}   
+
+	/* index everything by name, keeping the first of any duplicates */
+	ini->section_table = ini_internal_table_create( ini->memctx, ini->section_count, &ini->section_table_size );
+	for( i = 0; i < ini->section_count; ++i )
+		{
+		slot = ini_internal_view_section_slot( ini, ini->sections[ i ].hash, ini->sections[ i ].name, 
+			ini->sections[ i ].name_length );
+		if( ini->section_table[ slot ] == INI_NOT_FOUND ) ini->section_table[ slot ] = i;
+		}
+
+	ini->property_table = ini_internal_table_create( ini->memctx, ini->property_count, &ini->property_table_size );
+	for( i = 0; i < ini->property_count; ++i )
+		{
+		slot = ini_internal_view_property_slot( ini, ini->properties[ i ].section, ini->properties[ i ].hash, 
+			ini->properties[ i ].name, ini->properties[ i ].name_length );
+		if( ini->property_table[ slot ] == INI_NOT_FOUND ) ini->property_table[ slot ] = i;
+		}
+
+	return ini;
+	}
+
+
+void ini_view_destroy( ini_view_t* ini )
+	{
+	if( ini )
+		{
+		INI_FREE( ini->memctx, ini->property_table );
+		INI_FREE( ini->memctx, ini->section_table );
+		INI_FREE( ini->memctx, ini->properties );
+		INI_FREE( ini->memctx, ini->sections );
+		INI_FREE( ini->memctx, ini );
+		}
+	}
+
+
+int ini_view_section_count( ini_view_t const* ini )
+	{
+	if( ini ) return ini->section_count;
+	return 0;
+	}
+
+
+char const* ini_view_section_name( ini_view_t const* ini, int section, int* length )
+	{
+	if( ini && section >= 0 && section < ini->section_count )
+		{
+		if( length ) *length = ini->sections[ section ].name_length;
+		return ini->sections[ section ].name;
+		}
+
+	if( length ) *length = 0;
+	return NULL;
+	}
+
+
+int ini_view_property_count( ini_view_t const* ini, int section )
+	{
+	if( ini && section >= 0 && section < ini->section_count ) return ini->sections[ section ].property_count;
+	return 0;
+	}
+
+
+char const* ini_view_property_name( ini_view_t const* ini, int section, int property, int* length )
+	{
+	struct ini_internal_view_property_t const* p;
+
+	if( ini && section >= 0 && section < ini->section_count && property >= 0 && 
+		property < ini->sections[ section ].property_count )
+		{
+		p = &ini->properties[ ini->sections[ section ].first_property + property ];
+		if( length ) *length = p->name_length;
+		return p->name;
+		}
+
+	if( length ) *length = 0;
+	return NULL;
+	}
+
+
+char const* ini_view_property_value( ini_view_t const* ini, int section, int property, int* length )
+	{
+	struct ini_internal_view_property_t const* p;
+
+	if( ini && section >= 0 && section < ini->section_count && property >= 0 && 
+		property < ini->sections[ section ].property_count )
+		{
+		p = &ini->properties[ ini->sections[ section ].first_property + property ];
+		if( length ) *length = p->value_length;
+		return p->value;
+		}
+
+	if( length ) *length = 0;
+	return NULL;
+	}
+
+
+int ini_view_find_section( ini_view_t const* ini, char const* name, int name_length )
+	{
+	if( ini && name )
+		{
+		if( name_length <= 0 ) name_length = (int) INI_STRLEN( name );
+		return ini->section_table[ ini_internal_view_section_slot( ini, ini_internal_hash( name, name_length ), name, 
+			name_length ) ];
+		}
+
+	return INI_NOT_FOUND;
+	}
+
+
+int ini_view_find_property( ini_view_t const* ini, int section, char const* name, int name_length )
+	{
+	int p;
+
+	if( ini && name && section >= 0 && section < ini->section_count )
+		{
+		if( name_length <= 0 ) name_length = (int) INI_STRLEN( name );
+		p = ini->property_table[ ini_internal_view_property_slot( ini, section, 
+			ini_internal_property_hash( section, name, name_length ), name, name_length ) ];
+		if( p != INI_NOT_FOUND ) return p - ini->sections[ section ].first_property;
+		}
+
+	return INI_NOT_FOUND;
+	}
+
+
 #endif /* INI_IMPLEMENTATION */
 
 /*
@@ -994,6 +1456,7 @@ contributors:
 	Branimir Karadzic (INI_STRNICMP bugfix)
 
 revision history:
+	1.3     read-only ini_view_t parsing mode, referencing the original data, with hashed lookups
 	1.2     using strnicmp for correct length compares, fixed copy-paste bug in ini_property_value_set
 	1.1     customization, added documentation, cleanup
 	1.0     first publicly released version
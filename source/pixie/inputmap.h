@@ -179,6 +179,7 @@ typedef struct internal_inputmap_mapping_t
 	{
 	int freelist_next;
 	int action;
+	int state_index;
 	internal_inputmap_mapping_type_t mapping_type;
 	union
 		{
@@ -214,6 +215,9 @@ struct inputmap_t
 	int actions_state_count;
 	int actions_state_capacity;
 	internal_inputmap_action_state_t* actions_state;
+
+	int actions_lookup_capacity;
+	int* actions_lookup;
 	
 	struct 
 		{
@@ -243,6 +247,11 @@ inputmap_t* inputmap_create( void* memctx )
 	inputmap->actions_state = (internal_inputmap_action_state_t*) INPUTMAP_MALLOC( 
 		inputmap->memctx, sizeof( *inputmap->actions_state ) * inputmap->actions_state_capacity );
 
+	inputmap->actions_lookup_capacity = inputmap->actions_state_capacity * 2;
+	inputmap->actions_lookup = (int*) INPUTMAP_MALLOC( 
+		inputmap->memctx, sizeof( *inputmap->actions_lookup ) * inputmap->actions_lookup_capacity );
+	for( int i = 0; i < inputmap->actions_lookup_capacity; ++i ) inputmap->actions_lookup[ i ] = -1;
+
 	memset( &inputmap->input_state, 0, sizeof( inputmap->input_state ) );
 	
 	return inputmap;
@@ -251,18 +260,74 @@ inputmap_t* inputmap_create( void* memctx )
 
 void inputmap_destroy( inputmap_t* inputmap ) 
 	{
+	INPUTMAP_FREE( inputmap->memctx, inputmap->actions_lookup );
 	INPUTMAP_FREE( inputmap->memctx, inputmap->actions_state );
 	INPUTMAP_FREE( inputmap->memctx, inputmap->mappings );
 	INPUTMAP_FREE( inputmap->memctx, inputmap );
 	}
 
 
+// action states are kept in a dense array, and each mapping stores the index of the state it writes to. the 
+// lookup table is an open addressing hash from action id to state index, used for queries and for resolving 
+// new mappings. it is kept at twice the capacity of the state array, so it never fills up.
+
+int internal_inputmap_lookup_slot( inputmap_t* inputmap, int action )
+	{
+	unsigned int mask = (unsigned int)( inputmap->actions_lookup_capacity - 1 );
+	unsigned int slot = ( (unsigned int) action * 2654435761u ) & mask;
+	while( inputmap->actions_lookup[ slot ] >= 0 && inputmap->actions_state[ inputmap->actions_lookup[ slot ] ].action != action )
+		slot = ( slot + 1 ) & mask;
+	return (int) slot;
+	}
+
+
+void internal_inputmap_rebuild_lookup( inputmap_t* inputmap )
+	{
+	for( int i = 0; i < inputmap->actions_lookup_capacity; ++i ) inputmap->actions_lookup[ i ] = -1;
+	for( int i = 0; i < inputmap->actions_state_count; ++i )
+		inputmap->actions_lookup[ internal_inputmap_lookup_slot( inputmap, inputmap->actions_state[ i ].action ) ] = i;
+	}
+
+
+int internal_inputmap_state_index( inputmap_t* inputmap, int action )
+	{
+	int slot = internal_inputmap_lookup_slot( inputmap, action );
+	if( inputmap->actions_lookup[ slot ] >= 0 ) return inputmap->actions_lookup[ slot ];
+
+	if( inputmap->actions_state_count >= inputmap->actions_state_capacity )
+		{
+		inputmap->actions_state_capacity *= 2;
+		internal_inputmap_action_state_t* new_actions_state = (internal_inputmap_action_state_t*) INPUTMAP_MALLOC( 
+			inputmap->memctx, sizeof( *inputmap->actions_state ) * inputmap->actions_state_capacity );
+		INPUTMAP_ASSERT( new_actions_state, "Allocation failed." );
+		for( int i = 0; i < inputmap->actions_state_count; ++i ) new_actions_state[ i ] = inputmap->actions_state[ i ];
+		INPUTMAP_FREE( inputmap->memctx, inputmap->actions_state );
+		inputmap->actions_state = new_actions_state;
+
+		INPUTMAP_FREE( inputmap->memctx, inputmap->actions_lookup );
+		inputmap->actions_lookup_capacity = inputmap->actions_state_capacity * 2;
+		inputmap->actions_lookup = (int*) INPUTMAP_MALLOC( 
+			inputmap->memctx, sizeof( *inputmap->actions_lookup ) * inputmap->actions_lookup_capacity );
+		INPUTMAP_ASSERT( inputmap->actions_lookup, "Allocation failed." );
+		internal_inputmap_rebuild_lookup( inputmap );
+		slot = internal_inputmap_lookup_slot( inputmap, action );
+		}
+
+	int index = inputmap->actions_state_count++;
+	inputmap->actions_state[ index ].action = action;
+	inputmap->actions_state[ index ].state = 0.0f;
+	inputmap->actions_lookup[ slot ] = index;
+	return index;
+	}
+
+
 int internal_inputmap_add_mapping( inputmap_t* inputmap )
 	{
 	if( inputmap->mappings_freelist >= 0 )
 		{
 		int ret = inputmap->mappings_freelist;
 		inputmap->mappings_freelist = inputmap->mappings[ ret ].freelist_next;
+		inputmap->mappings[ ret ].state_index = -1;
 		return ret;
 		}
 	
@@ -277,6 +342,7 @@ int internal_inputmap_add_mapping( inputmap_t* inputmap )
 		inputmap->mappings = new_mappings;
 		}
 
+	inputmap->mappings[ inputmap->mappings_count ].state_index = -1;
 	return inputmap->mappings_count++;
 	}	
 
@@ -466,14 +532,15 @@ void inputmap_remove( inputmap_t* inputmap, int action )
 			}
 		}
 	
-	for( int i = 0; i < inputmap->actions_state_count; ++i )	
-		{
-		if( inputmap->actions_state[ i ].action == action )
-			{
-			inputmap->actions_state[ i ] = inputmap->actions_state[ --inputmap->actions_state_count ];
-			break;
-			}
-		}
+	int index = inputmap->actions_lookup[ internal_inputmap_lookup_slot( inputmap, action ) ];
+	if( index < 0 ) return;
+
+	// the last state moves into the removed one's place, so mappings pointing at it need to follow
+	int last = --inputmap->actions_state_count;
+	inputmap->actions_state[ index ] = inputmap->actions_state[ last ];
+	for( int i = 0; i < inputmap->mappings_count; ++i )
+		if( inputmap->mappings[ i ].state_index == last ) inputmap->mappings[ i ].state_index = index;
+	internal_inputmap_rebuild_lookup( inputmap );
 	}
 
 
@@ -588,26 +655,8 @@ void inputmap_update_end( inputmap_t* inputmap )
 					} break;
 				}
 				
-			int state_index = -1;
-			for( int j = 0; j < inputmap->actions_state_count; ++j )				
-				if( inputmap->actions_state[ j ].action == mapping->action ) { state_index = j; break; }
-	
-			if( state_index < 0 )
-				{
-				if( inputmap->actions_state_count >= inputmap->actions_state_capacity )
-					{
-					inputmap->actions_state_capacity *= 2;
-					internal_inputmap_action_state_t* new_actions_state = (internal_inputmap_action_state_t*) INPUTMAP_MALLOC( 
-						inputmap->memctx, sizeof( *inputmap->actions_state ) * inputmap->actions_state_capacity );
-					INPUTMAP_ASSERT( new_actions_state, "Allocation failed." );
-					for( int j = 0; j < inputmap->actions_state_count; ++j ) new_actions_state[ j ] = inputmap->actions_state[ j ];
-					INPUTMAP_FREE( inputmap->memctx, inputmap->actions_state );
-					inputmap->actions_state = new_actions_state;
-					}
-				state_index = inputmap->actions_state_count++;
-				}
-			inputmap->actions_state[ state_index ].action = mapping->action;
-			inputmap->actions_state[ state_index ].state = value;
+			if( mapping->state_index < 0 ) mapping->state_index = internal_inputmap_state_index( inputmap, mapping->action );
+			inputmap->actions_state[ mapping->state_index ].state = value;
 			}
 		}
 	}
@@ -617,13 +666,8 @@ float inputmap_action( inputmap_t* inputmap, int action )
 	{
 	INPUTMAP_ASSERT( !inputmap->is_updating, "Inputmap update in progress." );
 	
-	for( int i = 0; i < inputmap->actions_state_count; ++i )
-		{
-		if( inputmap->actions_state[ i ].action == action )
-			return inputmap->actions_state[ i ].state;
-		}
-		
-	return 0.0f;
+	int index = inputmap->actions_lookup[ internal_inputmap_lookup_slot( inputmap, action ) ];
+	return index >= 0 ? inputmap->actions_state[ index ].state : 0.0f;
 	}
 
 
@@ -17,6 +17,20 @@ typedef struct log_t log_t;
 
 log_t* log_create( char const* filename, void* memctx );
 void log_destroy( log_t* log );
+
+// asynchronous mode: each calling thread gets its own lock-free ring of fixed size records, which a background thread 
+// writes out. a thread which finds its ring full either drops the message or waits for room, depending on the policy.
+// rings are handed back when their thread exits, and messages from more than max_threads live threads are dropped. 
+// pending text is kept per thread, and anything a thread leaves pending when it exits is written out. log_destroy is
+// only for shutdown, once the other threads are done logging: pending text of threads still running is discarded
+
+typedef enum log_full_policy_t { LOG_FULL_DROP, LOG_FULL_WAIT } log_full_policy_t;
+
+log_t* log_create_async( char const* filename, int max_threads, int records_per_thread, log_full_policy_t policy, 
+	void* memctx );
+void log_flush( log_t* log );
+int log_dropped( log_t* log );
+
 void log_print( log_t* log, char const* str, ... );
 void log_print_pending( log_t* log, char const* str, ... );
 void log_discard_pending( log_t* log );
@@ -41,6 +55,62 @@ int log_unmute( log_t* log );
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+	#if !defined( _WIN32_WINNT ) || _WIN32_WINNT < 0x0501 
+		#undef _WIN32_WINNT
+		#define _WIN32_WINNT 0x501// requires Windows XP minimum
+	#endif
+
+	#define _WINSOCKAPI_
+	#pragma warning( push )
+	#pragma warning( disable: 4668 ) // 'symbol' is not defined as a preprocessor macro, replacing with '0' for 'directives'
+	#pragma warning( disable: 4255 ) // 'function' : no function prototype given: converting '()' to '(void)'
+	#include <windows.h>
+	#pragma warning( pop )
+
+	#define LOG_ATOMIC_LOAD( ptr ) ( InterlockedCompareExchange( (ptr), 0, 0 ) )
+	#define LOG_ATOMIC_STORE( ptr, value ) ( (void) InterlockedExchange( (ptr), (value) ) )
+	#define LOG_ATOMIC_INC( ptr ) ( (void) InterlockedIncrement( (ptr) ) )
+	#define LOG_ATOMIC_CAS_PTR( ptr, expected, desired ) \
+		( InterlockedCompareExchangePointer( (ptr), (desired), (expected) ) == (expected) )
+	#define LOG_ATOMIC_LOAD_PTR( ptr ) ( InterlockedCompareExchangePointer( (ptr), 0, 0 ) )
+	#define LOG_ATOMIC_STORE_PTR( ptr, value ) ( (void) InterlockedExchangePointer( (ptr), (value) ) )
+	#define LOG_SLEEP( ms ) ( Sleep( (ms) ) )
+	#define LOG_YIELD() ( (void) SwitchToThread() )
+	typedef LONG log_atomic_t;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) || defined( __ANDROID__ )
+
+	#include <pthread.h>
+	#include <sched.h>
+	#include <time.h>
+
+	#define LOG_ATOMIC_LOAD( ptr ) ( __atomic_load_n( (ptr), __ATOMIC_ACQUIRE ) )
+	#define LOG_ATOMIC_STORE( ptr, value ) ( __atomic_store_n( (ptr), (value), __ATOMIC_RELEASE ) )
+	#define LOG_ATOMIC_INC( ptr ) ( (void) __atomic_add_fetch( (ptr), 1, __ATOMIC_RELAXED ) )
+	#define LOG_ATOMIC_CAS_PTR( ptr, expected, desired ) \
+		( __sync_bool_compare_and_swap( (ptr), (expected), (desired) ) )
+	#define LOG_ATOMIC_LOAD_PTR( ptr ) ( __atomic_load_n( (ptr), __ATOMIC_ACQUIRE ) )
+	#define LOG_ATOMIC_STORE_PTR( ptr, value ) ( __atomic_store_n( (ptr), (value), __ATOMIC_RELEASE ) )
+	#define LOG_THREAD_ID() ( (void*)(uintptr_t) pthread_self() )
+	#define LOG_SLEEP( ms ) do { struct timespec log_ts = { 0, (ms) * 1000000L }; nanosleep( &log_ts, NULL ); } while( 0 )
+	#define LOG_YIELD() ( (void) sched_yield() )
+	typedef long log_atomic_t;
+
+#else 
+	#error Unknown platform.
+#endif
+
+#ifndef LOG_RECORD_SIZE
+	#define LOG_RECORD_SIZE 256
+#endif
+
+#ifndef LOG_ASYNC_INTERVAL_MS
+	#define LOG_ASYNC_INTERVAL_MS 5
+#endif
 
 #ifndef LOG_MALLOC
 	#define _CRT_NONSTDC_NO_DEPRECATE 
@@ -50,32 +120,208 @@ int log_unmute( log_t* log );
 	#define LOG_FREE( ctx, ptr ) ( free( ptr ) )
 #endif
 
-struct log_t
+typedef struct log_internal_record_t
+	{
+	int length;
+	char text[ LOG_RECORD_SIZE - sizeof( int ) ];
+	} log_internal_record_t;
+
+
+// text printed with log_print_pending, waiting to be committed or discarded
+typedef struct log_internal_text_t
 	{
-	void* memctx;
 	char* data;
 	size_t capacity;
 	size_t size;
 	size_t pending_point;
+	} log_internal_text_t;
+
+
+// single producer, single consumer ring. head is only written by the owning thread, tail only by whoever holds the
+// consumer lock. the owning thread also keeps its pending text here, so threads never touch each other's text
+typedef struct log_internal_ring_t
+	{
+	void* volatile owner; // on windows the handle of the owning thread, elsewhere its id. null when the ring is free
+	log_atomic_t volatile head;
+	log_atomic_t volatile tail;
+	log_internal_record_t* records;
+	log_internal_text_t text;
+	log_t* log;
+	} log_internal_ring_t;
+
+
+struct log_t
+	{
+	void* memctx;
+	log_internal_text_t text;
 	int muted;
 	FILE* fp;
+
+	int async;
+	log_full_policy_t policy;
+	int ring_count;
+	int ring_capacity;
+	log_internal_ring_t* rings;
+	log_atomic_t volatile dropped;
+	int dropped_reported;
+	log_atomic_t volatile exit_flag;
+	#ifdef _WIN32
+		DWORD ring_tls;
+		CRITICAL_SECTION consumer_lock;
+		HANDLE thread;
+	#else
+		pthread_key_t ring_tls;
+		pthread_mutex_t consumer_lock;
+		pthread_t thread;
+	#endif
 	};
 
 
+static void log_internal_text_init( log_internal_text_t* const text )
+	{
+	text->data = 0;
+	text->capacity = 0;
+	text->size = 0;
+	text->pending_point = ~(size_t) 0;
+	}
+
+
 log_t* log_create( char const* const filename, void* memctx )
 	{
 	log_t* log = (log_t*) LOG_MALLOC( memctx, sizeof( log_t ) );
 	log->memctx = memctx;
-	log->data = 0;
-	log->capacity = 0;
-	log->size = 0;
-	log->pending_point = ~(size_t) 0;
+	log_internal_text_init( &log->text );
 	log->muted = 0;
 	if( filename )
 		log->fp = fopen( filename, "w" );
 	else
 		log->fp = 0;
+	log->async = 0;
+	log->rings = 0;
+
+	return log;
+	}
+
+
+static void log_internal_write( log_t* const log, char const* const text, size_t const length )
+	{
+	fwrite( text, 1, length, stdout );
+	if( log->fp ) fwrite( text, 1, length, log->fp );
+	}
+
+
+// writes out everything currently in the rings. returns the number of records written
+static int log_internal_drain( log_t* const log )
+	{
+	int written = 0;
+	#ifdef _WIN32
+		EnterCriticalSection( &log->consumer_lock );
+	#else
+		pthread_mutex_lock( &log->consumer_lock );
+	#endif
+
+	for( int i = 0; i < log->ring_count; ++i )
+		{
+		log_internal_ring_t* ring = &log->rings[ i ];
+		unsigned long tail = (unsigned long) ring->tail;
+		unsigned long head = (unsigned long) LOG_ATOMIC_LOAD( &ring->head );
+		while( tail != head )
+			{
+			log_internal_record_t* record = &ring->records[ tail % (unsigned long) log->ring_capacity ];
+			log_internal_write( log, record->text, (size_t) record->length );
+			++tail;
+			++written;
+			}
+		LOG_ATOMIC_STORE( &ring->tail, (log_atomic_t) tail );
+		}
+
+	int dropped = (int) LOG_ATOMIC_LOAD( &log->dropped );
+	if( dropped != log->dropped_reported )
+		{
+		char message[ 64 ];
+		int length = sprintf( message, "[log: %d messages dropped]\n", dropped - log->dropped_reported );
+		log_internal_write( log, message, (size_t) length );
+		log->dropped_reported = dropped;
+		++written;
+		}
+
+	if( written > 0 )
+		{
+		fflush( stdout );
+		if( log->fp ) fflush( log->fp );
+		}
+
+	#ifdef _WIN32
+		LeaveCriticalSection( &log->consumer_lock );
+	#else
+		pthread_mutex_unlock( &log->consumer_lock );
+	#endif
+	return written;
+	}
+
 
+#ifdef _WIN32
+	static DWORD WINAPI log_internal_thread_proc( LPVOID user_data )
+#else
+	static void* log_internal_thread_proc( void* user_data )
+#endif
+	{
+	log_t* log = (log_t*) user_data;
+	while( !LOG_ATOMIC_LOAD( &log->exit_flag ) )
+		{
+		if( log_internal_drain( log ) == 0 ) LOG_SLEEP( LOG_ASYNC_INTERVAL_MS );
+		}
+	return 0;
+	}
+
+
+static void log_internal_commit_ring( log_internal_ring_t* const ring );
+
+#ifndef _WIN32
+	// called on thread exit, by the exiting thread, so its ring can go to a new thread
+	static void log_internal_release_ring( void* value )
+		{
+		log_internal_ring_t* ring = (log_internal_ring_t*) value;
+		log_internal_commit_ring( ring );
+		LOG_ATOMIC_STORE_PTR( &ring->owner, 0 );
+		}
+#endif
+
+
+log_t* log_create_async( char const* filename, int max_threads, int records_per_thread, log_full_policy_t policy,
+	void* memctx )
+	{
+	log_t* log = log_create( filename, memctx );
+	log->async = 1;
+	log->policy = policy;
+	log->ring_count = max_threads;
+	log->ring_capacity = records_per_thread;
+	log->rings = (log_internal_ring_t*) LOG_MALLOC( memctx, sizeof( log_internal_ring_t ) * max_threads );
+	for( int i = 0; i < max_threads; ++i )
+		{
+		log->rings[ i ].owner = 0;
+		log->rings[ i ].head = 0;
+		log->rings[ i ].tail = 0;
+		log->rings[ i ].records = (log_internal_record_t*) LOG_MALLOC( memctx,
+			sizeof( log_internal_record_t ) * records_per_thread );
+		// touch the memory up front, so the first messages from a time critical thread don't take page faults
+		memset( log->rings[ i ].records, 0, sizeof( log_internal_record_t ) * records_per_thread );
+		log_internal_text_init( &log->rings[ i ].text );
+		log->rings[ i ].log = log;
+		}
+	log->dropped = 0;
+	log->dropped_reported = 0;
+	log->exit_flag = 0;
+
+	#ifdef _WIN32
+		log->ring_tls = TlsAlloc();
+		InitializeCriticalSectionAndSpinCount( &log->consumer_lock, 32 );
+		log->thread = CreateThread( NULL, 0U, log_internal_thread_proc, log, 0, NULL );
+	#else
+		pthread_key_create( &log->ring_tls, log_internal_release_ring );
+		pthread_mutex_init( &log->consumer_lock, NULL );
+		pthread_create( &log->thread, NULL, log_internal_thread_proc, log );
+	#endif
 	return log;
 	}
 
@@ -83,33 +329,174 @@ log_t* log_create( char const* const filename, void* memctx )
 void log_destroy( log_t* const log )
 	{
 	log_commit_pending( log );
+	if( log->async )
+		{
+		// text left pending by threads which have exited but not yet had their rings taken over. the text of threads 
+		// which are still running is theirs to touch, so it is discarded rather than committed from here
+		for( int i = 0; i < log->ring_count; ++i )
+			{
+			log_internal_ring_t* ring = &log->rings[ i ];
+			void* owner = LOG_ATOMIC_LOAD_PTR( &ring->owner );
+			#ifdef _WIN32
+				int exited = !owner || WaitForSingleObject( (HANDLE) owner, 0 ) == WAIT_OBJECT_0;
+			#else
+				int exited = !owner; // exiting threads hand their ring back, after committing its text
+			#endif
+			if( exited && ring->text.size > 0 ) log_internal_commit_ring( ring );
+			}
+
+		LOG_ATOMIC_STORE( &log->exit_flag, 1 );
+		#ifdef _WIN32
+			WaitForSingleObject( log->thread, INFINITE );
+			CloseHandle( log->thread );
+		#else
+			pthread_join( log->thread, NULL );
+		#endif
+		log_internal_drain( log );
+		#ifdef _WIN32
+			DeleteCriticalSection( &log->consumer_lock );
+			TlsFree( log->ring_tls );
+		#else
+			pthread_mutex_destroy( &log->consumer_lock );
+			pthread_key_delete( log->ring_tls );
+		#endif
+		for( int i = 0; i < log->ring_count; ++i )
+			{
+			#ifdef _WIN32
+				if( log->rings[ i ].owner ) CloseHandle( (HANDLE) log->rings[ i ].owner );
+			#endif
+			if( log->rings[ i ].text.data ) LOG_FREE( log->memctx, log->rings[ i ].text.data );
+			LOG_FREE( log->memctx, log->rings[ i ].records );
+			}
+		LOG_FREE( log->memctx, log->rings );
+		}
 	if( log->fp ) fclose( log->fp );
-	if( log->data ) LOG_FREE( log->memctx, log->data );
+	if( log->text.data ) LOG_FREE( log->memctx, log->text.data );
 	LOG_FREE( log->memctx, log );
 	}
 
 
-static void alloc_data( log_t* const log, int const count )
+static void alloc_data( log_t* const log, log_internal_text_t* const text, int const count )
 	{
-	if( log->data )
+	(void) log;
+	if( text->data )
 		{
-		while( count >= (int) ( log->capacity - log->size ) )
+		while( count >= (int) ( text->capacity - text->size ) )
 			{
-			log->capacity *= 2; 
+			text->capacity *= 2;
 			}
-		char* new_data = (char*) LOG_MALLOC( log->memctx, log->capacity );
-		memcpy( new_data, log->data, log->size + 1 );
-		LOG_FREE( log->memctx, log->data );
-		log->data = new_data;
+		char* new_data = (char*) LOG_MALLOC( log->memctx, text->capacity );
+		memcpy( new_data, text->data, text->size + 1 );
+		LOG_FREE( log->memctx, text->data );
+		text->data = new_data;
 		}
 	else
 		{
-		log->capacity = 256;
-		while( count >= (int) ( log->capacity - log->size ) )
+		text->capacity = 256;
+		while( count >= (int) ( text->capacity - text->size ) )
+			{
+			text->capacity *= 2;
+			}
+		text->data = (char*) LOG_MALLOC( log->memctx, text->capacity );
+		}
+	}
+
+
+// finds the ring owned by the calling thread, claiming a free one the first time a thread logs. returns null if there
+// are already max_threads live threads holding rings
+static log_internal_ring_t* log_internal_thread_ring( log_t* const log )
+	{
+	#ifdef _WIN32
+		log_internal_ring_t* ring = (log_internal_ring_t*) TlsGetValue( log->ring_tls );
+		if( ring ) return ring;
+		void* owner = (void*) OpenThread( SYNCHRONIZE, FALSE, GetCurrentThreadId() );
+		if( !owner ) return 0;
+	#else
+		log_internal_ring_t* ring = (log_internal_ring_t*) pthread_getspecific( log->ring_tls );
+		if( ring ) return ring;
+		void* owner = LOG_THREAD_ID();
+	#endif
+
+	for( int i = 0; i < log->ring_count && !ring; ++i )
+		{
+		if( !LOG_ATOMIC_LOAD_PTR( &log->rings[ i ].owner ) && LOG_ATOMIC_CAS_PTR( &log->rings[ i ].owner, (void*) 0, owner ) )
+			ring = &log->rings[ i ];
+		}
+
+	#ifdef _WIN32
+		// there's no thread exit callback to hand rings back (fls callbacks need vista), so take over the ring of a
+		// thread which has exited instead, along with any text it left pending
+		for( int i = 0; i < log->ring_count && !ring; ++i )
 			{
-			log->capacity *= 2; 
+			void* previous = LOG_ATOMIC_LOAD_PTR( &log->rings[ i ].owner );
+			if( previous && WaitForSingleObject( (HANDLE) previous, 0 ) == WAIT_OBJECT_0 &&
+				LOG_ATOMIC_CAS_PTR( &log->rings[ i ].owner, previous, owner ) )
+				{
+				CloseHandle( (HANDLE) previous );
+				ring = &log->rings[ i ];
+				log_internal_commit_ring( ring );
+				}
 			}
-		log->data = (char*) LOG_MALLOC( log->memctx, log->capacity );
+		if( !ring )
+			{
+			CloseHandle( (HANDLE) owner );
+			return 0;
+			}
+		TlsSetValue( log->ring_tls, ring );
+	#else
+		if( !ring ) return 0;
+		pthread_setspecific( log->ring_tls, ring );
+	#endif
+	return ring;
+	}
+
+
+// reserves the next record in the calling thread's ring, or returns null if the message should be dropped
+static log_internal_record_t* log_internal_reserve( log_t* const log, log_internal_ring_t* const ring )
+	{
+	if( !ring )
+		{
+		LOG_ATOMIC_INC( &log->dropped );
+		return 0;
+		}
+
+	unsigned long head = (unsigned long) ring->head;
+	while( head - (unsigned long) LOG_ATOMIC_LOAD( &ring->tail ) >= (unsigned long) log->ring_capacity )
+		{
+		if( log->policy == LOG_FULL_DROP )
+			{
+			LOG_ATOMIC_INC( &log->dropped );
+			return 0;
+			}
+		LOG_YIELD();
+		}
+	return &ring->records[ head % (unsigned long) log->ring_capacity ];
+	}
+
+
+static void log_internal_publish( log_internal_ring_t* const ring )
+	{
+	LOG_ATOMIC_STORE( &ring->head, (log_atomic_t)( (unsigned long) ring->head + 1 ) );
+	}
+
+
+// queues the ring's pending text, split over as many records as needed
+static void log_internal_commit_ring( log_internal_ring_t* const ring )
+	{
+	char const* text = ring->text.data;
+	size_t length = ring->text.size;
+	ring->text.size = 0;
+	ring->text.pending_point = ~(size_t) 0;
+	while( length > 0 )
+		{
+		log_internal_record_t* record = log_internal_reserve( ring->log, ring );
+		if( !record ) return;
+		size_t count = length < sizeof( record->text ) ? length : sizeof( record->text );
+		memcpy( record->text, text, count );
+		record->length = (int) count;
+		log_internal_publish( ring );
+		text += count;
+		length -= count;
 		}
 	}
 
@@ -119,74 +506,136 @@ void log_print( log_t* const log, char const* const str, ... )
 	if( !log ) return;
 	if( log->muted ) return;
 
-	log->pending_point = ~(size_t) 0;
+	if( log->async )
+		{
+		// formatting happens here, straight into the record, as the arguments can't outlive the call. anything which
+		// doesn't fit in a single record is cut off
+		log_internal_ring_t* ring = log_internal_thread_ring( log );
+		if( ring ) log_internal_commit_ring( ring );
+		log_internal_record_t* record = log_internal_reserve( log, ring );
+		if( !record ) return;
+		va_list args;
+		va_start( args, str );
+		int count = _vsnprintf( record->text, sizeof( record->text ), str, args );
+		va_end( args );
+		if( count < 0 || count > (int) sizeof( record->text ) ) count = (int) sizeof( record->text );
+		record->length = count;
+		log_internal_publish( ring );
+		return;
+		}
+
+	log_internal_text_t* text = &log->text;
+	text->pending_point = ~(size_t) 0;
 	va_list args;
 	va_start (args, str);
-	int count = _vsnprintf( log->data + log->size, log->capacity - log->size, str, args );
+	int count = _vsnprintf( text->data + text->size, text->capacity - text->size, str, args );
 	va_end (args);
-	if( count >= (int) ( log->capacity - log->size ) )
+	if( count >= (int) ( text->capacity - text->size ) )
 		{
-		alloc_data( log, count );
+		alloc_data( log, text, count );
 		va_start (args, str);
-		count = _vsnprintf( log->data + log->size, log->capacity - log->size, str, args );
+		count = _vsnprintf( text->data + text->size, text->capacity - text->size, str, args );
 		va_end (args);
 		}
-	log->size += count;
+	text->size += count;
 	log_commit_pending( log );
 	}
 
 
+// in async mode, each thread has its own pending text
+static log_internal_text_t* log_internal_pending_text( log_t* const log )
+	{
+	if( !log->async ) return &log->text;
+	log_internal_ring_t* ring = log_internal_thread_ring( log );
+	return ring ? &ring->text : 0;
+	}
+
+
 void log_print_pending( log_t* const log, char const* const str, ... )
 	{
 	if( log->muted ) return;
-	
-	if( log->pending_point > log->size ) log->pending_point = log->size;
-		
+
+	log_internal_text_t* text = log_internal_pending_text( log );
+	if( !text )
+		{
+		LOG_ATOMIC_INC( &log->dropped );
+		return;
+		}
+
+	if( text->pending_point > text->size ) text->pending_point = text->size;
+
 	va_list args;
 	va_start (args, str);
-	int count = _vsnprintf( log->data + log->size, log->capacity - log->size, str, args );
+	int count = _vsnprintf( text->data + text->size, text->capacity - text->size, str, args );
 	va_end (args);
-	if( count >= (int) ( log->capacity - log->size ) )
+	if( count >= (int) ( text->capacity - text->size ) )
 		{
-		alloc_data( log, count );
+		alloc_data( log, text, count );
 		va_start (args, str);
-		count = _vsnprintf( log->data + log->size, log->capacity - log->size, str, args );
+		count = _vsnprintf( text->data + text->size, text->capacity - text->size, str, args );
 		va_end (args);
 		}
-	log->size += count;
+	text->size += count;
 	}
 
 
 void log_discard_pending( log_t* const log )
 	{
 	if( log->muted ) return;
-	
-	if( log->pending_point != ~(size_t) 0 ) 
-		log->size = log->pending_point;
-	
-	log->pending_point = ~(size_t) 0;
+
+	log_internal_text_t* text = log_internal_pending_text( log );
+	if( !text ) return;
+
+	if( text->pending_point != ~(size_t) 0 )
+		text->size = text->pending_point;
+
+	text->pending_point = ~(size_t) 0;
 	}
 
 
 void log_commit_pending( log_t* const log )
 	{
-	log->pending_point = ~(size_t) 0;
+	if( log->async )
+		{
+		if( log->muted ) return;
+		log_internal_ring_t* ring = log_internal_thread_ring( log );
+		if( ring ) log_internal_commit_ring( ring );
+		return;
+		}
+
+	log->text.pending_point = ~(size_t) 0;
 
 	if( log->muted ) return;
 
-	if( log->data )
+	if( log->text.data )
 		{
-		fprintf( stdout, "%s", log->data );
+		fprintf( stdout, "%s", log->text.data );
 		if( log->fp )
 			{
-			fprintf( log->fp, "%s", log->data );
+			fprintf( log->fp, "%s", log->text.data );
 			}
-		log->data[ 0 ] = 0;
+		log->text.data[ 0 ] = 0;
 		}
-	fflush( stdout ); 
+	fflush( stdout );
 	if( log->fp )
-		fflush( log->fp ); 
-	log->size = 0;	
+		fflush( log->fp );
+	log->text.size = 0;
+	}
+
+
+// writes out everything logged so far, from the calling thread. safe to call from crash handlers, as long as the
+// background thread isn't the one that crashed while writing
+void log_flush( log_t* log )
+	{
+	log_commit_pending( log );
+	if( log->async ) log_internal_drain( log );
+	}
+
+
+int log_dropped( log_t* log )
+	{
+	if( log->async ) return (int) LOG_ATOMIC_LOAD( &log->dropped );
+	return 0;
 	}
 
 
@@ -46,6 +46,7 @@ template< typename T > struct mempool final
 			{
 			T item;
 			mempool<T>* owner;
+			int block; // index of the block the item belongs to, so it can be freed without searching
 			};
 		struct block_t final
 			{
@@ -57,6 +58,11 @@ template< typename T > struct mempool final
 		block_t* blocks_;
 		int blocks_capacity_;
 		int blocks_count_;
+		int* sorted_blocks_; // block indices ordered by address, for looking up which block a pointer is in
+		int free_block_; // most recently freed from, tried first when allocating
+
+		int find_block( T* item ) const;
+		void release( item_t* entry );
 	};
 
 } /* namespace mempool_ns */
@@ -103,6 +109,9 @@ template< typename T > mempool_ns::mempool<T>::mempool( int initial_capacity, vo
 	blocks_capacity_( 64 )
 	{
 	blocks_ = (block_t*) internal::mempool_alloc( memctx, sizeof( block_t ) * blocks_capacity_ );
+	sorted_blocks_ = (int*) internal::mempool_alloc( memctx, sizeof( int ) * blocks_capacity_ );
+	sorted_blocks_[ 0 ] = 0;
+	free_block_ = 0;
 	block_t* initial_block = &blocks_[ blocks_count_++ ];
 	initial_block->freelist = -1;
 	initial_block->items_count = 0;
@@ -124,44 +133,78 @@ mempool_ns::mempool<T>::~mempool()
 			}
 		internal::mempool_free( memctx_, block->items );
 		}
+	internal::mempool_free( memctx_, sorted_blocks_ );
 	internal::mempool_free( memctx_, blocks_ );
 	}
 
 
+// binary search of the block address ranges, returns the block index or -1 if the pointer is not from this pool
 template< typename T > 
-bool mempool_ns::mempool<T>::contains( T* item )
+int mempool_ns::mempool<T>::find_block( T* item ) const
 	{
 	uintptr_t item_ptr = (uintptr_t) item;
-	for( int i = 0; i < blocks_count_; ++i )
+	int low = 0;
+	int high = blocks_count_ - 1;
+	while( low <= high )
 		{
-		block_t* block = &blocks_[ i ];
+		int mid = ( low + high ) / 2;
+		block_t const* block = &blocks_[ sorted_blocks_[ mid ] ];
 		uintptr_t block_begin = (uintptr_t) block->items;
 		uintptr_t block_end = block_begin + block->items_capacity * sizeof( item_t );
-		if( item_ptr >= block_begin && item_ptr < block_end )
-			return true;
+		if( item_ptr < block_begin )
+			high = mid - 1;
+		else if( item_ptr >= block_end )
+			low = mid + 1;
+		else
+			return sorted_blocks_[ mid ];
 		}
+	return -1;
+	}
+
+
+template< typename T > 
+void mempool_ns::mempool<T>::release( item_t* entry )
+	{
+	block_t* block = &blocks_[ entry->block ];
+	int item_index = (int)( entry - block->items );
+	entry->owner = 0;
+	*( (int*) entry ) = block->freelist;
+	block->freelist = item_index;
+	free_block_ = entry->block;
+	}
 
-	return false;
+
+template< typename T > 
+bool mempool_ns::mempool<T>::contains( T* item )
+	{
+	return find_block( item ) >= 0;
 	}
 
 
 template< typename T > 
 T* mempool_ns::mempool<T>::allocate()
 	{
-	for( int i = blocks_count_ - 1; i >= 0; --i )
+	// try the block most recently freed from first, and only search the others if it is full
+	for( int i = -1; i < blocks_count_; ++i )
 		{
-		block_t* block = &blocks_[ i ];
+		int const block_index = i < 0 ? free_block_ : blocks_count_ - 1 - i;
+		if( i >= 0 && block_index == free_block_ ) continue;
+		block_t* block = &blocks_[ block_index ];
 		if( block->freelist >= 0 )
 			{
 			int item_index = block->freelist;
 			block->freelist = *( (int*) &block->items[ item_index ] );
 			block->items[ item_index ].owner = this;
+			block->items[ item_index ].block = block_index;
+			free_block_ = block_index;
 			return &block->items[ item_index ].item;
 			}
 		else if( block->items_count < block->items_capacity )
 			{
 			int item_index = block->items_count++;
 			block->items[ item_index ].owner = this;
+			block->items[ item_index ].block = block_index;
+			free_block_ = block_index;
 			return &block->items[ item_index ].item;
 			}
 		}
@@ -173,16 +216,33 @@ T* mempool_ns::mempool<T>::allocate()
 		internal::mempool_memcpy( new_blocks, blocks_, sizeof( block_t ) * blocks_count_ );
 		internal::mempool_free( memctx_, blocks_ );
 		blocks_ = new_blocks;
+		int* new_sorted_blocks = (int*) internal::mempool_alloc( memctx_, sizeof( int ) * blocks_capacity_ );
+		internal::mempool_memcpy( new_sorted_blocks, sorted_blocks_, sizeof( int ) * blocks_count_ );
+		internal::mempool_free( memctx_, sorted_blocks_ );
+		sorted_blocks_ = new_sorted_blocks;
 		}
 
-	block_t* block = &blocks_[ blocks_count_++ ];
+	int const block_index = blocks_count_++;
+	block_t* block = &blocks_[ block_index ];
 	block->freelist = -1;
 	block->items_count = 1;
 	block->items_capacity = next_capacity_;
 	block->items = (item_t*) internal::mempool_alloc( memctx_, sizeof( item_t ) * block->items_capacity );    
 	memset( block->items, 0, sizeof( item_t ) * block->items_capacity );
 	next_capacity_ *= 2;
+
+	// insert the new block in address order
+	int pos = block_index;
+	while( pos > 0 && (uintptr_t) blocks_[ sorted_blocks_[ pos - 1 ] ].items > (uintptr_t) block->items )
+		{
+		sorted_blocks_[ pos ] = sorted_blocks_[ pos - 1 ];
+		--pos;
+		}
+	sorted_blocks_[ pos ] = block_index;
+
 	block->items[ 0 ].owner = this;
+	block->items[ 0 ].block = block_index;
+	free_block_ = block_index;
 	return &block->items[ 0 ].item;
 	}
 
@@ -190,26 +250,10 @@ T* mempool_ns::mempool<T>::allocate()
 template< typename T > 
 void mempool_ns::mempool<T>::deallocate( T* item )
 	{   
-	uintptr_t item_ptr = (uintptr_t) item;
-	for( int i = 0; i < blocks_count_; ++i )
-		{
-		block_t* block = &blocks_[ i ];
-		uintptr_t block_begin = (uintptr_t) block->items;
-		uintptr_t block_end = block_begin + block->items_capacity * sizeof( item_t );
-		if( item_ptr >= block_begin && item_ptr < block_end )
-			{
-			int item_index = (int)( ( item_ptr - block_begin ) / sizeof( item_t ) );
-			MEMPOOL_ASSERT( block->items[ item_index ].owner, "Attempt to destroy an item which is not currently allocated." );
-			if( block->items[ item_index ].owner )
-				{
-				block->items[ item_index ].owner = 0;
-				*( (int*) &block->items[ item_index ] ) = block->freelist;
-				block->freelist = item_index;
-				}
-			return;
-			}
-		}
-	MEMPOOL_ASSERT( false, "Attempt to destroy an item not allocated from this mempool." );
+	MEMPOOL_ASSERT( contains( item ), "Attempt to destroy an item not allocated from this mempool." );
+	item_t* entry = (item_t*) item;
+	MEMPOOL_ASSERT( entry->owner == this, "Attempt to destroy an item which is not currently allocated." );
+	if( entry->owner == this ) release( entry );
 	}
 
 	
@@ -230,6 +274,7 @@ void mempool_ns::mempool<T>::clear()
 		block->freelist = -1;
 		block->items_count = 0;
 		}
+	free_block_ = 0;
 	}
 
 
@@ -317,27 +362,14 @@ T* mempool_ns::mempool<T>::create( P0 p0, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6
 template< typename T > 
 void mempool_ns::mempool<T>::destroy( T* item )
 	{   
-	uintptr_t item_ptr = (uintptr_t) item;
-	for( int i = 0; i < blocks_count_; ++i )
+	MEMPOOL_ASSERT( contains( item ), "Attempt to destroy an item not allocated from this mempool." );
+	item_t* entry = (item_t*) item;
+	MEMPOOL_ASSERT( entry->owner == this, "Attempt to destroy an item which is not currently allocated." );
+	if( entry->owner == this )
 		{
-		block_t* block = &blocks_[ i ];
-		uintptr_t block_begin = (uintptr_t) block->items;
-		uintptr_t block_end = block_begin + block->items_capacity * sizeof( item_t );
-		if( item_ptr >= block_begin && item_ptr < block_end )
-			{
-			int item_index = (int)( ( item_ptr - block_begin ) / sizeof( item_t ) );
-			MEMPOOL_ASSERT( block->items[ item_index ].owner, "Attempt to destroy an item which is not currently allocated." );
-			if( block->items[ item_index ].owner )
-				{
-				block->items[ item_index ].item.~T();
-				block->items[ item_index ].owner = 0;
-				*( (int*) &block->items[ item_index ] ) = block->freelist;
-				block->freelist = item_index;
-				}
-			return;
-			}
+		entry->item.~T();
+		release( entry );
 		}
-	MEMPOOL_ASSERT( false, "Attempt to destroy an item not allocated from this mempool." );
 	}
 
 #endif /* mempool_impl */
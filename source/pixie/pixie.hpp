@@ -64,9 +64,12 @@ char const* format_assert_message( char const* format, ... );
 #define RESOURCES_ASSERT PIXIE_ASSERT
 
 #define DICTIONARY_U64 pixie::u64
+#define SORT_U64 pixie::u64
 #define STRPOOL_U64 pixie::u64
 #define TWEEN_U64 pixie::u64
 
+#define REFCOUNT_THREAD_SAFE // refs are shared with the bitmap decoder threads
+
 #include "array.hpp"
 #include "dictionary.hpp"
 #include "gamestate.hpp"
@@ -81,7 +84,14 @@ char const* format_assert_message( char const* format, ... );
 #include "tween.hpp"
 #include "vecmath.hpp"
 
-namespace pixie { namespace internal { struct PIXIE_STRING_POOL; struct PIXIE_STRING_ID_POOL; struct internals_t; void resize_screen(); } } 
+namespace pixie { namespace internal { struct PIXIE_STRING_POOL; struct PIXIE_STRING_ID_POOL; struct internals_t; struct bitmap_loader; void resize_screen(); } } 
+
+// strings, refs and resources only hold handles and pointers to other objects, so arrays can move them with memcpy
+namespace array_ns {
+template< typename POOL > struct is_relocatable< strpool::string_type<POOL> > { enum { value = 1 }; };
+template< typename T > struct is_relocatable< refcount::ref<T> > { enum { value = 1 }; };
+template< typename T > struct is_relocatable< resources::resource<T> > { enum { value = 1 }; };
+} /* namespace array_ns */
 
 namespace strpool { namespace internal {
 template<> string_pool& pool_instance<pixie::internal::PIXIE_STRING_POOL>( bool destroy );
@@ -96,7 +106,7 @@ using strpool::str; using strpool::trim; using strpool::ltrim; using strpool::rt
 using strpool::right; using strpool::mid; using strpool::instr; using strpool::any; using strpool::upper; 
 using strpool::lower; using strpool::val; using strpool::integer; using strpool::space; using strpool::flip; 
 using strpool::repeat; using strpool::chr; using strpool::asc; using strpool::len; using strpool::format;
-using tween_ns::tweener; using refcount::ref; using tween_ns::make_property; using tween_ns::property;
+using tween_ns::tweener; using refcount::ref; using resources::async; using tween_ns::make_property; using tween_ns::property;
 using vecmath::float2; using vecmath::float3; using vecmath::float4; using vecmath::float2x2;
 using vecmath::float2x3; using vecmath::float3x2; using vecmath::float3x3; using vecmath::float2x4; 
 using vecmath::float3x4; using vecmath::float4x2; using vecmath::float4x3; using vecmath::float4x4; using vecmath::abs; 
@@ -122,8 +132,16 @@ struct async_handle final { void* thread_handle; };
 async_handle run_async( game_main_func_t game_main, void* memctx = 0 );
 int join_async( async_handle handle );
 
+// lets threads which pixie didn't start, like loader or job threads, create and release strings. call share_strings on 
+// the update thread, pass the result to use_strings on the other thread, and call use_strings( 0 ) when it is done
+void* share_strings();
+void use_strings( void* shared );
+
 void execute_frame();
 bool is_running();
+
+void* frame_alloc( size_t size ); // valid until the next execute_frame call, and never needs to be freed (16 byte aligned)
+int frame_allocations(); // number of heap allocations made during the last frame, by all threads (not just the game)
 void wait( int jiffys );
 void wait( float time );
 void wait_key();
@@ -186,6 +204,10 @@ template< typename T > void unpin_resource( resource< T > const& res, string_id
 void unpin_resource( string_id group = "" );
 void unpin_resources();
 
+typedef resources::resource_system::cache_stats_t resource_cache_stats_t;
+void resource_cache_budget( size_t bytes );
+resource_cache_stats_t resource_cache_stats();
+
 template< typename T > ref<T> new_ref();
 template< typename T, typename P0 > ref<T> new_ref( P0 );
 template< typename T, typename P0, typename P1 > ref<T> new_ref( P0, P1 );
@@ -252,6 +274,10 @@ enum gamepadbutton_id
 
 void mount_resources( string const& path );
 void mount_resources( string const& primary, string const& secondary );
+void mount_pack( string const& filename );
+
+void watch_resource_updates( string const& filename );
+int resource_updates( array<string>* paths );
 
 enum day_id { DAY_MONDAY, DAY_TUESDAY, DAY_WEDNESDAY, DAY_THURSDAY, DAY_FRIDAY, DAY_SATURDAY, DAY_SUNDAY, };
 struct datetime final { int year; int month; int day; int hour; int minute; int second; day_id day_of_week; };
@@ -265,7 +291,15 @@ int clamp( int x, int min_val, int max_val );
 i64 time();
 int clock();
 float delta_time();
+
+enum mem_tag { MEM_TAG_GENERAL, MEM_TAG_BITMAP, MEM_TAG_AUDIO, MEM_TAG_RESOURCE, MEM_TAG_STRINGS, MEM_TAG_CONTAINERS, 
+	MEM_TAG_USER, MEM_TAG_COUNT = MEM_TAG_USER + 8, }; // MEM_TAG_USER + 0..7 are free for the application to use
+struct mem_usage final { i64 current; i64 peak; int count; };
+struct mem_snapshot final { mem_usage total; mem_usage tags[ MEM_TAG_COUNT ]; };
 size_t mem_used( int* alloc_count = 0, size_t* peak_use = 0 );
+size_t mem_used( mem_tag tag, int* alloc_count = 0, size_t* peak_use = 0 );
+mem_snapshot mem_take_snapshot();
+mem_snapshot mem_diff( mem_snapshot const& before, mem_snapshot const& after );
 void stdprint( string format, ... );
 
 void title( string const& text );
@@ -364,7 +398,7 @@ bool file_exists( string const& filename );
 struct dir_info final { string filename; bool is_folder; size_t size; };
 array<dir_info> dir( string const& path, bool recursive = false );
 
-void* mem_alloc( size_t size );
+void* mem_alloc( size_t size, int tag = MEM_TAG_USER );
 void mem_free( void* ptr );
 
 struct binary { size_t size; void* data; };
@@ -402,6 +436,9 @@ struct binary_reader final
 	int read( double* value, int count = 1 );
 	int read( bool* value, int count = 1 ); 
 	
+	size_t read_bytes( void* data, size_t size );
+	void const* view( size_t size ); // points straight into the binary, or is null if there's not enough data left
+	
 	private:
 		ref<binary> bin_;
 		u8 internals_[ 32 ];
@@ -435,11 +472,25 @@ struct binary_writer final
 	int write( double const* value, int count = 1 );
 	int write( bool const* value, int count = 1 );  
 	
+	size_t write_bytes( void const* data, size_t size );
+	
 	private:
 		ref<binary> bin_;
 		bool resize_;
 		u8 internals_[ 48 ];
 	};
+
+
+// snapshots of game state, for quick-save and rewind. registered memory is restored by copying its bytes, so it should 
+// hold plain data - pointers get their old values back, but the memory they point to is not captured
+void snapshot_region( void* data, size_t size );
+template< typename T > void snapshot_system(); // registers the object added with add_system<T>
+void snapshot_remove( void const* data );
+void snapshot_history( int max_frames, size_t max_bytes ); // capture a delta compressed history at the start of each frame
+int snapshot_frames(); // how many frames back snapshot_rewind can go
+int snapshot_rewind( int frames = 1 ); // 1 restores the state captured at the start of the current frame
+bool snapshot_save( binary_writer* writer ); 
+bool snapshot_load( binary_reader* reader ); // fails if the registered regions don't match the ones that were saved
 	
 
 typedef dictionary<string_id, string> ini_section;
@@ -470,8 +521,9 @@ int pen_x();
 int pen_y();
 float pen_pressure();
 
-void time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data = 0 );
-void repeating_time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data = 0 );
+u64 time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data = 0 );
+u64 repeating_time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data = 0 );
+void cancel_time_event( u64 id );
 
 bool gamepad_connected( int pad_index );
 float gamepad_axis( int pad_index, gamepadaxis_id axis );
@@ -520,6 +572,12 @@ void resume_all_tweeners();
 template< typename T > void register_state();
 template< typename T > void switch_state( float trans_out = 0.0f, float trans_in = 0.0f );
 
+// the resources listed in the manifest (lines of "bitmap|font|audio filename") are loaded before state T is entered, and 
+// released together when it is left. if the manifest does not exist, the resources T uses are recorded and written 
+// to it when T is left
+template< typename T > void preload_state( string const& manifest );
+float state_load_time(); // seconds spent preloading resources for the last state entered
+
 void random_seed( u32 seed );
 float random();
 int random( int min, int max );
@@ -574,6 +632,16 @@ template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void custom_so
 template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void custom_sort( array<T>* arr );
 template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void custom_sort( pod_array<T>* arr );
 
+template< typename T > void stable_sort( array<T>* arr );
+template< typename T > void stable_sort( pod_array<T>* arr );
+template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void custom_stable_sort( array<T>* arr );
+template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void custom_stable_sort( pod_array<T>* arr );
+
+template< typename T > void radix_sort( array<T>* arr );
+template< typename T > void radix_sort( pod_array<T>* arr );
+template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ) > void radix_sort( array<T>* arr );
+template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ) > void radix_sort( pod_array<T>* arr );
+
 template< typename T > int find( T const* haystack_elements, int haystack_count, T const& needle );
 template< typename T > int find( array<T> const& haystack, T const& needle );
 template< typename T > int find( pod_array<T> const& haystack, T const& needle );
@@ -644,6 +712,7 @@ bool starts_with( string str, string start );
 bool starts_with( string_id str, string_id start );
 
 ref<bitmap> load_bitmap( string const& filename );
+void load_atlas( string const& filename );
 
 enum fill_pattern 
 	{ 
@@ -699,8 +768,8 @@ struct game_state : event_handler
 	virtual void tick() { };
 	virtual void on_event( string_id const& event, void* user_data ) { (void) event; (void) user_data; }
 
-	void time_event( float seconds, string_id const& event_id, void* user_data = 0 );
-	void repeating_time_event( float seconds, string_id const& event_id, void* user_data = 0 );
+	u64 time_event( float seconds, string_id const& event_id, void* user_data = 0 );
+	u64 repeating_time_event( float seconds, string_id const& event_id, void* user_data = 0 );
 	void gamepad_pressed_event( int pad_index, gamepadbutton_id button, string_id const& event_id, void* user_data = 0 );
 	void gamepad_released_event( int pad_index, gamepadbutton_id button, string_id const& event_id, void* user_data = 0 );
 	void gamepad_axis_event( int pad_index, gamepadaxis_id axis, float threshold, string_id const& event_id, void* user_data = 0 );
@@ -775,6 +844,7 @@ struct bitmap final
 
 	private:
 		friend struct internal::internals_t;
+		friend struct internal::bitmap_loader;
 		friend void internal::resize_screen();
 
 		struct internal_t final
@@ -786,10 +856,13 @@ struct bitmap final
 			void* storage;
 
 			struct normal_cel final { int offset_x; int offset_y; int pitch_x; int pitch_y; u8* pixels; u8* mask; };
-			enum data_type { DATA_TYPE_NONE, DATA_TYPE_NORMAL, } type;
+			struct delta_cel final { normal_cel base; normal_cel patch; }; // patch drawn over base, pitch 0 if none
+			enum data_type { DATA_TYPE_NONE, DATA_TYPE_NORMAL, DATA_TYPE_DELTA, } type;
+			bool shared; // cels point into memory shared with other bitmaps (pack or atlas), copied before being modified
 			union 
 				{
 				normal_cel* cels_normal;
+				delta_cel* cels_delta;
 				};
 		} internal;
 	};
@@ -1367,6 +1440,8 @@ template< typename T, typename P0, typename P1, typename P2, typename P3, typena
 
 } /* namespace pixie */
 
+namespace array_ns { template< typename T > struct is_relocatable< pixie::resource<T> > { enum { value = 1 }; }; }
+
 
 #endif // pixie_hpp
 
@@ -1411,20 +1486,33 @@ resources::resource_key make_ref_key( void (*copy_func)( void*, void const*), vo
 
 resources::resource_key make_string_key( string const& filename );
 
+enum preload_type_t { PRELOAD_NONE = -1, PRELOAD_BITMAP, PRELOAD_FONT, PRELOAD_AUDIO, };
+template< typename T > preload_type_t preload_type( T* ) { return PRELOAD_NONE; }
+inline preload_type_t preload_type( bitmap* ) { return PRELOAD_BITMAP; }
+inline preload_type_t preload_type( font* ) { return PRELOAD_FONT; }
+inline preload_type_t preload_type( audio* ) { return PRELOAD_AUDIO; }
+
+void preload_state( void const* state_id, string const& manifest );
+void record_resource( preload_type_t type, string const& filename );
+
 } /* namespace internal */ } /* namespace pixie */
 
 
 namespace resources {
 
-inline resource_key make_key( pixie::bitmap*, char const* filename ) { return pixie::internal::make_string_key( pixie::string( filename ) ); }
+inline resource_key make_key( pixie::bitmap*, char const* filename ) { pixie::internal::record_resource( pixie::internal::PRELOAD_BITMAP, filename ); return pixie::internal::make_string_key( pixie::string( filename ) ); }
 void resource_create( pixie::bitmap** instance, pixie::string const& filename );
 void resource_destroy( resource_key* key, pixie::bitmap* instance );
+RESOURCES_U64 resource_size( pixie::bitmap* instance );
+void* resource_request( pixie::bitmap*, pixie::string const& filename );
+inline void* resource_request( pixie::bitmap* instance, char const* filename ) { return resource_request( instance, pixie::string( filename ) ); }
+bool resource_poll( pixie::bitmap** instance, void* request, bool wait );
 
-inline resource_key make_key( pixie::font*, char const* filename ) { return pixie::internal::make_string_key( pixie::string( filename ) ); }
+inline resource_key make_key( pixie::font*, char const* filename ) { pixie::internal::record_resource( pixie::internal::PRELOAD_FONT, filename ); return pixie::internal::make_string_key( pixie::string( filename ) ); }
 void resource_create( pixie::font** instance, pixie::string const& filename );
 void resource_destroy( resource_key* key, pixie::font* instance );
 
-inline resource_key make_key( pixie::audio*, char const* filename ) { return pixie::internal::make_string_key( pixie::string( filename ) ); }
+inline resource_key make_key( pixie::audio*, char const* filename ) { pixie::internal::record_resource( pixie::internal::PRELOAD_AUDIO, filename ); return pixie::internal::make_string_key( pixie::string( filename ) ); }
 void resource_create( pixie::audio** instance, pixie::string const& filename );
 void resource_destroy( resource_key* key, pixie::audio* instance );
 
@@ -1434,7 +1522,7 @@ void resource_create( pixie::audio** instance, float* sample_pairs, int sample_p
 template< typename T > void resource_create( T** instance, pixie::ref<T> const& ref_obj ) { *instance = (T*)ref_obj; }
 template< typename T > void resource_create( T** instance, char const* filename ) { resource_create( instance, pixie::string( filename ) ); }
 
-template< typename T > resource_key make_key( T*, pixie::string const& filename ) { return pixie::internal::make_string_key( filename ); }
+template< typename T > resource_key make_key( T*, pixie::string const& filename ) { pixie::internal::record_resource( pixie::internal::preload_type( (T*)0 ), filename ); return pixie::internal::make_string_key( filename ); }
 template< typename T > resource_key make_key( T*, pixie::ref<T> instance ) { return pixie::internal::make_ref_key( pixie::internal::ref_copy<T>, &instance, sizeof( instance ), pixie::internal::destroy_ref_key<T> );  }
 
 } /* namespace resources */
@@ -1512,6 +1600,14 @@ template< typename T > T* pixie::system()
 	}
 
 
+template< typename T > void pixie::snapshot_system()
+	{
+	T* sys = system<T>();
+	PIXIE_ASSERT( sys, "System must be added before it can be snapshotted" );
+	if( sys ) snapshot_region( sys, sizeof( T ) );
+	}
+
+
 template< typename T > void pixie::register_state()
 	{
 	static_cast<pixie::game_state*>( (T*) 0 ); // ensure T is derived from pixie::game_state
@@ -1525,6 +1621,12 @@ template< typename T > void pixie::switch_state( float trans_out, float trans_in
 	}
 
 
+template< typename T > void pixie::preload_state( string const& manifest )
+	{ 
+	internal::preload_state( gamestate::internal::type_id<T>(), manifest );
+	}
+
+
 template< typename T > void pixie::swap( T* a, T* b )
 	{
 	// expressed using only copy constructor, no assignment operator, for consistency with container classes
@@ -1597,6 +1699,64 @@ template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void pixie::cu
 	}
 
 
+template< typename T > void pixie::stable_sort( array<T>* arr ) 
+	{ 
+	array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::stable_sort( arr->data(), arr->count(), temp.data() ); 
+	}
+
+template< typename T > void pixie::stable_sort( pod_array<T>* arr ) 
+	{ 
+	pod_array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::stable_sort( arr->data(), arr->count(), temp.data() ); 
+	}
+
+template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void pixie::custom_stable_sort( array<T>* arr )
+	{
+	array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::stable_sort<T, COMPARE_FUNC>( arr->data(), arr->count(), temp.data() );
+	}
+	
+template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void pixie::custom_stable_sort( pod_array<T>* arr )
+	{
+	pod_array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::stable_sort<T, COMPARE_FUNC>( arr->data(), arr->count(), temp.data() );
+	}
+
+
+template< typename T > void pixie::radix_sort( array<T>* arr ) 
+	{ 
+	array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::radix_sort( arr->data(), arr->count(), temp.data() ); 
+	}
+
+template< typename T > void pixie::radix_sort( pod_array<T>* arr ) 
+	{ 
+	pod_array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::radix_sort( arr->data(), arr->count(), temp.data() ); 
+	}
+
+template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ) > void pixie::radix_sort( array<T>* arr )
+	{
+	array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::radix_sort<T, KEY, KEY_FUNC>( arr->data(), arr->count(), temp.data() );
+	}
+	
+template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ) > void pixie::radix_sort( pod_array<T>* arr )
+	{
+	pod_array<T> temp( arr->count() ); 
+	temp.resize( arr->count() );
+	::sort_ns::radix_sort<T, KEY, KEY_FUNC>( arr->data(), arr->count(), temp.data() );
+	}
+
+
 template< typename T > int pixie::find( T const* haystack_elements, int haystack_count, T const& needle ) 
 	{ 
 	for( int i = 0; i < haystack_count; ++i )
@@ -1953,6 +2113,10 @@ bool jar_mod_load( jar_mod_context_t * modctx, void * mod_data, int mod_data_siz
 #pragma warning( pop )
 #include <sys/stat.h>
 
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
 #ifndef PIXIE_MALLOC
 	#include <stdlib.h>
 	#define PIXIE_MALLOC( ctx, size ) ( (void) ctx, malloc( size ) )
@@ -1961,16 +2125,24 @@ bool jar_mod_load( jar_mod_context_t * modctx, void * mod_data, int mod_data_siz
 
 namespace pixie { namespace internal { 
 
+// one memtrack per tag, plus one for the total, all in the same array. the counters are updated atomically, as 
+// allocations are made from the update, app, audio and bitmap decoder threads
 struct memtrack_t
 	{
 	void* external_ctx;
-	u64 current;
-	u64 peak;
-	int count;
+	int tag;
+	memtrack_t* tags;
+	i64 volatile current;
+	i64 volatile peak;
+	long volatile count;
 	};
 
 void* tracked_malloc( void* memctx, size_t size, void* ptr );
 void* tracked_free( void* memctx, void* ptr );
+void memtrack_init( memtrack_t* tags, void* external_ctx );
+mem_usage memtrack_usage( void* memctx );
+
+inline void* tagged_memctx( void* memctx, int tag ) { return ( (memtrack_t*) memctx )->tags + tag; }
 
 } /* namespace internal */ } /*namespace pixie */
 
@@ -1978,6 +2150,35 @@ void* tracked_free( void* memctx, void* ptr );
 #define TRACKED_FREE( ctx, ptr ) PIXIE_FREE( ( (pixie::internal::memtrack_t*)ctx )->external_ctx, pixie::internal::tracked_free( ctx, ptr ) )
 
 
+//-------
+//  pack
+//-------
+
+namespace pixie { namespace internal { 
+
+struct pack_t
+	{
+	void* handle;
+	u8* data;
+	size_t size;
+	int slot_count;
+	};
+
+void* map_file( char const* filename, size_t* size, void** handle );
+void unmap_file( void* data, size_t size, void* handle );
+
+bool pack_find( pack_t const* pack, char const* filename, u8** data, size_t* size );
+bool pack_contains( pack_t const* pack, void const* ptr );
+
+struct atlas_bitmap_t
+	{
+	u8* entry;
+	u8* data;
+	};
+
+} /* namespace internal */ } /*namespace pixie */
+
+
 //----------
 //  helpers
 //----------
@@ -2178,7 +2379,7 @@ void send_audio_command( audio_frame_data_t* data, void* memctx, audio_command_t
 	if( data->from_update_thread.commands_count >= data->from_update_thread.commands_capacity )
 		{
 		data->from_update_thread.commands_capacity *= 2;
-		audio_command_t* new_data = (audio_command_t*) TRACKED_MALLOC( memctx, data->from_update_thread.commands_capacity * sizeof( audio_command_t ) );
+		audio_command_t* new_data = (audio_command_t*) TRACKED_MALLOC( tagged_memctx( memctx, MEM_TAG_AUDIO ), data->from_update_thread.commands_capacity * sizeof( audio_command_t ) );
 		memcpy( new_data, data->from_update_thread.commands, data->from_update_thread.commands_count * sizeof( audio_command_t ) );
 		TRACKED_FREE( memctx, data->from_update_thread.commands );
 		data->from_update_thread.commands = new_data;
@@ -2192,14 +2393,54 @@ void send_audio_command( audio_frame_data_t* data, void* memctx, audio_command_t
 template< typename T > void clear( T* t ) { memset( t, 0, sizeof( T ) ); }
 
 
+i64 memtrack_atomic_add( i64 volatile* value, i64 delta )
+	{
+	#if defined( _MSC_VER ) && defined( _M_X64 )
+		return _InterlockedExchangeAdd64( value, delta ) + delta;
+	#elif defined( _MSC_VER )
+		for( ; ; )
+			{
+			i64 old_value = *value;
+			if( _InterlockedCompareExchange64( value, old_value + delta, old_value ) == old_value ) return old_value + delta;
+			}
+	#else
+		return __sync_add_and_fetch( value, delta );
+	#endif
+	}
+
+
+void memtrack_atomic_max( i64 volatile* value, i64 new_value )
+	{
+	for( i64 old_value = *value; new_value > old_value; old_value = *value )
+		{
+		#ifdef _MSC_VER
+			if( _InterlockedCompareExchange64( value, new_value, old_value ) == old_value ) return;
+		#else
+			if( __sync_bool_compare_and_swap( value, old_value, new_value ) ) return;
+		#endif
+		}
+	}
+
+
+void memtrack_add( memtrack_t* memtrack, i64 size )
+	{
+	#ifdef _MSC_VER
+		_InterlockedIncrement( &memtrack->count );
+	#else
+		__sync_add_and_fetch( &memtrack->count, 1 );
+	#endif
+	memtrack_atomic_max( &memtrack->peak, memtrack_atomic_add( &memtrack->current, size ) );
+	}
+
+
 void* tracked_malloc( void* memctx, size_t size, void* ptr ) 
 	{
 	pixie::internal::memtrack_t* memtrack = (pixie::internal::memtrack_t*) memctx;
-	++memtrack->count;
-	memtrack->current += size;
-	memtrack->peak = memtrack->current > memtrack->peak ? memtrack->current : memtrack->peak;   
+	memtrack_add( memtrack, (i64) size );
+	memtrack_add( memtrack->tags + MEM_TAG_COUNT, (i64) size );
+	// the tag goes in the top byte of the size header, so the free can be attributed to the right tag
 	u64* p = (u64*) ptr;
-	*p = size;
+	*p = ( (u64) memtrack->tag << 56 ) | (u64) size;
 	return p + 1; 
 	}
 	
@@ -2210,10 +2451,38 @@ void* tracked_free( void* memctx, void* ptr )
 	u64* p = ( (u64*) ptr ) - 1;
 
 	pixie::internal::memtrack_t* memtrack = (pixie::internal::memtrack_t*) memctx;
-	memtrack->current -= *p;    
+	i64 size = (i64)( *p & 0x00ffffffffffffffull );
+	memtrack_atomic_add( &memtrack->tags[ *p >> 56 ].current, -size );    
+	memtrack_atomic_add( &memtrack->tags[ MEM_TAG_COUNT ].current, -size );    
 	return p;
 	}
 
+
+void memtrack_init( memtrack_t* tags, void* external_ctx )
+	{
+	for( int i = 0; i <= MEM_TAG_COUNT; ++i )
+		{
+		tags[ i ].external_ctx = external_ctx;
+		tags[ i ].tag = i;
+		tags[ i ].tags = tags;
+		tags[ i ].current = 0;
+		tags[ i ].peak = 0;
+		tags[ i ].count = 0;
+		}
+	}
+
+
+mem_usage memtrack_usage( void* memctx )
+	{
+	pixie::internal::memtrack_t* memtrack = (pixie::internal::memtrack_t*) memctx;
+	// adding zero gives an atomic read of the 64-bit counters on 32-bit builds too
+	mem_usage usage;
+	usage.current = memtrack_atomic_add( &memtrack->current, 0 );
+	usage.peak = memtrack_atomic_add( &memtrack->peak, 0 );
+	usage.count = (int) memtrack->count;
+	return usage;
+	}
+
 } /* namespace internal */ } /*namespace pixie */
 
 
@@ -2482,6 +2751,14 @@ audio_instance* audioformat_mod( void* data, size_t size );
 audio_instance* audioformat_xm( void* data, size_t size );
 
 static thread_atomic_ptr_t internals_tls;
+static thread_atomic_ptr_t decoder_tls;
+static thread_atomic_ptr_t strings_tls;
+void* image_memctx();
+void stop_bitmap_decoders( internal::internals_t* internals );
+void reset_frame_arena( internal::internals_t* internals );
+void snapshot_layout( internal::internals_t* internals );
+void snapshot_capture( internal::internals_t* internals );
+void state_transition( void* user_data, gamestate::transition type, void const* state_id );
 void internals_init( internal::internals_t* internals, void* memctx );
 void internals_term( internal::internals_t* internals );
 void resize_screen();
@@ -2489,13 +2766,16 @@ void add_sprite_manager( sprite_manager* manager, void (sprite_manager::*render_
 void remove_sprite_manager( sprite_manager* manager );
 extern u32 default_palette[ 256 ];
 
-struct time_event_t { event_handler* handler; float seconds; float repeat; string_id event_id; void* user_data; };
+struct time_event_t { event_handler* handler; double deadline; float repeat; u64 sequence; int handle; string_id event_id; void* user_data; };
 struct key_event_t { event_handler* handler; key_id key; string_id event_id; void* user_data; };
 struct ascii_event_t { event_handler* handler; char ascii; string_id event_id; void* user_data; };
 struct action_event_t { event_handler* handler; string_id action; bool using_threshold; float threshold; string_id event_id; void* user_data; };
 struct gamepadbutton_event_t { event_handler* handler; int pad_index; gamepadbutton_id button; string_id event_id; void* user_data; };
 struct gamepadaxis_event_t { event_handler* handler; int pad_index; gamepadaxis_id axis; float threshold; string_id event_id; void* user_data; };
 
+// registration indices grouped by key (or pad and button), rebuilt when registrations change
+struct event_dispatch_t { bool dirty; pod_array<int> first; pod_array<int> order; };
+
 
 void update_color_indices( int start, rgb* colors, int count );
 
@@ -2526,6 +2806,16 @@ struct pinned_resource
 	string_id group;
 	};
 
+struct state_preload_t
+	{
+	void const* state_id;
+	string manifest;
+	bool loaded; // manifest has been read
+	bool recording;
+	array<preload_type_t> types;
+	array<string> filenames;
+	};
+
 struct bitmap_and_refcount
 	{
 	u8 bmp[ sizeof( bitmap ) ];
@@ -2704,6 +2994,15 @@ struct pixie::internal::internals_t final
 
 	dictionary<string, int /*, dictionary_ns::no_hash*/> resource_filenames;       
 	bool resources_mounted;
+	pack_t pack;
+	string resource_updates_file;
+	long resource_updates_offset;
+	array<ref<binary> > atlases;
+	dictionary<string, atlas_bitmap_t> atlas_bitmaps;
+	bool bitmap_decoders_started;
+	thread_ptr_t bitmap_decoders[ 2 ];
+	thread_queue_t bitmap_decode_queue;
+	void* bitmap_decode_queue_values[ 256 ];
 	resources::resource_system resource_sys;
 
 	array<audio_format_t> audio_formats;
@@ -2736,7 +3035,10 @@ struct pixie::internal::internals_t final
 	int next_action_index;
 	dictionary<string, int> action_to_index;
 	
-	array<time_event_t> time_events;
+	array<time_event_t> time_events; // binary min-heap on deadline
+	handles_t time_event_handles;
+	double time_events_clock;
+	u64 time_events_sequence;
 	array<key_event_t> key_pressed_events;
 	array<key_event_t> key_released_events;
 	array<ascii_event_t> ascii_events;
@@ -2744,9 +3046,51 @@ struct pixie::internal::internals_t final
 	array<gamepadbutton_event_t> gamepad_pressed_events;
 	array<gamepadbutton_event_t> gamepad_released_events;
 	array<gamepadaxis_event_t> gamepad_axis_events;
+	event_dispatch_t key_pressed_dispatch;
+	event_dispatch_t key_released_dispatch;
+	event_dispatch_t gamepad_pressed_dispatch;
+	event_dispatch_t gamepad_released_dispatch;
+	pod_array<int> dispatch_candidates;
 
 	array<pinned_resource,1024> pinned_resources;
 
+	array<state_preload_t> state_preloads;
+	int recording_count;
+	float state_load_time;
+
+	struct frame_arena_t
+		{
+		void* block;
+		u8* storage; // block rounded up to a 16 byte boundary
+		size_t capacity;
+		size_t used;
+		size_t overflow_size; // total size of allocations which did not fit, the arena grows by this on the next reset
+		void* overflow_blocks;
+		} frame_arena;
+	int frame_start_allocations;
+	int last_frame_allocations;
+
+	struct snapshot_t
+		{
+		struct region_t { void* data; size_t size; size_t offset; }; // offset is in words into state
+		pod_array<region_t> regions;
+		size_t state_words; // each region starts on a new word, so they can be compared a word at a time
+		u64* state; // the most recent capture
+		u64* scratch; // deltas are encoded here before being copied into the history
+		bool captured;
+
+		// history is a ring of deltas, each one the xor of a capture and the one before it. applying a delta to a capture 
+		// turns it back into the previous one, so rewinding walks backwards from the newest delta
+		struct delta_t { size_t offset; size_t size; };
+		int max_frames;
+		delta_t* deltas;
+		int first_delta;
+		int delta_count;
+		u8* history;
+		size_t history_capacity;
+		size_t history_write;
+		} snapshot;
+
 	bool exit_requested;
 
 	update_thread_data_t* update_thread_data;
@@ -2762,8 +3106,8 @@ pixie::internal::internals_t::internals_t( void* memctx_, frame_data_t* frame_da
 	audio_frame_data( audio_frame_data_ ),
 	game_states( memctx_ ),
 	systems( memctx_ ),
-	string_pool( true, memctx_ ),
-	string_id_pool( false, memctx_ ),
+	string_pool( true, memctx_, true ),
+	string_id_pool( false, memctx_, true ),
 	fill_style_pattern( FILL_PATTERN_SOLID ),
 	fill_style_bgcolor( 0 ),
 	use_crtmode( false ),
@@ -2819,6 +3163,42 @@ pixie::internal::internals_t::internals_t( void* memctx_, frame_data_t* frame_da
 	assetsys = assetsys_create( memctx );
 	
 	resources_mounted = false;
+	memset( &pack, 0, sizeof( pack ) );
+	resource_updates_offset = 0;
+	bitmap_decoders_started = false;
+	recording_count = 0;
+	state_load_time = 0.0f;
+	game_states.listener( state_transition, this );
+
+	frame_arena.capacity = 64 * 1024;
+	frame_arena.block = TRACKED_MALLOC( memctx, frame_arena.capacity + 15 );
+	frame_arena.storage = (u8*)( ( (uintptr_t) frame_arena.block + 15 ) & ~(uintptr_t) 15 );
+	frame_arena.used = 0;
+	frame_arena.overflow_size = 0;
+	frame_arena.overflow_blocks = 0;
+	frame_start_allocations = 0;
+	last_frame_allocations = 0;
+
+	snapshot.state_words = 0;
+	snapshot.state = 0;
+	snapshot.scratch = 0;
+	snapshot.captured = false;
+	snapshot.max_frames = 0;
+	snapshot.deltas = 0;
+	snapshot.first_delta = 0;
+	snapshot.delta_count = 0;
+	snapshot.history = 0;
+	snapshot.history_capacity = 0;
+	snapshot.history_write = 0;
+
+	key_pressed_dispatch.dirty = true;
+	key_released_dispatch.dirty = true;
+	gamepad_pressed_dispatch.dirty = true;
+	gamepad_released_dispatch.dirty = true;
+
+	handles_init( &time_event_handles, 64, memctx );
+	time_events_clock = 0.0;
+	time_events_sequence = 0;
 
 	border_width = 32;
 	border_height = 44;
@@ -2837,19 +3217,56 @@ pixie::internal::internals_t::~internals_t()
 	{ 
 	PIXIE_ASSERT( current_sounds.count() == 0, "Sound cleanup not finished" );
 
+	if( bitmap_decoders_started ) stop_bitmap_decoders( this );
+
 	game_states.pop( -1 );
 	game_states.update( 0.0f );
+	game_states.listener( 0 );
 	tween_system.stop_all();    
+	time_events.clear();
+	handles_term( &time_event_handles );
 
 	pinned_resources.clear();
+	atlas_bitmaps.clear();
+	atlases.clear();
 	gamepad_destroy( gamepad );
 	inputmap_destroy( inputmap );
 	assetsys_destroy( assetsys );
-
+	if( pack.data ) unmap_file( pack.data, pack.size, pack.handle );
+
+	reset_frame_arena( this );
+	TRACKED_FREE( memctx, frame_arena.block );
+	if( snapshot.state ) TRACKED_FREE( memctx, snapshot.state );
+	if( snapshot.scratch ) TRACKED_FREE( memctx, snapshot.scratch );
+	if( snapshot.deltas ) TRACKED_FREE( memctx, snapshot.deltas );
+	if( snapshot.history ) TRACKED_FREE( memctx, snapshot.history );
 	TRACKED_FREE( memctx, screen_storage );
 	}
 	
 
+void pixie::internal::reset_frame_arena( internals_t* internals )
+	{
+	internals_t::frame_arena_t* arena = &internals->frame_arena;
+	while( arena->overflow_blocks )
+		{
+		void* next = *(void**) arena->overflow_blocks;
+		TRACKED_FREE( internals->memctx, arena->overflow_blocks );
+		arena->overflow_blocks = next;
+		}
+
+	// grow to fit everything that was allocated last frame, so that the same amount fits without overflowing next time
+	if( arena->overflow_size > 0 )
+		{
+		arena->capacity = math_util::pow2_ceil( (u32)( arena->used + arena->overflow_size ) );
+		TRACKED_FREE( internals->memctx, arena->block );
+		arena->block = TRACKED_MALLOC( internals->memctx, arena->capacity + 15 );
+		arena->storage = (u8*)( ( (uintptr_t) arena->block + 15 ) & ~(uintptr_t) 15 );
+		arena->overflow_size = 0;
+		}
+	arena->used = 0;
+	}
+
+
 pixie::internal::internals_t* pixie::internal::internals()
 	{
 	thread_tls_t tls = thread_atomic_ptr_load( &internals_tls );
@@ -2860,6 +3277,15 @@ pixie::internal::internals_t* pixie::internal::internals()
 	}
 	
 
+// image decoding can run on the bitmap decoder threads, which can't reach internals
+void* pixie::internal::image_memctx()
+	{
+	thread_tls_t tls = thread_atomic_ptr_load( &decoder_tls );
+	void* memctx = tls ? thread_tls_get( tls ) : 0;
+	return memctx ? memctx : tagged_memctx( internals()->memctx, MEM_TAG_BITMAP );
+	}
+	
+
 
 //-----------
 //  app_proc
@@ -3033,83 +3459,227 @@ void process_input( internals_t* internals, app_input_event_t* input_events, int
 	}
 
 
-void send_events( internals_t* internals )
+// events with the same deadline fire in the order they were added
+bool time_event_before( time_event_t const& a, time_event_t const& b )
 	{
-	for( int i = 0; i < internals->key_released_events.count(); ++i )
+	return a.deadline < b.deadline || ( a.deadline == b.deadline && a.sequence < b.sequence );
+	}
+
+
+void time_event_sift_up( internals_t* internals, int index )
+	{
+	array<time_event_t>& heap = internals->time_events;
+	time_event_t event = heap[ index ];
+	while( index > 0 )
 		{
-		key_event_t* key_event = &internals->key_released_events[ i ];
-		key_id key = key_event->key;
-		if( !internals->key_states[ key ] && internals->previous_key_states[ key ] )
-			key_event->handler->on_event( key_event->event_id, key_event->user_data );
+		int parent = ( index - 1 ) / 2;
+		if( !time_event_before( event, heap[ parent ] ) ) break;
+		heap[ index ] = heap[ parent ];
+		handles_update( &internals->time_event_handles, heap[ index ].handle, index );
+		index = parent;
 		}
+	heap[ index ] = event;
+	handles_update( &internals->time_event_handles, event.handle, index );
+	}
 
-	for( int i = 0; i < internals->key_pressed_events.count(); ++i )
+
+void time_event_sift_down( internals_t* internals, int index )
+	{
+	array<time_event_t>& heap = internals->time_events;
+	time_event_t event = heap[ index ];
+	for( ; ; )
 		{
-		key_event_t* key_event = &internals->key_pressed_events[ i ];
-		key_id key = key_event->key;
-		if( internals->key_states[ key ] && !internals->previous_key_states[ key ] )
-			key_event->handler->on_event( key_event->event_id, key_event->user_data );
+		int child = index * 2 + 1;
+		if( child >= heap.count() ) break;
+		if( child + 1 < heap.count() && time_event_before( heap[ child + 1 ], heap[ child ] ) ) ++child;
+		if( !time_event_before( heap[ child ], event ) ) break;
+		heap[ index ] = heap[ child ];
+		handles_update( &internals->time_event_handles, heap[ index ].handle, index );
+		index = child;
 		}
+	heap[ index ] = event;
+	handles_update( &internals->time_event_handles, event.handle, index );
+	}
 
-	for( int i = 0; i < internals->gamepad_released_events.count(); ++i )
+
+void time_event_remove( internals_t* internals, int index )
+	{
+	array<time_event_t>& heap = internals->time_events;
+	handles_release( &internals->time_event_handles, heap[ index ].handle );
+	int last = heap.count() - 1;
+	if( index != last ) 
 		{
-		gamepadbutton_event_t* gamepad_event = &internals->gamepad_released_events[ i ];
-		int pad_index = gamepad_event->pad_index;
-		gamepad_button_t button = (gamepad_button_t) 0;
-		switch( gamepad_event->button )
-			{       
-			case GAMEPADBUTTON_DPAD_UP: button = GAMEPAD_DPAD_UP; break;
-			case GAMEPADBUTTON_DPAD_DOWN: button = GAMEPAD_DPAD_DOWN; break;
-			case GAMEPADBUTTON_DPAD_LEFT: button = GAMEPAD_DPAD_LEFT; break;
-			case GAMEPADBUTTON_DPAD_RIGHT: button = GAMEPAD_DPAD_RIGHT; break;
-			case GAMEPADBUTTON_START: button = GAMEPAD_START; break;
-			case GAMEPADBUTTON_BACK: button = GAMEPAD_BACK; break;
-			case GAMEPADBUTTON_STICK_LEFT: button = GAMEPAD_STICK_LEFT; break;
-			case GAMEPADBUTTON_STICK_RIGHT: button = GAMEPAD_STICK_RIGHT; break;
-			case GAMEPADBUTTON_SHOULDER_LEFT: button = GAMEPAD_SHOULDER_LEFT; break;
-			case GAMEPADBUTTON_SHOULDER_RIGHT: button = GAMEPAD_SHOULDER_RIGHT; break;
-			case GAMEPADBUTTON_A: button = GAMEPAD_A; break;
-			case GAMEPADBUTTON_B: button = GAMEPAD_B; break;
-			case GAMEPADBUTTON_X: button = GAMEPAD_X; break;
-			case GAMEPADBUTTON_Y: button = GAMEPAD_Y; break;
+		heap[ index ] = heap[ last ];
+		heap.remove( last );
+		time_event_sift_down( internals, index );
+		time_event_sift_up( internals, index );
+		}
+	else
+		{
+		heap.remove( last );
+		}
+	}
+
+
+void time_event_remove_handler( internals_t* internals, event_handler* handler )
+	{
+	// compact away the handler's events, then rebuild the heap from the ones that are left
+	array<time_event_t>& heap = internals->time_events;
+	int count = 0;
+	for( int i = 0; i < heap.count(); ++i )
+		{
+		if( heap[ i ].handler == handler )
+			{
+			handles_release( &internals->time_event_handles, heap[ i ].handle );
 			}
-		if( internals->gamepad_data[ pad_index ].result == GAMEPAD_RESULT_OK )
+		else
 			{
-			if( !( internals->gamepad_data[ pad_index ].state.buttons & button ) && 
-				( internals->gamepad_data[ pad_index ].previous_state.buttons & button ) )
-					gamepad_event->handler->on_event( gamepad_event->event_id, gamepad_event->user_data );
+			if( count != i ) heap[ count ] = heap[ i ];
+			handles_update( &internals->time_event_handles, heap[ count ].handle, count );
+			++count;
 			}
 		}
+	if( count == heap.count() ) return;
+	
+	heap.resize( count );
+	for( int i = count / 2 - 1; i >= 0; --i )
+		time_event_sift_down( internals, i );
+	}
 
-	for( int i = 0; i < internals->gamepad_pressed_events.count(); ++i )
+
+u64 time_event_add( internals_t* internals, event_handler* handler, float seconds, float repeat, string_id const& event_id, void* user_data )
+	{
+	time_event_t& event = internals->time_events.add();
+	event.handler = handler;
+	event.deadline = internals->time_events_clock + seconds;
+	event.repeat = repeat;
+	event.sequence = internals->time_events_sequence++;
+	event.handle = handles_alloc( &internals->time_event_handles, internals->time_events.count() - 1 );
+	event.event_id = event_id;
+	event.user_data = user_data;
+	u64 id = handles_to_u64( &internals->time_event_handles, event.handle );
+	time_event_sift_up( internals, internals->time_events.count() - 1 );
+	return id;
+	}
+
+
+gamepad_button_t gamepad_button( gamepadbutton_id button )
+	{
+	switch( button )
+		{       
+		case GAMEPADBUTTON_DPAD_UP: return GAMEPAD_DPAD_UP;
+		case GAMEPADBUTTON_DPAD_DOWN: return GAMEPAD_DPAD_DOWN;
+		case GAMEPADBUTTON_DPAD_LEFT: return GAMEPAD_DPAD_LEFT;
+		case GAMEPADBUTTON_DPAD_RIGHT: return GAMEPAD_DPAD_RIGHT;
+		case GAMEPADBUTTON_START: return GAMEPAD_START;
+		case GAMEPADBUTTON_BACK: return GAMEPAD_BACK;
+		case GAMEPADBUTTON_STICK_LEFT: return GAMEPAD_STICK_LEFT;
+		case GAMEPADBUTTON_STICK_RIGHT: return GAMEPAD_STICK_RIGHT;
+		case GAMEPADBUTTON_SHOULDER_LEFT: return GAMEPAD_SHOULDER_LEFT;
+		case GAMEPADBUTTON_SHOULDER_RIGHT: return GAMEPAD_SHOULDER_RIGHT;
+		case GAMEPADBUTTON_A: return GAMEPAD_A;
+		case GAMEPADBUTTON_B: return GAMEPAD_B;
+		case GAMEPADBUTTON_X: return GAMEPAD_X;
+		case GAMEPADBUTTON_Y: return GAMEPAD_Y;
+		}
+	return (gamepad_button_t) 0;
+	}
+
+
+int const GAMEPADBUTTON_COUNT = GAMEPADBUTTON_Y + 1;
+int const GAMEPAD_SLOT_COUNT = 4 * GAMEPADBUTTON_COUNT;
+
+int dispatch_slot( key_event_t const& event ) { return event.key; }
+int dispatch_slot( gamepadbutton_event_t const& event ) { return event.pad_index * GAMEPADBUTTON_COUNT + event.button; }
+
+
+template< typename T > void build_dispatch( event_dispatch_t* dispatch, array<T>& events, int slot_count )
+	{
+	if( !dispatch->dirty ) return;
+	dispatch->dirty = false;
+
+	// counting sort of the registrations by slot, which keeps registration order within each slot
+	dispatch->first.resize( slot_count + 1 );
+	for( int i = 0; i <= slot_count; ++i ) dispatch->first[ i ] = 0;
+	for( int i = 0; i < events.count(); ++i ) ++dispatch->first[ dispatch_slot( events[ i ] ) + 1 ];
+	for( int i = 1; i <= slot_count; ++i ) dispatch->first[ i ] += dispatch->first[ i - 1 ];
+	dispatch->order.resize( events.count() );
+	for( int i = 0; i < events.count(); ++i ) dispatch->order[ dispatch->first[ dispatch_slot( events[ i ] ) ]++ ] = i;
+	for( int i = slot_count; i > 0; --i ) dispatch->first[ i ] = dispatch->first[ i - 1 ];
+	dispatch->first[ 0 ] = 0;
+	}
+
+
+// sends the events registered for the triggered slots, in registration order. if a handler adds or removes 
+// registrations, the tables are rebuilt, and dispatch carries on from after the last event sent
+template< typename T > void dispatch_events( internals_t* internals, event_dispatch_t* dispatch, array<T>& events, 
+	int slot_count, int const* slots, int slots_count )
+	{
+	if( slots_count <= 0 ) return;
+	
+	int last_sent = -1;
+	for( ; ; )
 		{
-		gamepadbutton_event_t* gamepad_event = &internals->gamepad_pressed_events[ i ];
-		int pad_index = gamepad_event->pad_index;
-		gamepad_button_t button = (gamepad_button_t) 0;
-		switch( gamepad_event->button )
-			{       
-			case GAMEPADBUTTON_DPAD_UP: button = GAMEPAD_DPAD_UP; break;
-			case GAMEPADBUTTON_DPAD_DOWN: button = GAMEPAD_DPAD_DOWN; break;
-			case GAMEPADBUTTON_DPAD_LEFT: button = GAMEPAD_DPAD_LEFT; break;
-			case GAMEPADBUTTON_DPAD_RIGHT: button = GAMEPAD_DPAD_RIGHT; break;
-			case GAMEPADBUTTON_START: button = GAMEPAD_START; break;
-			case GAMEPADBUTTON_BACK: button = GAMEPAD_BACK; break;
-			case GAMEPADBUTTON_STICK_LEFT: button = GAMEPAD_STICK_LEFT; break;
-			case GAMEPADBUTTON_STICK_RIGHT: button = GAMEPAD_STICK_RIGHT; break;
-			case GAMEPADBUTTON_SHOULDER_LEFT: button = GAMEPAD_SHOULDER_LEFT; break;
-			case GAMEPADBUTTON_SHOULDER_RIGHT: button = GAMEPAD_SHOULDER_RIGHT; break;
-			case GAMEPADBUTTON_A: button = GAMEPAD_A; break;
-			case GAMEPADBUTTON_B: button = GAMEPAD_B; break;
-			case GAMEPADBUTTON_X: button = GAMEPAD_X; break;
-			case GAMEPADBUTTON_Y: button = GAMEPAD_Y; break;
+		build_dispatch( dispatch, events, slot_count );
+		pod_array<int>& candidates = internals->dispatch_candidates;
+		candidates.clear();
+		for( int i = 0; i < slots_count; ++i )
+			for( int j = dispatch->first[ slots[ i ] ]; j < dispatch->first[ slots[ i ] + 1 ]; ++j )
+				if( dispatch->order[ j ] > last_sent ) candidates.add( dispatch->order[ j ] );
+		if( candidates.count() == 0 ) return;
+		sort( &candidates );
+
+		for( int i = 0; i < candidates.count(); ++i )
+			{
+			last_sent = candidates[ i ];
+			events[ last_sent ].handler->on_event( events[ last_sent ].event_id, events[ last_sent ].user_data );
+			if( dispatch->dirty ) break;
 			}
-		if( internals->gamepad_data[ pad_index ].result == GAMEPAD_RESULT_OK )
+		if( !dispatch->dirty ) return;
+		}
+	}
+
+
+void send_events( internals_t* internals )
+	{
+	// key and button events are looked up by the keys and buttons that changed this frame, rather than checking 
+	// every registration
+	int pressed[ KEYCOUNT ];
+	int released[ KEYCOUNT ];
+	int pressed_count = 0;
+	int released_count = 0;
+	if( memcmp( internals->key_states, internals->previous_key_states, sizeof( internals->key_states ) ) != 0 )
+		{
+		for( int i = 0; i < KEYCOUNT; ++i )
+			{
+			if( internals->key_states[ i ] && !internals->previous_key_states[ i ] ) pressed[ pressed_count++ ] = i;
+			if( !internals->key_states[ i ] && internals->previous_key_states[ i ] ) released[ released_count++ ] = i;
+			}
+		}
+	dispatch_events( internals, &internals->key_released_dispatch, internals->key_released_events, KEYCOUNT, released, released_count );
+	dispatch_events( internals, &internals->key_pressed_dispatch, internals->key_pressed_events, KEYCOUNT, pressed, pressed_count );
+
+	int buttons_pressed[ GAMEPAD_SLOT_COUNT ];
+	int buttons_released[ GAMEPAD_SLOT_COUNT ];
+	int buttons_pressed_count = 0;
+	int buttons_released_count = 0;
+	for( int i = 0; i < 4; ++i )
+		{
+		if( internals->gamepad_data[ i ].result != GAMEPAD_RESULT_OK ) continue;
+		int buttons = internals->gamepad_data[ i ].state.buttons;
+		int previous_buttons = internals->gamepad_data[ i ].previous_state.buttons;
+		if( buttons == previous_buttons ) continue;
+		for( int j = 0; j < GAMEPADBUTTON_COUNT; ++j )
 			{
-			if( ( internals->gamepad_data[ pad_index ].state.buttons & button ) && 
-				!( internals->gamepad_data[ pad_index ].previous_state.buttons & button ) )
-					gamepad_event->handler->on_event( gamepad_event->event_id, gamepad_event->user_data );
+			int mask = gamepad_button( (gamepadbutton_id) j );
+			if( ( buttons & mask ) && !( previous_buttons & mask ) ) buttons_pressed[ buttons_pressed_count++ ] = i * GAMEPADBUTTON_COUNT + j;
+			if( !( buttons & mask ) && ( previous_buttons & mask ) ) buttons_released[ buttons_released_count++ ] = i * GAMEPADBUTTON_COUNT + j;
 			}
 		}
+	dispatch_events( internals, &internals->gamepad_released_dispatch, internals->gamepad_released_events, 
+		GAMEPAD_SLOT_COUNT, buttons_released, buttons_released_count );
+	dispatch_events( internals, &internals->gamepad_pressed_dispatch, internals->gamepad_pressed_events, 
+		GAMEPAD_SLOT_COUNT, buttons_pressed, buttons_pressed_count );
 
 	for( int i = 0; i < internals->gamepad_axis_events.count(); ++i )
 		{
@@ -3163,22 +3733,25 @@ void send_events( internals_t* internals )
 			action_event->handler->on_event( action_event->event_id, action_event->user_data );
 		}
 
-	for( int i = 0; i < internals->time_events.count(); ++i )
+	// only the events that are due are looked at, and they fire in deadline order
+	internals->time_events_clock += internals->delta_time;
+	while( internals->time_events.count() > 0 && internals->time_events[ 0 ].deadline <= internals->time_events_clock )
 		{
-		time_event_t* time_event = &internals->time_events[ i ];
-		time_event->seconds -= internals->delta_time;
-		if( time_event->seconds <= 0.0f )
+		time_event_t event = internals->time_events[ 0 ];
+		u64 id = handles_to_u64( &internals->time_event_handles, event.handle );
+		event.handler->on_event( event.event_id, event.user_data );
+
+		// the handler might have added or cancelled events, so look this one up again
+		int index = handles_index( &internals->time_event_handles, handles_from_u64( &internals->time_event_handles, id ) );
+		if( index < 0 ) continue;
+		if( event.repeat > 0.0f )
 			{
-			time_event->handler->on_event( time_event->event_id, time_event->user_data );
-			if( time_event->repeat > 0.0f )
-				{
-				time_event->seconds = time_event->repeat;
-				}
-			else
-				{
-				internals->time_events.remove( i );
-				--i;
-				}
+			internals->time_events[ index ].deadline = internals->time_events_clock + event.repeat;
+			time_event_sift_down( internals, index );
+			}
+		else
+			{
+			time_event_remove( internals, index );
 			}
 		}
 	}
@@ -3434,7 +4007,7 @@ int audio_thread_proc( void* user_data )
 	audiosys_t* audiosys = audio_thread_data->audiosys;
 	
 	audio_thread_context_t audio_thread_context;
-	audio_thread_context.memctx = audio_thread_data->app_proc_data->memctx;
+	audio_thread_context.memctx = tagged_memctx( audio_thread_data->app_proc_data->memctx, MEM_TAG_AUDIO );
 	audio_thread_context.finished_count = 0;
 	audio_thread_context.finished_capacity = 256;
 	audio_thread_context.finished = (audio_thread_sound_t*) TRACKED_MALLOC( 
@@ -3995,6 +4568,7 @@ int update_thread_proc( void* user_data )
 
 	// destroy internal state
 	internals->~internals_t();
+	strpool::internal::release_thread_temp_buffer();
 	TRACKED_FREE( app_proc_data->memctx, internals_storage );
 	thread_tls_set( tls, 0 );   
 
@@ -4116,6 +4690,13 @@ void pixie::execute_frame()
 
 	// END OF ORIGINAL UPDATE LOOP - NEW FRAME STARTING
 
+	internal::reset_frame_arena( internals );
+	int const allocations = internal::memtrack_usage( internal::tagged_memctx( internals->memctx, MEM_TAG_COUNT ) ).count;
+	internals->last_frame_allocations = allocations - internals->frame_start_allocations;
+	internals->frame_start_allocations = allocations;
+
+	if( internals->snapshot.max_frames > 0 ) internal::snapshot_capture( internals );
+
 	// update frame time/count
 	internals->delta_time = 1.0f / 60.0f; // update runs on fixed 60hz, limited by app_proc_thread (via frame_data queue)
 	++internals->frame_count;
@@ -4269,15 +4850,15 @@ int app_proc( app_t* app, void* user_data )
 		{
 		audio_frame_data_slots[ i ].from_update_thread.commands_capacity = 1024;
 		audio_frame_data_slots[ i ].from_update_thread.commands = (audio_command_t*) TRACKED_MALLOC( 
-			app_proc_data->memctx, audio_frame_data_slots[ i ].from_update_thread.commands_capacity * sizeof( audio_command_t ) );
+			tagged_memctx( app_proc_data->memctx, MEM_TAG_AUDIO ), audio_frame_data_slots[ i ].from_update_thread.commands_capacity * sizeof( audio_command_t ) );
 
 		audio_frame_data_slots[ i ].from_audio_thread.finished_capacity = 1024;
 		audio_frame_data_slots[ i ].from_audio_thread.finished = (finished_audio_t*) TRACKED_MALLOC( 
-			app_proc_data->memctx, audio_frame_data_slots[ i ].from_audio_thread.finished_capacity * sizeof( finished_audio_t ) );
+			tagged_memctx( app_proc_data->memctx, MEM_TAG_AUDIO ), audio_frame_data_slots[ i ].from_audio_thread.finished_capacity * sizeof( finished_audio_t ) );
 		
 		audio_frame_data_slots[ i ].from_audio_thread.positions_capacity = 1024;
 		audio_frame_data_slots[ i ].from_audio_thread.positions = (audio_position_t*) TRACKED_MALLOC( 
-			app_proc_data->memctx, audio_frame_data_slots[ i ].from_audio_thread.positions_capacity * sizeof( audio_position_t ) );
+			tagged_memctx( app_proc_data->memctx, MEM_TAG_AUDIO ), audio_frame_data_slots[ i ].from_audio_thread.positions_capacity * sizeof( audio_position_t ) );
 		}
 	
 	audio_frame_data_t* audio_frame_data_from_audio_thread_queue_storage[ AUDIO_FRAME_DATA_BUFFER_COUNT ];
@@ -4882,19 +5463,24 @@ int pixie::run( game_main_func_t game_main, void* external_memctx )
 	if( !tls ) return 1;
 	if( thread_atomic_ptr_compare_and_swap( &internal::internals_tls, NULL, tls ) != NULL )
 		thread_tls_destroy( tls );
+	tls = thread_tls_create();
+	if( !tls ) return 1;
+	if( thread_atomic_ptr_compare_and_swap( &internal::decoder_tls, NULL, tls ) != NULL )
+		thread_tls_destroy( tls );
+	tls = thread_tls_create();
+	if( !tls ) return 1;
+	if( thread_atomic_ptr_compare_and_swap( &internal::strings_tls, NULL, tls ) != NULL )
+		thread_tls_destroy( tls );
 
-	// init memory allocation context
-	pixie::internal::memtrack_t memtrack;
-	memtrack.external_ctx = external_memctx;
-	memtrack.current = 0;
-	memtrack.peak = 0;
-	memtrack.count = 0;
+	// init memory allocation context, untagged allocations go to MEM_TAG_GENERAL
+	pixie::internal::memtrack_t memtrack[ MEM_TAG_COUNT + 1 ];
+	internal::memtrack_init( memtrack, external_memctx );
 
 	// run app
 	internal::app_proc_data_t app_proc_data;
 	app_proc_data.game_main = game_main;
-	app_proc_data.memctx = &memtrack;  
-	return app_run( internal::app_proc, &app_proc_data, &memtrack, 0, 0 );
+	app_proc_data.memctx = &memtrack[ MEM_TAG_GENERAL ];  
+	return app_run( internal::app_proc, &app_proc_data, &memtrack[ MEM_TAG_GENERAL ], 0, 0 );
 	}
 
 
@@ -5021,15 +5607,41 @@ void pixie::internal::systems_free( void* p )
 	}
 
 
+// the update thread reaches the string pools through internals, other threads through use_strings
+static pixie::internal::internals_t* string_pools_owner()
+	{
+	thread_tls_t tls = thread_atomic_ptr_load( &pixie::internal::internals_tls );
+	void* ptr = tls ? thread_tls_get( tls ) : 0;
+	if( ptr ) return (pixie::internal::internals_t*) ptr;
+	tls = thread_atomic_ptr_load( &pixie::internal::strings_tls );
+	ptr = tls ? thread_tls_get( tls ) : 0;
+	PIXIE_ASSERT( ptr, "Attempt to use strings from a thread which has not called use_strings." );
+	return (pixie::internal::internals_t*) ptr;
+	}
+
+
 strpool::internal::string_pool& pixie::internal::string_pool()
 	{
-	return internals()->string_pool;
+	return string_pools_owner()->string_pool;
 	}
 	
 	
 strpool::internal::string_pool& pixie::internal::string_id_pool()
 	{
-	return internals()->string_id_pool;
+	return string_pools_owner()->string_id_pool;
+	}
+
+
+void* pixie::share_strings()
+	{
+	return internal::internals();
+	}
+
+
+void pixie::use_strings( void* shared )
+	{
+	if( !shared ) strpool::internal::release_thread_temp_buffer();
+	thread_tls_set( thread_atomic_ptr_load( &internal::strings_tls ), shared );
 	}
 
 gamestate::game_state_system<>* pixie::internal::game_states()
@@ -5115,34 +5727,215 @@ void pixie::mount_resources( string const& primary, string const& secondary )
 	}
 
 
-pixie::datetime pixie::now()
+namespace pixie { namespace internal {
+
+// must match the pack file layout written by pixie_build::pack_dir
+static int const PACK_HEADER_SIZE = 32;
+static u32 const PACK_EMPTY_SLOT = 0xffffffffU;
+
+struct pack_slot
 	{
-	time_t t = ::time( NULL );
-	struct tm* dt = ::localtime( &t );
-	
-	pixie::datetime result;
-	result.year = dt->tm_year + 1900; 
-	result.month = dt->tm_mon + 1; 
-	result.day = dt->tm_mday; 
-	result.hour = dt->tm_hour; 
-	result.minute = dt->tm_min; 
-	result.second = dt->tm_sec; 
-	switch( dt->tm_wday )
+	u32 hash;
+	u32 name_offset;
+	u64 data_offset;
+	u64 data_size;
+	};
+
+
+u32 pack_hash( char const* str )
+	{
+	// FNV-1a, with backslashes hashed as forward slashes
+	u32 hash = 2166136261U;
+	while( *str )
 		{
-		case 0: result.day_of_week = DAY_SUNDAY; break;
-		case 1: result.day_of_week = DAY_MONDAY; break;
-		case 2: result.day_of_week = DAY_TUESDAY; break;
-		case 3: result.day_of_week = DAY_WEDNESDAY; break;
-		case 4: result.day_of_week = DAY_THURSDAY; break;
-		case 5: result.day_of_week = DAY_FRIDAY; break;
-		case 6: result.day_of_week = DAY_SATURDAY; break;
+		char c = *str++;
+		hash = ( hash ^ (u32)(u8)( c == '\\' ? '/' : c ) ) * 16777619U;
 		}
-
-	return result;
+	return hash;
 	}
 
 
-pixie::i64 pixie::time() 
+bool pack_find( pack_t const* pack, char const* filename, u8** data, size_t* size )
+	{
+	if( !pack->data ) return false;
+
+	u32 hash = pack_hash( filename );
+	pack_slot const* slots = (pack_slot const*)( pack->data + PACK_HEADER_SIZE );
+	int slot = (int)( hash & ( pack->slot_count - 1 ) );
+	while( slots[ slot ].name_offset != PACK_EMPTY_SLOT )
+		{
+		if( slots[ slot ].hash == hash )
+			{
+			char const* a = (char const*)( pack->data + slots[ slot ].name_offset );
+			char const* b = filename;
+			// compare with backslashes as forward slashes on both sides, the same way they are hashed
+			while( *a && ( *a == '\\' ? '/' : *a ) == ( *b == '\\' ? '/' : *b ) ) { ++a; ++b; }
+			if( *a == 0 && *b == 0 )
+				{
+				*data = pack->data + slots[ slot ].data_offset;
+				*size = (size_t) slots[ slot ].data_size;
+				return true;
+				}
+			}
+		slot = ( slot + 1 ) & ( pack->slot_count - 1 );
+		}
+
+	return false;
+	}
+
+
+bool pack_contains( pack_t const* pack, void const* ptr )
+	{
+	return pack->data && (uintptr_t) ptr >= (uintptr_t) pack->data && (uintptr_t) ptr < (uintptr_t) pack->data + pack->size;
+	}
+
+
+// checks that the directory, and every name and file it refers to, is inside the file, so a truncated or corrupt pack
+// is rejected when mounted rather than read out of bounds later
+bool pack_validate( u8 const* data, size_t size, int* slot_count_out )
+	{
+	char const header[] = "PIXIE_PAK";
+	int const* info = (int const*)( data + sizeof( header ) );
+	int supported_version = 1;
+	if( size < PACK_HEADER_SIZE || memcmp( data, header, sizeof( header ) ) != 0 || info[ 0 ] != supported_version ) return false;
+
+	// lookups stop at an empty slot, so there has to be at least one
+	int const slot_count = info[ 2 ];
+	if( slot_count <= 0 || ( slot_count & ( slot_count - 1 ) ) != 0 ) return false;
+	if( (size_t) slot_count > ( size - PACK_HEADER_SIZE ) / sizeof( pack_slot ) ) return false;
+	pack_slot const* slots = (pack_slot const*)( data + PACK_HEADER_SIZE );
+	int used = 0;
+	for( int i = 0; i < slot_count; ++i )
+		{
+		pack_slot const& slot = slots[ i ];
+		if( slot.name_offset == PACK_EMPTY_SLOT ) continue;
+		++used;
+		if( slot.name_offset >= size || !memchr( data + slot.name_offset, 0, size - slot.name_offset ) ) return false;
+		if( slot.data_offset > size || slot.data_size > size - slot.data_offset ) return false;
+		}
+	*slot_count_out = slot_count;
+	return used < slot_count;
+	}
+
+} /* namespace internal */ } /* namespace pixie */
+
+
+void pixie::mount_pack( string const& filename )
+	{
+	internal::internals_t* internals = internal::internals();
+	PIXIE_ASSERT( !internals->pack.data, "pack already mounted" );
+
+	size_t size = 0;
+	void* handle = 0;
+	u8* data = (u8*) internal::map_file( filename.c_str(), &size, &handle );
+	PIXIE_ASSERTF( data, ( "Failed to mount pack: %s", filename.c_str() ) );
+	if( !data ) return;
+
+	int slot_count = 0;
+	bool valid = internal::pack_validate( data, size, &slot_count );
+	PIXIE_ASSERTF( valid, ( "Invalid pack file: %s", filename.c_str() ) );
+	if( !valid )
+		{
+		internal::unmap_file( data, size, handle );
+		return;
+		}
+
+	internals->pack.handle = handle;
+	internals->pack.data = data;
+	internals->pack.size = size;
+	internals->pack.slot_count = slot_count;
+	}
+
+
+// the updates file is written by pixie_build in watch mode, listing the path of each rebuilt file on a separate line
+void pixie::watch_resource_updates( string const& filename )
+	{
+	internal::internals_t* internals = internal::internals();
+	internals->resource_updates_file = filename;
+	internals->resource_updates_offset = 0;
+
+	// only report files rebuilt from now on
+	FILE* fp = fopen( filename.c_str(), "rb" );
+	if( fp )
+		{
+		fseek( fp, 0, SEEK_END );
+		internals->resource_updates_offset = ftell( fp );
+		fclose( fp );
+		}
+	}
+
+
+int pixie::resource_updates( array<string>* paths )
+	{
+	internal::internals_t* internals = internal::internals();
+	if( internals->resource_updates_file.length() == 0 ) return 0;
+	FILE* fp = fopen( internals->resource_updates_file.c_str(), "rb" );
+	if( !fp ) return 0;
+
+	fseek( fp, 0, SEEK_END );
+	long size = ftell( fp );
+	if( size < internals->resource_updates_offset ) internals->resource_updates_offset = 0; // the file was recreated
+
+	int added = 0;
+	long count = size - internals->resource_updates_offset;
+	if( count > 0 )
+		{
+		char* text = (char*) frame_alloc( (size_t) count + 1 );
+		fseek( fp, internals->resource_updates_offset, SEEK_SET );
+		count = (long) fread( text, 1, (size_t) count, fp );
+		text[ count ] = 0;
+
+		// only complete lines are used, as the builder might still be writing the last one
+		char* line = text;
+		char* end = strchr( line, '\n' );
+		while( end )
+			{
+			internals->resource_updates_offset += (long)( end + 1 - line );
+			*end = 0;
+			if( end > line && end[ -1 ] == '\r' ) end[ -1 ] = 0;
+			if( *line ) 
+				{
+				paths->add( string( line ) );
+				++added;
+				}
+			line = end + 1;
+			end = strchr( line, '\n' );
+			}
+		}
+
+	fclose( fp );
+	return added;
+	}
+
+
+pixie::datetime pixie::now()
+	{
+	time_t t = ::time( NULL );
+	struct tm* dt = ::localtime( &t );
+	
+	pixie::datetime result;
+	result.year = dt->tm_year + 1900; 
+	result.month = dt->tm_mon + 1; 
+	result.day = dt->tm_mday; 
+	result.hour = dt->tm_hour; 
+	result.minute = dt->tm_min; 
+	result.second = dt->tm_sec; 
+	switch( dt->tm_wday )
+		{
+		case 0: result.day_of_week = DAY_SUNDAY; break;
+		case 1: result.day_of_week = DAY_MONDAY; break;
+		case 2: result.day_of_week = DAY_TUESDAY; break;
+		case 3: result.day_of_week = DAY_WEDNESDAY; break;
+		case 4: result.day_of_week = DAY_THURSDAY; break;
+		case 5: result.day_of_week = DAY_FRIDAY; break;
+		case 6: result.day_of_week = DAY_SATURDAY; break;
+		}
+
+	return result;
+	}
+
+
+pixie::i64 pixie::time() 
 	{ 
 	return (i64) ::time( 0 ); 
 	}
@@ -5155,6 +5948,333 @@ int pixie::clock()
 	}
 
 
+void* pixie::frame_alloc( size_t size )
+	{
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::frame_arena_t* arena = &internals->frame_arena;
+	size = ( size + 15 ) & ~(size_t) 15;
+	if( arena->used + size <= arena->capacity )
+		{
+		void* ptr = arena->storage + arena->used;
+		arena->used += size;
+		return ptr;
+		}
+
+	// doesn't fit, so allocate it separately for this frame. the start of the block links the overflow blocks together, 
+	// and the allocation follows it at the next 16 byte boundary (the memory tracking only guarantees 8 byte alignment)
+	void* block = TRACKED_MALLOC( internals->memctx, size + 32 );
+	*(void**) block = arena->overflow_blocks;
+	arena->overflow_blocks = block;
+	arena->overflow_size += size;
+	return (void*)( ( (uintptr_t) block + sizeof( void* ) + 15 ) & ~(uintptr_t) 15 );
+	}
+
+
+int pixie::frame_allocations()
+	{
+	internal::internals_t* internals = internal::internals();
+	return internals->last_frame_allocations;
+	}
+
+
+void pixie::internal::snapshot_layout( internals_t* internals )
+	{
+	internals_t::snapshot_t* snap = &internals->snapshot;
+	size_t words = 0;
+	for( int i = 0; i < snap->regions.count(); ++i )
+		{
+		snap->regions[ i ].offset = words;
+		words += ( snap->regions[ i ].size + 7 ) / 8;
+		}
+
+	if( snap->state ) TRACKED_FREE( internals->memctx, snap->state );
+	if( snap->scratch ) TRACKED_FREE( internals->memctx, snap->scratch );
+	snap->state = 0;
+	snap->scratch = 0;
+	snap->state_words = words;
+	if( words > 0 )
+		{
+		// padding at the end of regions is zero, and stays that way
+		snap->state = (u64*) TRACKED_MALLOC( internals->memctx, words * sizeof( u64 ) );
+		memset( snap->state, 0, words * sizeof( u64 ) );
+
+		// runs are only split by two or more unchanged words, so a delta is never more than the header word, the first
+		// run header and the state itself
+		snap->scratch = (u64*) TRACKED_MALLOC( internals->memctx, ( words + 2 ) * sizeof( u64 ) );
+		}
+
+	// the history is for the old layout, so start over
+	snap->captured = false;
+	snap->first_delta = 0;
+	snap->delta_count = 0;
+	snap->history_write = 0;
+	}
+
+
+void pixie::internal::snapshot_capture( internals_t* internals )
+	{
+	internals_t::snapshot_t* snap = &internals->snapshot;
+	if( snap->state_words == 0 ) return;
+
+	if( !snap->captured )
+		{
+		for( int i = 0; i < snap->regions.count(); ++i )
+			memcpy( snap->state + snap->regions[ i ].offset, snap->regions[ i ].data, snap->regions[ i ].size );
+		snap->captured = true;
+		return;
+		}
+
+	// xor against the previous capture, and update it to the new values on the way. the delta starts with a header word
+	// holding its size in words, followed by runs of changed words, each one prefixed by a word with the number of
+	// unchanged words to skip in the low 32 bits and the number of changed words in the high 32 bits
+	u64* out = snap->scratch + 1;
+	u64* run = 0;
+	size_t run_end = 0;
+	for( int i = 0; i < snap->regions.count(); ++i )
+		{
+		internals_t::snapshot_t::region_t const* region = &snap->regions[ i ];
+		u8 const* data = (u8 const*) region->data;
+		u64* state = snap->state + region->offset;
+		size_t words = ( region->size + 7 ) / 8;
+		size_t whole_words = region->size / 8;
+		for( size_t j = 0; j < words; ++j )
+			{
+			// most of the state is the same from one frame to the next, so skip quickly over unchanged blocks
+			if( ( j & 7 ) == 0 && j + 8 <= whole_words && memcmp( data + j * 8, state + j, 64 ) == 0 )
+				{
+				j += 7;
+				continue;
+				}
+
+			u64 value = 0;
+			memcpy( &value, data + j * 8, j < whole_words ? 8 : region->size - j * 8 );
+			u64 diff = value ^ state[ j ];
+			if( diff == 0 ) continue;
+			state[ j ] = value;
+
+			size_t index = region->offset + j;
+			if( run && index - run_end <= 1 )
+				{
+				// a single unchanged word costs the same as a new run header, so keep the run going
+				if( index > run_end )
+					{
+					*out++ = 0;
+					*run += ( (u64) 1 ) << 32;
+					}
+				}
+			else
+				{
+				run = out++;
+				*run = (u64)( index - run_end );
+				}
+			*out++ = diff;
+			*run += ( (u64) 1 ) << 32;
+			run_end = index + 1;
+			}
+		}
+	size_t size = ( out - snap->scratch ) * sizeof( u64 );
+	snap->scratch[ 0 ] = (u64)( size / sizeof( u64 ) );
+
+	if( snap->max_frames < 2 ) return;
+	int const delta_capacity = snap->max_frames - 1;
+	if( size > snap->history_capacity )
+		{
+		// too big to keep, and the older deltas can't be used without it
+		snap->first_delta = 0;
+		snap->delta_count = 0;
+		snap->history_write = 0;
+		return;
+		}
+
+	// make room by dropping the oldest deltas. deltas are never empty, so the write position only meets the oldest delta
+	// when the history is full
+	if( snap->delta_count == delta_capacity )
+		{
+		snap->first_delta = ( snap->first_delta + 1 ) % delta_capacity;
+		--snap->delta_count;
+		}
+	while( snap->delta_count > 0 )
+		{
+		size_t oldest = snap->deltas[ snap->first_delta ].offset;
+		if( snap->history_write > oldest )
+			{
+			// free space is from the write position to the end, and from the start up to the oldest delta
+			if( snap->history_capacity - snap->history_write >= size ) break;
+			if( oldest >= size )
+				{
+				snap->history_write = 0;
+				break;
+				}
+			}
+		else if( oldest - snap->history_write >= size )
+			{
+			break;
+			}
+		snap->first_delta = ( snap->first_delta + 1 ) % delta_capacity;
+		--snap->delta_count;
+		}
+	if( snap->delta_count == 0 ) snap->history_write = 0;
+
+	internals_t::snapshot_t::delta_t* delta = &snap->deltas[ ( snap->first_delta + snap->delta_count ) % delta_capacity ];
+	delta->offset = snap->history_write;
+	delta->size = size;
+	memcpy( snap->history + snap->history_write, snap->scratch, size );
+	snap->history_write += size;
+	++snap->delta_count;
+	}
+
+
+void pixie::snapshot_region( void* data, size_t size )
+	{
+	PIXIE_ASSERT( data && size > 0, "Invalid snapshot region" );
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::snapshot_t* snap = &internals->snapshot;
+	for( int i = 0; i < snap->regions.count(); ++i )
+		{
+		if( snap->regions[ i ].data == data )
+			{
+			if( snap->regions[ i ].size == size ) return;
+			snap->regions[ i ].size = size;
+			internal::snapshot_layout( internals );
+			return;
+			}
+		}
+
+	internal::internals_t::snapshot_t::region_t region;
+	region.data = data;
+	region.size = size;
+	region.offset = 0;
+	snap->regions.add( region );
+	internal::snapshot_layout( internals );
+	}
+
+
+void pixie::snapshot_remove( void const* data )
+	{
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::snapshot_t* snap = &internals->snapshot;
+	for( int i = 0; i < snap->regions.count(); ++i )
+		{
+		if( snap->regions[ i ].data == data )
+			{
+			snap->regions.remove( i );
+			internal::snapshot_layout( internals );
+			return;
+			}
+		}
+	}
+
+
+void pixie::snapshot_history( int max_frames, size_t max_bytes )
+	{
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::snapshot_t* snap = &internals->snapshot;
+	if( snap->deltas ) TRACKED_FREE( internals->memctx, snap->deltas );
+	if( snap->history ) TRACKED_FREE( internals->memctx, snap->history );
+	snap->deltas = 0;
+	snap->history = 0;
+
+	// the most recent capture is the first frame, so only max_frames - 1 deltas are needed
+	snap->max_frames = max_frames > 0 ? max_frames : 0;
+	snap->history_capacity = 0;
+	if( snap->max_frames > 1 )
+		{
+		snap->history_capacity = max_bytes & ~(size_t) 7;
+		snap->deltas = (internal::internals_t::snapshot_t::delta_t*) TRACKED_MALLOC( internals->memctx,
+			( snap->max_frames - 1 ) * sizeof( internal::internals_t::snapshot_t::delta_t ) );
+		if( snap->history_capacity > 0 ) snap->history = (u8*) TRACKED_MALLOC( internals->memctx, snap->history_capacity );
+		}
+
+	snap->captured = false;
+	snap->first_delta = 0;
+	snap->delta_count = 0;
+	snap->history_write = 0;
+	}
+
+
+int pixie::snapshot_frames()
+	{
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::snapshot_t* snap = &internals->snapshot;
+	return snap->captured ? snap->delta_count + 1 : 0;
+	}
+
+
+int pixie::snapshot_rewind( int frames )
+	{
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::snapshot_t* snap = &internals->snapshot;
+	if( !snap->captured || frames <= 0 ) return 0;
+	if( frames > snap->delta_count + 1 ) frames = snap->delta_count + 1;
+
+	// the newest delta takes the most recent capture back to the one before it, and so on
+	for( int i = 1; i < frames; ++i )
+		{
+		--snap->delta_count;
+		internal::internals_t::snapshot_t::delta_t const* delta =
+			&snap->deltas[ ( snap->first_delta + snap->delta_count ) % ( snap->max_frames - 1 ) ];
+		u64 const* in = (u64 const*)( snap->history + delta->offset ) + 1;
+		u64 const* end = (u64 const*)( snap->history + delta->offset + delta->size );
+		u64* state = snap->state;
+		while( in < end )
+			{
+			state += (u32)( *in );
+			u64 const* run_end = in + 1 + ( *in >> 32 );
+			for( ++in; in < run_end; ++in ) *state++ ^= *in;
+			}
+		snap->history_write = delta->offset;
+		}
+
+	for( int i = 0; i < snap->regions.count(); ++i )
+		memcpy( snap->regions[ i ].data, snap->state + snap->regions[ i ].offset, snap->regions[ i ].size );
+	return frames;
+	}
+
+
+bool pixie::snapshot_save( binary_writer* writer )
+	{
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::snapshot_t* snap = &internals->snapshot;
+	u32 count = (u32) snap->regions.count();
+	if( writer->write( &count ) != 1 ) return false;
+	for( int i = 0; i < snap->regions.count(); ++i )
+		{
+		u64 size = (u64) snap->regions[ i ].size;
+		if( writer->write( &size ) != 1 ) return false;
+		if( writer->write_bytes( snap->regions[ i ].data, snap->regions[ i ].size ) != snap->regions[ i ].size ) return false;
+		}
+	return true;
+	}
+
+
+bool pixie::snapshot_load( binary_reader* reader )
+	{
+	internal::internals_t* internals = internal::internals();
+	internal::internals_t::snapshot_t* snap = &internals->snapshot;
+	size_t start = reader->position();
+
+	// check that the saved regions match before overwriting any of them
+	u32 count = 0;
+	bool valid = reader->read( &count ) == 1 && count == (u32) snap->regions.count();
+	for( int i = 0; valid && i < snap->regions.count(); ++i )
+		{
+		u64 size = 0;
+		valid = reader->read( &size ) == 1 && size == (u64) snap->regions[ i ].size && reader->view( snap->regions[ i ].size );
+		}
+	reader->position( start );
+	if( !valid ) return false;
+
+	reader->read( &count );
+	for( int i = 0; i < snap->regions.count(); ++i )
+		{
+		u64 size = 0;
+		reader->read( &size );
+		reader->read_bytes( snap->regions[ i ].data, snap->regions[ i ].size );
+		}
+	return true;
+	}
+
+
 float pixie::delta_time() 
 	{ 
 	internal::internals_t* internals = internal::internals();
@@ -5165,10 +6285,49 @@ float pixie::delta_time()
 size_t pixie::mem_used( int* alloc_count, size_t* peak_use )
 	{
 	internal::internals_t* internals = internal::internals();
-	pixie::internal::memtrack_t* memtrack = (pixie::internal::memtrack_t*) internals->memctx;
-	if( alloc_count ) *alloc_count = memtrack->count;
-	if( peak_use ) *peak_use = (size_t) memtrack->peak; 
-	return (size_t) memtrack->current;
+	mem_usage usage = internal::memtrack_usage( internal::tagged_memctx( internals->memctx, MEM_TAG_COUNT ) );
+	if( alloc_count ) *alloc_count = usage.count;
+	if( peak_use ) *peak_use = (size_t) usage.peak; 
+	return (size_t) usage.current;
+	}
+
+
+size_t pixie::mem_used( mem_tag tag, int* alloc_count, size_t* peak_use )
+	{
+	PIXIE_ASSERT( tag >= 0 && tag < MEM_TAG_COUNT, "Invalid memory tag" );
+	internal::internals_t* internals = internal::internals();
+	mem_usage usage = internal::memtrack_usage( internal::tagged_memctx( internals->memctx, tag ) );
+	if( alloc_count ) *alloc_count = usage.count;
+	if( peak_use ) *peak_use = (size_t) usage.peak; 
+	return (size_t) usage.current;
+	}
+
+
+pixie::mem_snapshot pixie::mem_take_snapshot()
+	{
+	internal::internals_t* internals = internal::internals();
+	mem_snapshot snapshot;
+	snapshot.total = internal::memtrack_usage( internal::tagged_memctx( internals->memctx, MEM_TAG_COUNT ) );
+	for( int i = 0; i < MEM_TAG_COUNT; ++i )
+		snapshot.tags[ i ] = internal::memtrack_usage( internal::tagged_memctx( internals->memctx, i ) );
+	return snapshot;
+	}
+
+
+// for leak hunting - a non-zero current in the result is memory allocated between the snapshots which is still in use
+pixie::mem_snapshot pixie::mem_diff( mem_snapshot const& before, mem_snapshot const& after )
+	{
+	mem_snapshot diff;
+	diff.total.current = after.total.current - before.total.current;
+	diff.total.peak = after.total.peak - before.total.peak;
+	diff.total.count = after.total.count - before.total.count;
+	for( int i = 0; i < MEM_TAG_COUNT; ++i )
+		{
+		diff.tags[ i ].current = after.tags[ i ].current - before.tags[ i ].current;
+		diff.tags[ i ].peak = after.tags[ i ].peak - before.tags[ i ].peak;
+		diff.tags[ i ].count = after.tags[ i ].count - before.tags[ i ].count;
+		}
+	return diff;
 	}
 
 void pixie::request_exit()
@@ -5312,6 +6471,7 @@ void pixie::internal::resize_screen()
 	internals->screen_bitmap.internal.storage = 0;
 	internals->screen_bitmap.internal.cels_normal = &internals->screen_bitmap_cels;
 	internals->screen_bitmap.internal.type = bitmap::internal_t::DATA_TYPE_NORMAL;
+	internals->screen_bitmap.internal.shared = false;
 	internals->screen_bitmap.internal.cels_normal->offset_x = 0;
 	internals->screen_bitmap.internal.cels_normal->offset_y = 0; 
 	internals->screen_bitmap.internal.cels_normal->pitch_x = internals->screen_width; 
@@ -5773,6 +6933,12 @@ void pixie::cpu_bar()
 bool pixie::file_exists( string const& filename )
 	{
 	internal::internals_t* internals = internal::internals();
+
+	// same lookup order as bload, so that files in a mounted pack are found too
+	u8* pack_data = 0;
+	size_t pack_size = 0;
+	if( internal::pack_find( &internals->pack, filename.c_str(), &pack_data, &pack_size ) ) return true;
+
 	if( internals->resources_mounted ) 
 		{
 		assetsys_file_t file;
@@ -5905,10 +7071,11 @@ pixie::array<pixie::dir_info> pixie::dir( string const& path, bool recursive )
 	}
 
 
-void* pixie::mem_alloc( size_t size )
+void* pixie::mem_alloc( size_t size, int tag )
 	{
+	PIXIE_ASSERT( tag >= 0 && tag < MEM_TAG_COUNT, "Invalid memory tag" );
 	internal::internals_t* internals = internal::internals();
-	return TRACKED_MALLOC( internals->memctx, size );
+	return TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, tag ), size );
 	}
 
 
@@ -5933,14 +7100,25 @@ void binary_delete( void* instance )
 pixie::ref<pixie::binary> pixie::bload( string const& filename )
 	{
 	internal::internals_t* internals = internal::internals();
-	if( internals->resources_mounted )
+	u8* pack_data = 0;
+	size_t pack_size = 0;
+	if( internal::pack_find( &internals->pack, filename.c_str(), &pack_data, &pack_size ) )
+		{
+		// reference the mapped data in place - pack files always have a zero byte after each file, so text files work too
+		void* storage = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_RESOURCE ), sizeof( binary ) + sizeof( int ) );
+		binary* bin = (binary*)storage;
+		bin->data = pack_data;
+		bin->size = pack_size;
+		return refcount::make_ref( bin, internal::binary_delete, (int*)( (uintptr_t)storage + sizeof( binary ) ), 0 );
+		}
+	else if( internals->resources_mounted )
 		{
 		assetsys_file_t file;   
 		assetsys_error_t error = assetsys_file( internals->assetsys, ( "/resources/" + filename ).c_str(), &file );
 		if( error != ASSETSYS_SUCCESS ) ref<binary>::ref();
 
 		int file_size = assetsys_file_size( internals->assetsys, file );        
-		void* storage = TRACKED_MALLOC( internals->memctx, sizeof( binary ) + sizeof( int ) + file_size + 1 ); // one extra for zero terminator
+		void* storage = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_RESOURCE ), sizeof( binary ) + sizeof( int ) + file_size + 1 ); // one extra for zero terminator
 		void* file_data = (void*)( (uintptr_t)storage + sizeof( binary ) + sizeof( int ) );
 		error = assetsys_file_load( internals->assetsys, file, 0, file_data, file_size );
 		PIXIE_ASSERTF( error == ASSETSYS_SUCCESS, ( "Failed to load file: %s", filename.c_str() ) );
@@ -5964,7 +7142,7 @@ pixie::ref<pixie::binary> pixie::bload( string const& filename )
 		FILE* file = fopen( filename.c_str(), "rb" );
 		PIXIE_ASSERTF( file, ( "Failed to load file: %s", filename.c_str() ) );
 		if( !file ) return ref<binary>::ref();
-		void* storage = TRACKED_MALLOC( internals->memctx, sizeof( binary ) + sizeof( int ) + file_size + 1 ); // one extra for zero terminator
+		void* storage = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_RESOURCE ), sizeof( binary ) + sizeof( int ) + file_size + 1 ); // one extra for zero terminator
 		void* file_data = (void*)( (uintptr_t)storage + sizeof( binary ) + sizeof( int ) );
 		fread( file_data, 1, file_size, file );
 		fclose( file );
@@ -5981,7 +7159,7 @@ pixie::ref<pixie::binary> pixie::bload( string const& filename )
 pixie::ref<pixie::binary> pixie::bnew( size_t size )
 	{
 	internal::internals_t* internals = internal::internals();
-	void* storage = TRACKED_MALLOC( internals->memctx, sizeof( binary ) + sizeof( int ) + size ); 
+	void* storage = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_RESOURCE ), sizeof( binary ) + sizeof( int ) + size ); 
 	binary* bin = (binary*)storage;
 	bin->data = (u8*)( (uintptr_t)storage + sizeof( binary ) + sizeof( int ) );
 	bin->size = (size_t)size;
@@ -6181,6 +7359,20 @@ int pixie::binary_reader::read( double* value, int count )
 	}
 
 
+size_t pixie::binary_reader::read_bytes( void* data, size_t size )
+	{
+	internal::binary_reader_internals_t* rw = (internal::binary_reader_internals_t*) internals_;
+	return binary_rw_reader_bytes( &rw->reader, data, size );
+	}
+
+
+void const* pixie::binary_reader::view( size_t size )
+	{
+	internal::binary_reader_internals_t* rw = (internal::binary_reader_internals_t*) internals_;
+	return binary_rw_reader_view( &rw->reader, size );
+	}
+
+
 pixie::binary_writer::binary_writer( ref<binary> const& bin, bool resize )
 	{    
 	bin_ = bin;
@@ -6313,25 +7505,39 @@ int pixie::binary_writer::write( double const* value, int count )
 	internal::binary_writer_internals_t* rw = (internal::binary_writer_internals_t*) internals_;
 	return binary_rw_writer_double( &rw->writer, value, count );
 	}
+
+
+size_t pixie::binary_writer::write_bytes( void const* data, size_t size )
+	{
+	internal::binary_writer_internals_t* rw = (internal::binary_writer_internals_t*) internals_;
+	return binary_rw_writer_bytes( &rw->writer, data, size );
+	}
 	
 
 pixie::ini_file pixie::ini_load( ref<binary> const& bin )
 	{
 	internal::internals_t* internals = internal::internals();
-	ini_t* in = ::ini_load( (char const*) bin->data, internals->memctx );
+	// the view references the loaded data directly, so names and values are only copied once, into the strings
+	ini_view_t* in = ini_view_load( (char const*) bin->data, (int) bin->size, internals->memctx );
 	
 	ini_file ini;
-	for( int i = 0; i < ini_property_count( in, INI_GLOBAL_SECTION ); ++i )
-		ini.global[ ini_property_name( in, INI_GLOBAL_SECTION, i ) ] = ini_property_value( in, INI_GLOBAL_SECTION, i );
-
-	for( int j = 1; j < ini_section_count( in ); ++j )
+	for( int j = 0; j < ini_view_section_count( in ); ++j )
 		{
-		ini_section& section = ini.sections[ ini_section_name( in, j ) ];
-		for( int i = 0; i < ini_property_count( in, j ); ++i )
-			section[ ini_property_name( in, j, i ) ] = ini_property_value( in, j, i );
+		int length = 0;
+		char const* name = ini_view_section_name( in, j, &length );
+		ini_section& section = j == INI_GLOBAL_SECTION ? ini.global : ini.sections[ string( name, name + length ) ];
+		for( int i = 0; i < ini_view_property_count( in, j ); ++i )
+			{
+			int name_length = 0;
+			int value_length = 0;
+			char const* property_name = ini_view_property_name( in, j, i, &name_length );
+			char const* property_value = ini_view_property_value( in, j, i, &value_length );
+			section[ string( property_name, property_name + name_length ) ] = 
+				string( property_value, property_value + value_length );
+			}
 		}
 
-	ini_destroy( in );
+	ini_view_destroy( in );
 	return ini;
 	}
 
@@ -6528,27 +7734,25 @@ float pixie::pen_pressure()
 	}
 
 
-void pixie::time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data )
+pixie::u64 pixie::time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data )
 	{
 	internal::internals_t* internals = internal::internals();
-	internal::time_event_t& event = internals->time_events.add();
-	event.handler = handler;
-	event.seconds = seconds;
-	event.repeat = 0.0f;
-	event.event_id = event_id;
-	event.user_data = user_data;
+	return internal::time_event_add( internals, handler, seconds, 0.0f, event_id, user_data );
 	}
 
 
-void pixie::repeating_time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data )
+pixie::u64 pixie::repeating_time_event( event_handler* handler, float seconds, string_id const& event_id, void* user_data )
 	{
 	internal::internals_t* internals = internal::internals();
-	internal::time_event_t& event = internals->time_events.add();
-	event.handler = handler;
-	event.seconds = seconds;
-	event.repeat = seconds;
-	event.event_id = event_id;
-	event.user_data = user_data;
+	return internal::time_event_add( internals, handler, seconds, seconds, event_id, user_data );
+	}
+
+
+void pixie::cancel_time_event( u64 id )
+	{
+	internal::internals_t* internals = internal::internals();
+	int index = handles_index( &internals->time_event_handles, handles_from_u64( &internals->time_event_handles, id ) );
+	if( index >= 0 ) internal::time_event_remove( internals, index );
 	}
 
 
@@ -6662,6 +7866,7 @@ void pixie::gamepad_pressed_event( event_handler* handler, int pad_index, gamepa
 	if( !gamepad_connected( pad_index ) ) return;
 	internal::internals_t* internals = internal::internals();
 	internal::gamepadbutton_event_t& event = internals->gamepad_pressed_events.add();
+	internals->gamepad_pressed_dispatch.dirty = true;
 	event.handler = handler;
 	event.pad_index = pad_index;
 	event.button = button;
@@ -6675,6 +7880,7 @@ void pixie::gamepad_released_event( event_handler* handler, int pad_index, gamep
 	if( !gamepad_connected( pad_index ) ) return;
 	internal::internals_t* internals = internal::internals();
 	internal::gamepadbutton_event_t& event = internals->gamepad_released_events.add();
+	internals->gamepad_released_dispatch.dirty = true;
 	event.handler = handler;
 	event.pad_index = pad_index;
 	event.button = button;
@@ -6725,6 +7931,7 @@ void pixie::key_pressed_event( event_handler* handler, key_id key, string_id con
 	{
 	internal::internals_t* internals = internal::internals();
 	internal::key_event_t& event = internals->key_pressed_events.add();
+	internals->key_pressed_dispatch.dirty = true;
 	event.handler = handler;
 	event.key = key;
 	event.event_id = event_id;
@@ -6736,6 +7943,7 @@ void pixie::key_released_event( event_handler* handler, key_id key, string_id co
 	{
 	internal::internals_t* internals = internal::internals();
 	internal::key_event_t& event = internals->key_released_events.add();
+	internals->key_released_dispatch.dirty = true;
 	event.handler = handler;
 	event.key = key;
 	event.event_id = event_id;
@@ -6967,14 +8175,12 @@ void pixie::remove_event_handler( event_handler* handler )
 	{
 	internal::internals_t* internals = internal::internals();
 
-	for( int i = 0; i < internals->time_events.count(); ++i )
-		{
-		if( internals->time_events[ i ].handler == handler )
-			{
-			internals->time_events.remove( i );
-			--i;
-			}
-		}
+	internal::time_event_remove_handler( internals, handler );
+
+	internals->key_pressed_dispatch.dirty = true;
+	internals->key_released_dispatch.dirty = true;
+	internals->gamepad_pressed_dispatch.dirty = true;
+	internals->gamepad_released_dispatch.dirty = true;
 
 	for( int i = 0; i < internals->key_pressed_events.count(); ++i )
 		{
@@ -7849,27 +9055,462 @@ bool pixie::starts_with( string_id str, string_id start )
 
 namespace pixie { namespace internal {
 
-bitmap* load_bitmap( string const& filename )
+struct bitmap_loader
+	{
+	// sets up cels which point straight into the pix data, rather than copying it, for pix files in a mounted pack
+	static void init_mapped( bitmap* instance, int width, int height, int cel_count, bool is_masked, u8* data )
+		{
+		internal::internals_t* internals = internal::internals();
+
+		bitmap::internal_t& internal = instance->internal;
+		internal.cel_count = cel_count;
+		internal.width = width;
+		internal.height = height;    
+		internal.storage = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), sizeof( bitmap::internal_t::normal_cel ) * cel_count );
+		internal.type = bitmap::internal_t::DATA_TYPE_NORMAL;
+		internal.shared = true;
+		internal.cels_normal = (bitmap::internal_t::normal_cel*) internal.storage;
+		for( int i = 0; i < cel_count; ++i )
+			{
+			bitmap::internal_t::normal_cel& cel = internal.cels_normal[ i ];
+			cel.offset_x = *(int*) data; data += sizeof( int );
+			cel.offset_y = *(int*) data; data += sizeof( int );
+			cel.pitch_x = *(int*) data; data += sizeof( int );
+			cel.pitch_y = *(int*) data; data += sizeof( int );
+			cel.pixels = data;
+			data += cel.pitch_x * cel.pitch_y;
+			cel.mask = 0;
+			if( is_masked ) 
+				{
+				cel.mask = data;
+				data += cel.pitch_x * cel.pitch_y;
+				}
+			}
+		}
+
+
+	// sets up cels pointing into the pixel data of a loaded atlas
+	static void init_atlas( bitmap* instance, u8* entry, u8* data )
+		{
+		internal::internals_t* internals = internal::internals();
+
+		int const* entry_info = (int const*) entry;
+		int cel_count = entry_info[ 3 ];
+		int const* cel_info = entry_info + 5;
+
+		bitmap::internal_t& internal = instance->internal;
+		internal.cel_count = cel_count;
+		internal.width = entry_info[ 1 ];
+		internal.height = entry_info[ 2 ];    
+		internal.storage = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), sizeof( bitmap::internal_t::normal_cel ) * cel_count );
+		internal.type = bitmap::internal_t::DATA_TYPE_NORMAL;
+		internal.shared = true;
+		internal.cels_normal = (bitmap::internal_t::normal_cel*) internal.storage;
+		for( int i = 0; i < cel_count; ++i )
+			{
+			bitmap::internal_t::normal_cel& cel = internal.cels_normal[ i ];
+			cel.offset_x = cel_info[ 0 ];
+			cel.offset_y = cel_info[ 1 ];
+			cel.pitch_x = cel_info[ 2 ];
+			cel.pitch_y = cel_info[ 3 ];
+			cel.pixels = data + cel_info[ 4 ];
+			cel.mask = cel_info[ 5 ] >= 0 ? data + cel_info[ 5 ] : 0;
+			cel_info += 6;
+			}
+		}
+
+
+	// sets up delta cels (version 3), where copied cels share pixel data with the cel they copy, and patched cels only
+	// store the area which differs from their base cel. Patch data is copied, unless it is in a mapped pack. returns false
+	// if the data is corrupt, in which case the bitmap should be destroyed without being used
+	static bool init_delta( bitmap* instance, int width, int height, int cel_count, bool is_masked, u8* data, 
+		u8 const* data_end, bool is_mapped )
+		{
+		internal::internals_t* internals = internal::internals();
+
+		if( cel_count <= 0 ) return false;
+		size_t size = sizeof( bitmap::internal_t::delta_cel ) * cel_count;
+		u8* cel_data = data;
+		for( int i = 0; i < cel_count; ++i )
+			{
+			if( data_end - cel_data < (ptrdiff_t)( sizeof( int ) * 9 ) ) return false;
+			int const* cel_info = (int const*) cel_data;
+			cel_data += sizeof( int ) * 9;
+			if( cel_info[ 2 ] < 0 || cel_info[ 3 ] < 0 || cel_info[ 7 ] < 0 || cel_info[ 8 ] < 0 ) return false;
+			if( cel_info[ 3 ] > 0 && cel_info[ 2 ] > 0x7fffffff / cel_info[ 3 ] ) return false;
+			if( cel_info[ 8 ] > 0 && cel_info[ 7 ] > 0x3fffffff / cel_info[ 8 ] ) return false;
+			size_t patch_size = (size_t) cel_info[ 7 ] * cel_info[ 8 ] * ( is_masked ? 2 : 1 );
+			if( (size_t)( data_end - cel_data ) < patch_size ) return false;
+			if( !is_mapped ) size += patch_size;
+			cel_data += patch_size;
+			}
+
+		u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
+		bitmap::internal_t& internal = instance->internal;
+		internal.cel_count = cel_count;
+		internal.width = width;
+		internal.height = height;    
+		internal.storage = storage;
+		internal.type = bitmap::internal_t::DATA_TYPE_DELTA;
+		internal.cels_delta = (bitmap::internal_t::delta_cel*) storage;
+		storage += sizeof( bitmap::internal_t::delta_cel ) * cel_count;
+		for( int i = 0; i < cel_count; ++i )
+			{
+			int const* cel_info = (int const*) data; 
+			data += sizeof( int ) * 9;
+			int count = cel_info[ 7 ] * cel_info[ 8 ];
+			u8* pixels = data;
+			data += count;
+			u8* mask = is_masked ? data : 0;
+			data += is_masked ? count : 0;
+			if( !is_mapped )
+				{
+				memcpy( storage, pixels, (size_t) count );
+				pixels = storage;
+				storage += count;
+				if( mask )
+					{
+					memcpy( storage, mask, (size_t) count );
+					mask = storage;
+					storage += count;
+					}
+				}
+
+			bitmap::internal_t::delta_cel& cel = internal.cels_delta[ i ];
+			int base = cel_info[ 4 ];
+			if( base >= i ) return false;
+			if( base < 0 )
+				{
+				// a cel with no base stores all of its pixels
+				if( cel_info[ 7 ] != cel_info[ 2 ] || cel_info[ 8 ] != cel_info[ 3 ] ) return false;
+				cel.base.offset_x = cel_info[ 0 ];
+				cel.base.offset_y = cel_info[ 1 ];
+				cel.base.pitch_x = cel_info[ 2 ];
+				cel.base.pitch_y = cel_info[ 3 ];
+				cel.base.pixels = pixels;
+				cel.base.mask = mask;
+				memset( &cel.patch, 0, sizeof( cel.patch ) );
+				}
+			else
+				{
+				cel = internal.cels_delta[ base ];
+				if( count > 0 )
+					{
+					// the patch is copied into the base cel's pixels when expanded, so it has to fit inside it
+					int patch_x = cel_info[ 0 ] + cel_info[ 5 ] - cel.base.offset_x;
+					int patch_y = cel_info[ 1 ] + cel_info[ 6 ] - cel.base.offset_y;
+					if( patch_x < 0 || patch_y < 0 || patch_x > cel.base.pitch_x - cel_info[ 7 ] || 
+						patch_y > cel.base.pitch_y - cel_info[ 8 ] ) 
+						{
+						return false;
+						}
+					cel.patch.offset_x = cel_info[ 0 ] + cel_info[ 5 ];
+					cel.patch.offset_y = cel_info[ 1 ] + cel_info[ 6 ];
+					cel.patch.pitch_x = cel_info[ 7 ];
+					cel.patch.pitch_y = cel_info[ 8 ];
+					cel.patch.pixels = pixels;
+					cel.patch.mask = mask;
+					}
+				}
+			}
+		return true;
+		}
+
+
+	// converts delta cels to normal cels, each with its own pixels, for when they are about to be modified
+	static void expand_delta( bitmap* instance )
+		{
+		internal::internals_t* internals = internal::internals();
+
+		bitmap::internal_t& internal = instance->internal;
+		size_t size = sizeof( bitmap::internal_t::normal_cel ) * internal.cel_count;
+		for( int i = 0; i < internal.cel_count; ++i )
+			{
+			bitmap::internal_t::normal_cel const& base = internal.cels_delta[ i ].base;
+			size += (size_t) base.pitch_x * base.pitch_y * ( base.mask ? 2 : 1 );
+			}
+
+		u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
+		bitmap::internal_t::normal_cel* cels = (bitmap::internal_t::normal_cel*) storage;
+		storage += sizeof( bitmap::internal_t::normal_cel ) * internal.cel_count;
+		for( int i = 0; i < internal.cel_count; ++i )
+			{
+			bitmap::internal_t::delta_cel const& delta = internal.cels_delta[ i ];
+			bitmap::internal_t::normal_cel& cel = cels[ i ];
+			cel = delta.base;
+			int count = cel.pitch_x * cel.pitch_y;
+			cel.pixels = storage;
+			memcpy( storage, delta.base.pixels, (size_t) count );
+			storage += count;
+			if( cel.mask )
+				{
+				cel.mask = storage;
+				memcpy( storage, delta.base.mask, (size_t) count );
+				storage += count;
+				}
+
+			int patch_x = delta.patch.offset_x - cel.offset_x;
+			int patch_y = delta.patch.offset_y - cel.offset_y;
+			for( int y = 0; y < delta.patch.pitch_y; ++y )
+				{
+				memcpy( cel.pixels + patch_x + ( patch_y + y ) * cel.pitch_x, delta.patch.pixels + y * delta.patch.pitch_x, (size_t) delta.patch.pitch_x );
+				if( cel.mask ) 
+					memcpy( cel.mask + patch_x + ( patch_y + y ) * cel.pitch_x, delta.patch.mask + y * delta.patch.pitch_x, (size_t) delta.patch.pitch_x );
+				}
+			}
+
+		TRACKED_FREE( internals->memctx, internal.storage );
+		internal.storage = cels;
+		internal.type = bitmap::internal_t::DATA_TYPE_NORMAL;
+		internal.shared = false;
+		internal.cels_normal = cels;
+		}
+
+
+	// gives cels which point into a mapped pack or an atlas pixels of their own, so that modifying them doesn't change 
+	// other bitmaps loaded from the same data
+	static void copy_shared( bitmap* instance )
+		{
+		internal::internals_t* internals = internal::internals();
+
+		bitmap::internal_t& internal = instance->internal;
+		size_t size = sizeof( bitmap::internal_t::normal_cel ) * internal.cel_count;
+		for( int i = 0; i < internal.cel_count; ++i )
+			{
+			bitmap::internal_t::normal_cel const& cel = internal.cels_normal[ i ];
+			size += (size_t) cel.pitch_x * cel.pitch_y * ( cel.mask ? 2 : 1 );
+			}
+
+		u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
+		bitmap::internal_t::normal_cel* cels = (bitmap::internal_t::normal_cel*) storage;
+		storage += sizeof( bitmap::internal_t::normal_cel ) * internal.cel_count;
+		for( int i = 0; i < internal.cel_count; ++i )
+			{
+			bitmap::internal_t::normal_cel& cel = cels[ i ];
+			cel = internal.cels_normal[ i ];
+			int count = cel.pitch_x * cel.pitch_y;
+			cel.pixels = storage;
+			memcpy( storage, internal.cels_normal[ i ].pixels, (size_t) count );
+			storage += count;
+			if( cel.mask )
+				{
+				cel.mask = storage;
+				memcpy( storage, internal.cels_normal[ i ].mask, (size_t) count );
+				storage += count;
+				}
+			}
+
+		TRACKED_FREE( internals->memctx, internal.storage );
+		internal.storage = cels;
+		internal.shared = false;
+		internal.cels_normal = cels;
+		}
+
+
+	// bitmaps are modified in place, so delta cels and shared cels are given pixels of their own first
+	static void prepare_write( bitmap* instance )
+		{
+		if( instance->internal.type == bitmap::internal_t::DATA_TYPE_DELTA ) expand_delta( instance );
+		else if( instance->internal.shared ) copy_shared( instance );
+		}
+
+
+	// returns the part of a delta cel which holds the pixel at x, y (in bitmap coordinates)
+	static bitmap::internal_t::normal_cel const& delta_source( bitmap::internal_t::delta_cel const& cel, int x, int y )
+		{
+		bool in_patch = x >= cel.patch.offset_x && x < cel.patch.offset_x + cel.patch.pitch_x && 
+			y >= cel.patch.offset_y && y < cel.patch.offset_y + cel.patch.pitch_y;
+		return in_patch ? cel.patch : cel.base;
+		}
+
+
+	// returns 0 if the data is corrupt, without reading past src_end or writing more than count bytes
+	static u8 const* rle_decode( u8 const* src, u8 const* src_end, u8* dst, int count )
+		{
+		u8* end = dst + count;
+		while( dst < end )
+			{
+			if( src >= src_end ) return 0;
+			int c = *src++;
+			int n = ( c & 0x80 ) ? ( c & 0x7f ) + 3 : c + 1;
+			if( n > end - dst ) return 0;
+			if( c & 0x80 ) 
+				{
+				if( src >= src_end ) return 0;
+				memset( dst, *src++, (size_t) n );
+				}
+			else 
+				{
+				if( n > src_end - src ) return 0;
+				memcpy( dst, src, (size_t) n );
+				src += n;
+				}
+			dst += n;
+			}
+		return src;
+		}
+
+
+	// decodes rle compressed pix data (version 2), into a single allocation holding all the cels. returns false if the 
+	// data is corrupt, in which case the bitmap should be destroyed without being used
+	static bool init_compressed( bitmap* instance, int width, int height, int cel_count, bool is_masked, u8 const* data, 
+		u8 const* data_end )
+		{
+		internal::internals_t* internals = internal::internals();
+
+		if( cel_count <= 0 ) return false;
+		size_t size = sizeof( bitmap::internal_t::normal_cel ) * cel_count;
+		u8 const* cel_data = data;
+		for( int i = 0; i < cel_count; ++i )
+			{
+			if( data_end - cel_data < (ptrdiff_t)( sizeof( int ) * 7 ) ) return false;
+			int const* cel_info = (int const*) cel_data;
+			cel_data += sizeof( int ) * 7;
+			if( cel_info[ 2 ] < 0 || cel_info[ 3 ] < 0 || cel_info[ 4 ] < 0 || cel_info[ 6 ] < 0 ) return false;
+			if( cel_info[ 3 ] > 0 && cel_info[ 2 ] > 0x7fffffff / cel_info[ 3 ] ) return false;
+			if( data_end - cel_data < (ptrdiff_t) cel_info[ 4 ] + cel_info[ 6 ] ) return false;
+			size += (size_t) cel_info[ 2 ] * cel_info[ 3 ] * ( is_masked ? 2 : 1 );
+			cel_data += cel_info[ 4 ] + cel_info[ 6 ];
+			}
+
+		u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
+		bitmap::internal_t& internal = instance->internal;
+		internal.cel_count = cel_count;
+		internal.width = width;
+		internal.height = height;    
+		internal.storage = storage;
+		internal.type = bitmap::internal_t::DATA_TYPE_NORMAL;
+		internal.cels_normal = (bitmap::internal_t::normal_cel*) storage;
+		storage += sizeof( bitmap::internal_t::normal_cel ) * cel_count;
+		for( int i = 0; i < cel_count; ++i )
+			{
+			int const* cel_info = (int const*) data; 
+			data += sizeof( int ) * 7;
+			bitmap::internal_t::normal_cel& cel = internal.cels_normal[ i ];
+			cel.offset_x = cel_info[ 0 ];
+			cel.offset_y = cel_info[ 1 ];
+			cel.pitch_x = cel_info[ 2 ];
+			cel.pitch_y = cel_info[ 3 ];
+			int count = cel.pitch_x * cel.pitch_y;
+			cel.pixels = storage;
+			storage += count;
+			if( !rle_decode( data, data + cel_info[ 4 ], cel.pixels, count ) ) return false;
+			data += cel_info[ 4 ];
+			cel.mask = 0;
+			if( is_masked ) 
+				{
+				cel.mask = storage;
+				storage += count;
+				if( cel_info[ 5 ] == 1 )
+					{
+					// expand from one bit per pixel in place, back to front so packed bytes are read before being overwritten
+					if( !rle_decode( data, data + cel_info[ 6 ], cel.mask, ( count + 7 ) / 8 ) ) return false;
+					for( int j = count - 1; j >= 0; --j ) 
+						cel.mask[ j ] = ( cel.mask[ j >> 3 ] & ( 0x80 >> ( j & 7 ) ) ) ? (u8) 0xff : (u8) 0;
+					}
+				else if( cel_info[ 5 ] == 2 )
+					{
+					if( !rle_decode( data, data + cel_info[ 6 ], cel.mask, count ) ) return false;
+					}
+				else
+					{
+					memset( cel.mask, 0xff, (size_t) count );
+					}
+				data += cel_info[ 6 ];
+				}
+			}
+		return true;
+		}
+	};
+
+
+// maps rgba pixels to the closest palette index, and alpha to mask values. safe to call from any thread
+void match_palette( u32 const* img, int count, rgb const* palette, u8* pixels, u8* mask )
+	{
+	for( int i = 0; i < count; ++i )
+		{
+		int best_index = 0;
+		int min_distance_sq = 2147483647;
+		u32 color = img[ i ];
+		int cb = (int)( ( color >> 16 ) & 0xff );
+		int cg = (int)( ( color >> 8 ) & 0xff );
+		int cr = (int)( ( color ) & 0xff );
+		int cl = ( 54 * cr + 183 * cg + 19 * cb + 127 ) >> 8;
+
+		for( int j = 0; j < 256; ++j ) 
+			{
+			int pr = (int)palette[ j ].r;
+			int pg = (int)palette[ j ].g;
+			int pb = (int)palette[ j ].b;
+			int pl = ( 54 * pr + 183 * pg + 19 * pb + 127 ) >> 8;
+			int dr = cr - pr;
+			int dg = cg - pg;
+			int db = cb - pb;
+			int dl = cl - pl;
+			int d = ( ( ( ( dr * dr + dg * dg + db * db ) >> 1 ) + dl * dl ) * 38 + 127 ) >> 8;
+			int distance_sq = ( ( ( dr*dr + dg*dg + db*db ) >> 1 ) + dl*dl ) + d;
+			if( distance_sq < min_distance_sq ) 
+				{
+				min_distance_sq = distance_sq;
+				best_index = j;
+				}
+			}
+		pixels[ i ] = (u8) best_index;
+		}
+
+	for( int i = 0; i < count; ++i ) mask[ i ] = (u8)( img[ i ] >> 24 );
+	}
+
+
+// creates a bitmap from a file which has already been loaded, either compiled pix data or any image stb_image can decode
+bitmap* load_bitmap( string const& filename, ref<binary> const& bin )
 	{
 	internal::internals_t* internals = internal::internals();
 
-	bitmap* instance = 0;
-	ref<binary> bin = bload( filename );
-	PIXIE_ASSERTF( bin, ( "Failed to load bitmap: %s", filename.c_str() ) );
+	bitmap* instance = 0;
 	if( bin )
 		{
 		char const header[] = "PIXIE_PIX";
 		if( memcmp( bin->data, header, sizeof( header ) ) == 0 )
 			{
 			int* info = (int*)( (uintptr_t)bin->data + sizeof( header ) );
-			int supported_version = 1;
+			int supported_version = 3; // version 2 adds rle compressed bitmaps, version 3 delta cels, raw bitmaps are still version 1
 			int file_version = *info++;
-			PIXIE_ASSERT( file_version == supported_version, "Invalid file version" );
-			if( file_version == supported_version )
+			PIXIE_ASSERT( file_version >= 1 && file_version <= supported_version, "Invalid file version" );
+			if( file_version >= 1 && file_version <= supported_version )
 				{
 				int type = info[ 0 ];
-				PIXIE_ASSERT( type == 0, "Unknown bitmap type" );
-				if( type == 0 )
+				PIXIE_ASSERT( type == 0 || ( type == 1 && file_version >= 2 ) || ( type == 2 && file_version >= 3 ), "Unknown bitmap type" );
+				if( type == 2 && file_version >= 3 )
+					{
+					u8* data = (u8*)( info + 5 );
+					void* storage = internals->pool_bitmap_and_refcount.create();
+					instance = new (storage) bitmap();
+					bool valid = bitmap_loader::init_delta( instance, info[ 1 ], info[ 2 ], info[ 3 ], info[ 4 ] != 0, data, 
+						(u8 const*) bin->data + bin->size, pack_contains( &internals->pack, data ) );
+					PIXIE_ASSERTF( valid, ( "Corrupt bitmap data: %s", filename.c_str() ) );
+					if( !valid )
+						{
+						instance->~bitmap();
+						internals->pool_bitmap_and_refcount.destroy( (bitmap_and_refcount*) instance );
+						instance = 0;
+						}
+					}
+				else if( type == 1 && file_version >= 2 )
+					{
+					void* storage = internals->pool_bitmap_and_refcount.create();
+					instance = new (storage) bitmap();
+					bool valid = bitmap_loader::init_compressed( instance, info[ 1 ], info[ 2 ], info[ 3 ], info[ 4 ] != 0, 
+						(u8 const*)( info + 5 ), (u8 const*) bin->data + bin->size );
+					PIXIE_ASSERTF( valid, ( "Corrupt bitmap data: %s", filename.c_str() ) );
+					if( !valid )
+						{
+						instance->~bitmap();
+						internals->pool_bitmap_and_refcount.destroy( (bitmap_and_refcount*) instance );
+						instance = 0;
+						}
+					}
+				else if( type == 0 )
 					{
 					int w = info[ 1 ];
 					int h = info[ 2 ];
@@ -7877,9 +9518,16 @@ bitmap* load_bitmap( string const& filename )
 					bool is_masked = info[ 4 ] != 0;
 					
 					u8* data = (u8*)( info + 5 );
-					if( cel_count > 1 )
+					if( pack_contains( &internals->pack, data ) )
+						{
+						// the pack stays mapped until shutdown, so there's no need to copy the cels
+						void* storage = internals->pool_bitmap_and_refcount.create();
+						instance = new (storage) bitmap();
+						bitmap_loader::init_mapped( instance, w, h, cel_count, is_masked, data );
+						}
+					else if( cel_count > 1 )
 						{
-						void* cels = TRACKED_MALLOC( internals->memctx, cel_count * ( sizeof( void* ) * 2 + sizeof( int ) * 4 ) ); 
+						void* cels = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), cel_count * ( sizeof( void* ) * 2 + sizeof( int ) * 4 ) ); 
 						u8** pixels = (u8**) cels;
 						u8** masks = pixels + cel_count; 
 						int* offsets_x = (int*) ( masks + cel_count );
@@ -7934,40 +9582,9 @@ bitmap* load_bitmap( string const& filename )
 			PIXIE_ASSERTF( img, ( "Failed to load bitmap: %s", filename.c_str() ) );
 			if( img )
 				{   
-				u8* pixels = (u8*) TRACKED_MALLOC( internals->memctx, 2 * w * h * sizeof( u8 ) );
+				u8* pixels = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), 2 * w * h * sizeof( u8 ) );
 				u8* mask = pixels + w* h;
-				for( int i = 0; i < w * h; ++i )
-					{
-					int best_index = 0;
-					int min_distance_sq = 2147483647;
-					u32 color = ( (u32*)img )[ i ];
-					int cb = (int)( ( color >> 16 ) & 0xff );
-					int cg = (int)( ( color >> 8 ) & 0xff );
-					int cr = (int)( ( color ) & 0xff );
-					int cl = ( 54 * cr + 183 * cg + 19 * cb + 127 ) >> 8;
-
-					for( int j = 0; j < sizeof( internals->palette ) / sizeof( *internals->palette ); ++j ) 
-						{
-						int pr = (int)internals->palette[ j ].r;
-						int pg = (int)internals->palette[ j ].g;
-						int pb = (int)internals->palette[ j ].b;
-						int pl = ( 54 * pr + 183 * pg + 19 * pb + 127 ) >> 8;
-						int dr = cr - pr;
-						int dg = cg - pg;
-						int db = cb - pb;
-						int dl = cl - pl;
-						int d = ( ( ( ( dr * dr + dg * dg + db * db ) >> 1 ) + dl * dl ) * 38 + 127 ) >> 8;
-						int distance_sq = ( ( ( dr*dr + dg*dg + db*db ) >> 1 ) + dl*dl ) + d;
-						if( distance_sq < min_distance_sq ) 
-							{
-							min_distance_sq = distance_sq;
-							best_index = j;
-							}
-						}
-					pixels[ i ] = (u8) best_index;
-					}
-
-				for( int i = 0; i < w * h; ++i ) mask[ i ] = (u8)( ( ((u32*) img)[ i ] ) >> 24 );
+				match_palette( (u32*) img, w * h, internals->palette, pixels, mask );
 				void* storage = internals->pool_bitmap_and_refcount.create();
 				instance = new (storage) bitmap( w, h, pixels, mask );
 				stbi_image_free( img );
@@ -7978,6 +9595,25 @@ bitmap* load_bitmap( string const& filename )
 		
 	return instance;
 	}
+
+
+bitmap* load_bitmap( string const& filename )
+	{
+	internal::internals_t* internals = internal::internals();
+
+	atlas_bitmap_t* atlas_bitmap = internals->atlas_bitmaps.find( filename );
+	if( atlas_bitmap )
+		{
+		void* storage = internals->pool_bitmap_and_refcount.create();
+		bitmap* instance = new (storage) bitmap();
+		bitmap_loader::init_atlas( instance, atlas_bitmap->entry, atlas_bitmap->data );
+		return instance;
+		}
+
+	ref<binary> bin = bload( filename );
+	PIXIE_ASSERTF( bin, ( "Failed to load bitmap: %s", filename.c_str() ) );
+	return load_bitmap( filename, bin );
+	}
 	
 	
 void free_bitmap( bitmap* bmp )
@@ -7993,6 +9629,79 @@ void destroy_bitmap( void* bmp )
 	free_bitmap( (bitmap*) bmp );
 	}   
 
+
+struct bitmap_request_t final
+	{
+	thread_atomic_int_t done;
+	thread_signal_t signal;
+	ref<binary> bin;
+	rgb palette[ 256 ];
+	void* external_ctx;
+	int width;
+	int height;
+	u8* pixels; // pixels followed by mask, 0 if the image could not be decoded
+	bitmap* instance; // compiled bitmaps are created right away, and don't go through the decoders
+	};
+
+
+int bitmap_decoder_thread_proc( void* user_data )
+	{
+	internals_t* internals = (internals_t*) user_data;
+
+	// internals can't be reached from this thread, so stb_image gets the memctx through tls
+	thread_tls_set( thread_atomic_ptr_load( &decoder_tls ), tagged_memctx( internals->memctx, MEM_TAG_BITMAP ) );
+
+	for( ; ; )
+		{
+		bitmap_request_t* request = (bitmap_request_t*) thread_queue_consume( &internals->bitmap_decode_queue, THREAD_QUEUE_WAIT_INFINITE );
+		if( !request ) break;
+
+		int w, h, c;
+		stbi_uc* img = stbi_load_from_memory( (stbi_uc*) request->bin->data, (int) request->bin->size, &w, &h, &c, 4 );
+		if( img )
+			{
+			request->width = w;
+			request->height = h;
+			request->pixels = (u8*) PIXIE_MALLOC( request->external_ctx, 2 * w * h * sizeof( u8 ) );
+			match_palette( (u32*) img, w * h, request->palette, request->pixels, request->pixels + w * h );
+			stbi_image_free( img );
+			}
+
+		// the request is freed as soon as done is seen, so it must be the last thing touched
+		thread_signal_raise( &request->signal );
+		thread_atomic_int_store( &request->done, 1 );
+		}
+
+	thread_tls_set( thread_atomic_ptr_load( &decoder_tls ), 0 );
+	return 0;
+	}
+
+
+void start_bitmap_decoders( internals_t* internals )
+	{
+	int const count = sizeof( internals->bitmap_decode_queue_values ) / sizeof( *internals->bitmap_decode_queue_values );
+	thread_queue_init( &internals->bitmap_decode_queue, count, internals->bitmap_decode_queue_values, 0 );
+	for( int i = 0; i < sizeof( internals->bitmap_decoders ) / sizeof( *internals->bitmap_decoders ); ++i )
+		internals->bitmap_decoders[ i ] = thread_create( bitmap_decoder_thread_proc, internals, "Pixie bitmap decoder", THREAD_STACK_SIZE_DEFAULT );
+	internals->bitmap_decoders_started = true;
+	}
+
+
+void stop_bitmap_decoders( internals_t* internals )
+	{
+	// queued requests are still decoded, as the stop markers are consumed last
+	int const count = sizeof( internals->bitmap_decoders ) / sizeof( *internals->bitmap_decoders );
+	for( int i = 0; i < count; ++i )
+		thread_queue_produce( &internals->bitmap_decode_queue, 0, THREAD_QUEUE_WAIT_INFINITE );
+	for( int i = 0; i < count; ++i )
+		{
+		thread_join( internals->bitmap_decoders[ i ] );
+		thread_destroy( internals->bitmap_decoders[ i ] );
+		}
+	thread_queue_term( &internals->bitmap_decode_queue );
+	internals->bitmap_decoders_started = false;
+	}
+
 } /* namespace internal */ } /* namespace pixie */
 
 
@@ -8002,6 +9711,37 @@ pixie::ref<pixie::bitmap> pixie::load_bitmap( string const& filename )
 	return refcount::make_ref( bmp, internal::destroy_bitmap, (int*)( bmp + 1 ), 0 );   
 	}
 
+
+void pixie::load_atlas( string const& filename )
+	{
+	internal::internals_t* internals = internal::internals();
+	ref<binary> bin = bload( filename );
+	PIXIE_ASSERTF( bin, ( "Failed to load atlas: %s", filename.c_str() ) );
+	if( !bin ) return;
+
+	char const header[] = "PIXIE_ATL";
+	int const* info = (int const*)( (uintptr_t)bin->data + sizeof( header ) );
+	int supported_version = 1;
+	bool valid = memcmp( bin->data, header, sizeof( header ) ) == 0 && info[ 0 ] == supported_version;
+	PIXIE_ASSERTF( valid, ( "Invalid atlas file: %s", filename.c_str() ) );
+	if( !valid ) return;
+
+	// the atlas data is kept until shutdown, and bitmaps loaded from it reference its pixel data directly
+	int entry_count = info[ 1 ];
+	char const* names = (char const*)( (uintptr_t)bin->data + info[ 2 ] );
+	u8* data = (u8*)( (uintptr_t)bin->data + info[ 3 ] );
+	u8* entry = (u8*)( info + 4 );
+	for( int i = 0; i < entry_count; ++i )
+		{
+		int const* entry_info = (int const*) entry;
+		internal::atlas_bitmap_t& atlas_bitmap = internals->atlas_bitmaps[ string( names + entry_info[ 0 ] ) ];
+		atlas_bitmap.entry = entry;
+		atlas_bitmap.data = data;
+		entry += sizeof( int ) * ( 5 + 6 * entry_info[ 3 ] );
+		}
+	internals->atlases.add( bin );
+	}
+
 //-------------
 //  game_state
 //-------------
@@ -8022,15 +9762,15 @@ pixie::game_state::~game_state()
 	}
 
 
-void pixie::game_state::time_event( float seconds, string_id const& event_id, void* user_data )
+pixie::u64 pixie::game_state::time_event( float seconds, string_id const& event_id, void* user_data )
 	{
-	pixie::time_event( this, seconds, event_id, user_data );
+	return pixie::time_event( this, seconds, event_id, user_data );
 	}
 
 
-void pixie::game_state::repeating_time_event( float seconds, string_id const& event_id, void* user_data )
+pixie::u64 pixie::game_state::repeating_time_event( float seconds, string_id const& event_id, void* user_data )
 	{
-	pixie::repeating_time_event( this, seconds, event_id, user_data );
+	return pixie::repeating_time_event( this, seconds, event_id, user_data );
 	}
 
 
@@ -8102,7 +9842,7 @@ pixie::bitmap::bitmap( int width, int height )
 	internal.width = width;
 	internal.height = height;    
 	size_t size = width * height * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	memset( storage, 0, size ); 
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
@@ -8132,7 +9872,7 @@ pixie::bitmap::bitmap( int width, int height, u8* pixels, int transparent_index
 	internal.width = width;
 	internal.height = height;    
 	size_t size = width * height * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
 	internal.cels_normal = (internal_t::normal_cel*) storage;
@@ -8164,7 +9904,7 @@ pixie::bitmap::bitmap( int width, int height, u8* pixels, u8* mask )
 	internal.width = width;
 	internal.height = height;    
 	size_t size = width * height * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
 	internal.cels_normal = (internal_t::normal_cel*) storage;
@@ -8195,7 +9935,7 @@ pixie::bitmap::bitmap( int width, int height, int offset_x, int offset_y, int pi
 	internal.width = width;
 	internal.height = height;    
 	size_t size = pitch_x * pitch_y * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	memset( storage, 0, size ); 
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
@@ -8225,7 +9965,7 @@ pixie::bitmap::bitmap( int width, int height, int offset_x, int offset_y, int pi
 	internal.width = width;
 	internal.height = height;    
 	size_t size = pitch_x * pitch_y * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
 	internal.cels_normal = (internal_t::normal_cel*) storage;
@@ -8257,7 +9997,7 @@ pixie::bitmap::bitmap( int width, int height, int offset_x, int offset_y, int pi
 	internal.width = width;
 	internal.height = height;    
 	size_t size = pitch_x * pitch_y * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
 	internal.cels_normal = (internal_t::normal_cel*) storage;
@@ -8287,7 +10027,7 @@ pixie::bitmap::bitmap( int width, int height, int cel_count )
 	internal.width = width;
 	internal.height = height;    
 	size_t size = width * height * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	memset( storage, 0, size ); 
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
@@ -8316,7 +10056,7 @@ pixie::bitmap::bitmap( int width, int height, int cel_count, u8* pixels[], int t
 	internal.width = width;
 	internal.height = height;    
 	size_t size = width * height * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	memset( storage, 0, size ); 
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
@@ -8348,7 +10088,7 @@ pixie::bitmap::bitmap( int width, int height, int cel_count, u8* pixels[], u8* m
 	internal.width = width;
 	internal.height = height;    
 	size_t size = width * height * sizeof( u8 ) * 2 * cel_count + sizeof( internal_t::normal_cel ) * cel_count;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	memset( storage, 0, size ); 
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
@@ -8380,7 +10120,7 @@ pixie::bitmap::bitmap( int width, int height, int cel_count, int offset_x[], int
 	size_t size = sizeof( internal_t::normal_cel ) * cel_count;
 	for( int i = 0; i < cel_count; ++i )
 		size += pitch_x[ i ] * pitch_y[ i ] * sizeof( u8 ) * 2;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	memset( storage, 0, size ); 
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
@@ -8411,7 +10151,7 @@ pixie::bitmap::bitmap( int width, int height, int cel_count, int offset_x[], int
 	size_t size = sizeof( internal_t::normal_cel ) * cel_count;
 	for( int i = 0; i < cel_count; ++i )
 		size += pitch_x[ i ] * pitch_y[ i ] * sizeof( u8 ) * ( transparent_index >= 0 && transparent_index <= 255 ? 2 : 1 );
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
 	internal.cels_normal = (internal_t::normal_cel*) storage;
@@ -8444,7 +10184,7 @@ pixie::bitmap::bitmap( int width, int height, int cel_count, int offset_x[], int
 	size_t size = sizeof( internal_t::normal_cel ) * cel_count;
 	for( int i = 0; i < cel_count; ++i )
 		size += pitch_x[ i ] * pitch_y[ i ] * sizeof( u8 ) * 2;
-	u8* storage = (u8*) TRACKED_MALLOC( internals->memctx, size );
+	u8* storage = (u8*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), size );
 	internal.storage = storage;
 	internal.type = internal_t::DATA_TYPE_NORMAL;
 	internal.cels_normal = (internal_t::normal_cel*) storage;
@@ -8493,6 +10233,7 @@ int pixie::bitmap::height() const
 
 void pixie::bitmap::pixel( int cel, int x, int y, int color )
 	{
+	internal::bitmap_loader::prepare_write( this );
 	switch( internal.type )
 		{
 		case internal_t::DATA_TYPE_NONE:
@@ -8519,6 +10260,16 @@ int pixie::bitmap::pixel( int cel, int x, int y ) const
 			if( cel >= 0 && cel < internal.cel_count && x >= 0 && x < internal.cels_normal[ cel ].pitch_x && y >= 0 && y < internal.cels_normal[ cel ].pitch_y )
 				return (int) internal.cels_normal[ cel ].pixels[ x + y * internal.cels_normal[ cel ].pitch_x ];
 			break;
+		case internal_t::DATA_TYPE_DELTA:
+			if( cel >= 0 && cel < internal.cel_count )
+				{
+				internal_t::normal_cel const& src = internal::bitmap_loader::delta_source( internal.cels_delta[ cel ], x, y );
+				x -= src.offset_x;
+				y -= src.offset_y;
+				if( x >= 0 && x < src.pitch_x && y >= 0 && y < src.pitch_y )
+					return (int) src.pixels[ x + y * src.pitch_x ];
+				}
+			break;
 		}
 
 	return 0;
@@ -8527,6 +10278,7 @@ int pixie::bitmap::pixel( int cel, int x, int y ) const
 
 void pixie::bitmap::mask( int cel, int x, int y, bool opaque )
 	{
+	internal::bitmap_loader::prepare_write( this );
 	switch( internal.type )
 		{
 		case internal_t::DATA_TYPE_NONE:
@@ -8555,6 +10307,17 @@ bool pixie::bitmap::mask( int cel, int x, int y ) const
 			if( cel >= 0 && cel < internal.cel_count && x >= 0 && x < internal.cels_normal[ cel ].pitch_x && y >= 0 && y < internal.cels_normal[ cel ].pitch_y )
 				return internal.cels_normal[ cel ].mask[ x + y * internal.cels_normal[ cel ].pitch_x ] != 0;
 			break;
+		case internal_t::DATA_TYPE_DELTA:
+			if( cel >= 0 && cel < internal.cel_count )
+				{
+				internal_t::normal_cel const& src = internal::bitmap_loader::delta_source( internal.cels_delta[ cel ], x, y );
+				if( !src.mask ) return true;
+				x -= src.offset_x;
+				y -= src.offset_y;
+				if( x >= 0 && x < src.pitch_x && y >= 0 && y < src.pitch_y )
+					return src.mask[ x + y * src.pitch_x ] != 0;
+				}
+			break;
 		}
 
 	return false;
@@ -8563,6 +10326,7 @@ bool pixie::bitmap::mask( int cel, int x, int y ) const
 
 void pixie::bitmap::lock( lock_data* data )
 	{
+	internal::bitmap_loader::prepare_write( this );
 	++internal.lock_count;
 	switch( internal.type )
 		{
@@ -8588,6 +10352,7 @@ void pixie::bitmap::lock( lock_data* data )
 
 void pixie::bitmap::lock( int cel, lock_data* data )
 	{
+	internal::bitmap_loader::prepare_write( this );
 	++internal.lock_count;
 	switch( internal.type )
 		{
@@ -8619,6 +10384,7 @@ void pixie::bitmap::unlock()
 		case internal_t::DATA_TYPE_NONE:
 			break;
 		case internal_t::DATA_TYPE_NORMAL:
+		case internal_t::DATA_TYPE_DELTA:
 			// no need to do anything
 			break;
 		}
@@ -8691,101 +10457,137 @@ void pixie::bitmap::blit( int cel, int x1, int y1, int x2, int y2, bitmap* targe
 			*src_blit = src;
 			*dst_blit = dst;
 			}
-		};
 
-	if( internal.type == internal_t::DATA_TYPE_NORMAL && target->internal.type == internal_t::DATA_TYPE_NORMAL )
-		{
-		local::rect src_blit = { x1, y1, x2 - x1 + 1, y2 - y1 + 1, };
-		local::rect src_data = { internal.cels_normal[ cel ].offset_x, internal.cels_normal[ cel ].offset_y, 
-			internal.cels_normal[ cel ].pitch_x, internal.cels_normal[ cel ].pitch_y, };
-		local::rect dst_blit = { x, y, src_blit.w, src_blit.h, };
-		local::rect dst_data = { target->internal.cels_normal[ 0 ].offset_x, target->internal.cels_normal[ 0 ].offset_y,
-			target->internal.cels_normal[ 0 ].pitch_x, target->internal.cels_normal[ 0 ].pitch_y, };
+		static void blit_cel( internal_t::normal_cel const& src, int x1, int y1, int x2, int y2, internal_t::normal_cel const& dst, int x, int y )
+			{
+			rect src_blit = { x1, y1, x2 - x1 + 1, y2 - y1 + 1, };
+			rect src_data = { src.offset_x, src.offset_y, src.pitch_x, src.pitch_y, };
+			rect dst_blit = { x, y, src_blit.w, src_blit.h, };
+			rect dst_data = { dst.offset_x, dst.offset_y, dst.pitch_x, dst.pitch_y, };
 
-		local::clip( &src_blit, &src_data, &dst_blit, &dst_data );
-		if( src_blit.w == 0 || src_blit.h == 0 ) return;
+			clip( &src_blit, &src_data, &dst_blit, &dst_data );
+			if( src_blit.w == 0 || src_blit.h == 0 ) return;
 
-		src_blit.x -= internal.cels_normal[ cel ].offset_x;
-		src_blit.y -= internal.cels_normal[ cel ].offset_y;
-		dst_blit.x -= target->internal.cels_normal[ 0 ].offset_x;
-		dst_blit.y -= target->internal.cels_normal[ 0 ].offset_y;
+			src_blit.x -= src.offset_x;
+			src_blit.y -= src.offset_y;
+			dst_blit.x -= dst.offset_x;
+			dst_blit.y -= dst.offset_y;
 
-		u8* src_pixels = internal.cels_normal[ cel ].pixels;
-		if( src_pixels ) src_pixels += src_blit.x + src_blit.y * internal.cels_normal[ cel ].pitch_x;
+			u8* src_pixels = src.pixels;
+			if( src_pixels ) src_pixels += src_blit.x + src_blit.y * src.pitch_x;
 
-		u8* src_mask = internal.cels_normal[ cel ].mask;
-		if( src_mask ) src_mask += src_blit.x + src_blit.y * internal.cels_normal[ cel ].pitch_x;
+			u8* src_mask = src.mask;
+			if( src_mask ) src_mask += src_blit.x + src_blit.y * src.pitch_x;
 		
-		u8* dst_pixels = target->internal.cels_normal[ 0 ].pixels;
-		if( dst_pixels ) dst_pixels += dst_blit.x + dst_blit.y * target->internal.cels_normal[ 0 ].pitch_x;
+			u8* dst_pixels = dst.pixels;
+			if( dst_pixels ) dst_pixels += dst_blit.x + dst_blit.y * dst.pitch_x;
 		
-		u8* dst_mask = target->internal.cels_normal[ 0 ].mask;
-		if( dst_mask ) dst_mask += dst_blit.x + dst_blit.y * target->internal.cels_normal[ 0 ].pitch_x;
+			u8* dst_mask = dst.mask;
+			if( dst_mask ) dst_mask += dst_blit.x + dst_blit.y * dst.pitch_x;
 
-		if( src_mask && dst_mask )
-			{
-			int src_delta = internal.cels_normal[ cel ].pitch_x - src_blit.w;
-			int dst_delta = target->internal.cels_normal[ 0 ].pitch_x - dst_blit.w;
-			for( int iy = 0; iy < src_blit.h; ++iy )
+			if( src_mask && dst_mask )
 				{
-				for( int ix = 0; ix < src_blit.w; ++ix )
+				int src_delta = src.pitch_x - src_blit.w;
+				int dst_delta = dst.pitch_x - dst_blit.w;
+				for( int iy = 0; iy < src_blit.h; ++iy )
 					{
-					if( *src_mask++ > 0x80 )
+					for( int ix = 0; ix < src_blit.w; ++ix )
 						{
-						*dst_pixels = *src_pixels;
-						*dst_mask = 0xff;
+						if( *src_mask++ > 0x80 )
+							{
+							*dst_pixels = *src_pixels;
+							*dst_mask = 0xff;
+							}
+						++src_pixels;
+						++dst_pixels;
+						++dst_mask;
 						}
-					++src_pixels;
-					++dst_pixels;
-					++dst_mask;
+					src_pixels += src_delta;
+					src_mask += src_delta;
+					dst_pixels += dst_delta;
+					dst_mask += dst_delta;
 					}
-				src_pixels += src_delta;
-				src_mask += src_delta;
-				dst_pixels += dst_delta;
-				dst_mask += dst_delta;
 				}
-			}
-		else if( src_mask )
-			{
-			int src_delta = internal.cels_normal[ cel ].pitch_x - src_blit.w;
-			int dst_delta = target->internal.cels_normal[ 0 ].pitch_x - dst_blit.w;
-			for( int iy = 0; iy < src_blit.h; ++iy )
+			else if( src_mask )
 				{
-				for( int ix = 0; ix < src_blit.w; ++ix )
+				int src_delta = src.pitch_x - src_blit.w;
+				int dst_delta = dst.pitch_x - dst_blit.w;
+				for( int iy = 0; iy < src_blit.h; ++iy )
 					{
-					if( *src_mask++ >= 0x80 ) *dst_pixels = *src_pixels;
-					++src_pixels;
-					++dst_pixels;
+					for( int ix = 0; ix < src_blit.w; ++ix )
+						{
+						if( *src_mask++ >= 0x80 ) *dst_pixels = *src_pixels;
+						++src_pixels;
+						++dst_pixels;
+						}
+					src_pixels += src_delta;
+					src_mask += src_delta;
+					dst_pixels += dst_delta;
 					}
-				src_pixels += src_delta;
-				src_mask += src_delta;
-				dst_pixels += dst_delta;
 				}
-			}
-		else if( dst_mask )
-			{
-			int src_delta = internal.cels_normal[ cel ].pitch_x;
-			int dst_delta = target->internal.cels_normal[ 0 ].pitch_x;
-			for( int iy = 0; iy < src_blit.h; ++iy )
+			else if( dst_mask )
+				{
+				int src_delta = src.pitch_x;
+				int dst_delta = dst.pitch_x;
+				for( int iy = 0; iy < src_blit.h; ++iy )
+					{
+					memcpy( dst_pixels, src_pixels, (size_t)src_blit.w );
+					memset( dst_mask, 0xff, (size_t)src_blit.w );
+					src_pixels += src_delta;
+					dst_pixels += dst_delta;
+					dst_mask += dst_delta;
+					}
+				}
+			else
 				{
-				memcpy( dst_pixels, src_pixels, (size_t)src_blit.w );
-				memset( dst_mask, 0xff, (size_t)src_blit.w );
-				src_pixels += src_delta;
-				dst_pixels += dst_delta;
-				dst_mask += dst_delta;
+				int src_delta = src.pitch_x;
+				int dst_delta = dst.pitch_x;
+				for( int iy = 0; iy < src_blit.h; ++iy )
+					{
+					memcpy( dst_pixels, src_pixels, (size_t)src_blit.w );
+					src_pixels += src_delta;
+					dst_pixels += dst_delta;
+					}
 				}
 			}
-		else
+		};
+
+	internal::bitmap_loader::prepare_write( target );
+	if( target->internal.type != internal_t::DATA_TYPE_NORMAL ) return;
+
+	internal_t::normal_cel const& dst = target->internal.cels_normal[ 0 ];
+	if( internal.type == internal_t::DATA_TYPE_NORMAL )
+		{
+		local::blit_cel( internal.cels_normal[ cel ], x1, y1, x2, y2, dst, x, y );
+		}
+	else if( internal.type == internal_t::DATA_TYPE_DELTA )
+		{
+		internal_t::delta_cel const& delta = internal.cels_delta[ cel ];
+		if( delta.patch.pitch_x <= 0 || delta.patch.pitch_y <= 0 )
 			{
-			int src_delta = internal.cels_normal[ cel ].pitch_x;
-			int dst_delta = target->internal.cels_normal[ 0 ].pitch_x;
-			for( int iy = 0; iy < src_blit.h; ++iy )
-				{
-				memcpy( dst_pixels, src_pixels, (size_t)src_blit.w );
-				src_pixels += src_delta;
-				dst_pixels += dst_delta;
-				}
+			local::blit_cel( delta.base, x1, y1, x2, y2, dst, x, y );
+			return;
 			}
+
+		// draw the base cel around the patch area, and then the patch on top, rather than expanding the cel
+		int px1 = delta.patch.offset_x;
+		int py1 = delta.patch.offset_y;
+		int px2 = px1 + delta.patch.pitch_x - 1;
+		int py2 = py1 + delta.patch.pitch_y - 1;
+		int bands[ 4 ][ 4 ] = 
+			{
+			{ x1, y1, x2, pixie::min( y2, py1 - 1 ) }, // above
+			{ x1, pixie::max( y1, py2 + 1 ), x2, y2 }, // below
+			{ x1, pixie::max( y1, py1 ), pixie::min( x2, px1 - 1 ), pixie::min( y2, py2 ) }, // left
+			{ pixie::max( x1, px2 + 1 ), pixie::max( y1, py1 ), x2, pixie::min( y2, py2 ) }, // right
+			};
+		for( int i = 0; i < 4; ++i )
+			{
+			int const* band = bands[ i ];
+			if( band[ 2 ] >= band[ 0 ] && band[ 3 ] >= band[ 1 ] )
+				local::blit_cel( delta.base, band[ 0 ], band[ 1 ], band[ 2 ], band[ 3 ], dst, x + band[ 0 ] - x1, y + band[ 1 ] - y1 );
+			}
+		local::blit_cel( delta.patch, x1, y1, x2, y2, dst, x, y );
 		}
 	}
 
@@ -8796,6 +10598,7 @@ int pixie::bitmap::offset_x( int cel ) const
 		{
 		case internal_t::DATA_TYPE_NONE: return 0;
 		case internal_t::DATA_TYPE_NORMAL: return internal.cels_normal[ cel ].offset_x;
+		case internal_t::DATA_TYPE_DELTA: return internal.cels_delta[ cel ].base.offset_x;
 		}
 		
 	return 0;
@@ -8808,6 +10611,7 @@ int pixie::bitmap::offset_y( int cel ) const
 		{
 		case internal_t::DATA_TYPE_NONE: return 0;
 		case internal_t::DATA_TYPE_NORMAL: return internal.cels_normal[ cel ].offset_y;
+		case internal_t::DATA_TYPE_DELTA: return internal.cels_delta[ cel ].base.offset_y;
 		}
 		
 	return 0;
@@ -8820,6 +10624,7 @@ int pixie::bitmap::pitch_x( int cel ) const
 		{
 		case internal_t::DATA_TYPE_NONE: return 0;
 		case internal_t::DATA_TYPE_NORMAL: return internal.cels_normal[ cel ].pitch_x;
+		case internal_t::DATA_TYPE_DELTA: return internal.cels_delta[ cel ].base.pitch_x;
 		}
 		
 	return 0;
@@ -8832,6 +10637,7 @@ int pixie::bitmap::pitch_y( int cel ) const
 		{
 		case internal_t::DATA_TYPE_NONE: return 0;
 		case internal_t::DATA_TYPE_NORMAL: return internal.cels_normal[ cel ].pitch_y;
+		case internal_t::DATA_TYPE_DELTA: return internal.cels_delta[ cel ].base.pitch_y;
 		}
 		
 	return 0;
@@ -8997,7 +10803,7 @@ audio_instance* audioformat_samples( void* data, size_t size )
 
 	internal::internals_t* internals = internal::internals();
 	
-	samples_instance* instance = (samples_instance*) TRACKED_MALLOC( internals->memctx, sizeof( samples_instance ) ); 
+	samples_instance* instance = (samples_instance*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ), sizeof( samples_instance ) ); 
 
 	instance->position_in_sample_pairs = 0;
 	instance->sample_pairs = (float*) data;
@@ -9066,7 +10872,7 @@ audio_instance* audioformat_ogg( void* data, size_t size )
 	internal::internals_t* internals = internal::internals();
 
 	size_t alloc_size = 256 * 1024;
-	void* alloc_mem = TRACKED_MALLOC( internals->memctx, alloc_size );
+	void* alloc_mem = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ), alloc_size );
 
 	stb_vorbis_alloc ogg_alloc;
 	ogg_alloc.alloc_buffer = ( (char*) alloc_mem ) + sizeof( ogg_instance );
@@ -9078,7 +10884,7 @@ audio_instance* audioformat_ogg( void* data, size_t size )
 		{
 		TRACKED_FREE( internals->memctx, alloc_mem );
 		alloc_size *= 2;
-		alloc_mem = TRACKED_MALLOC( internals->memctx, alloc_size );
+		alloc_mem = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ), alloc_size );
 
 		ogg_alloc.alloc_buffer = ( (char*) alloc_mem ) + sizeof( ogg_instance );
 		ogg_alloc.alloc_buffer_length_in_bytes = (int)( alloc_size - sizeof( ogg_instance ) );
@@ -9179,7 +10985,7 @@ audio_instance* audioformat_wav( void* data, size_t size )
 
 	internal::internals_t* internals = internal::internals();
 	
-	wav_instance* instance = (wav_instance*) TRACKED_MALLOC( internals->memctx,  sizeof( wav_instance ) ); 
+	wav_instance* instance = (wav_instance*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ),  sizeof( wav_instance ) ); 
 
 	if( !drwav_init_memory( &instance->wav, data, size ) ) return 0;
 	PIXIE_ASSERT( ( instance->wav.channels == 2 || instance->wav.channels == 1 ) && instance->wav.sampleRate == 44100, 
@@ -9251,7 +11057,7 @@ audio_instance* audioformat_mod( void* data, size_t size )
 
 	internal::internals_t* internals = internal::internals();
 	
-	mod_instance* instance = (mod_instance*) TRACKED_MALLOC( internals->memctx, sizeof( mod_instance ) ); 
+	mod_instance* instance = (mod_instance*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ), sizeof( mod_instance ) ); 
 	if( !jar_mod_init( &instance->modctx ) ) { TRACKED_FREE( internals->memctx, instance ); return 0; }
 	if( !jar_mod_setcfg( &instance->modctx, 44100, 16, 2, 0, 0 ) ) { TRACKED_FREE( internals->memctx, instance ); return 0; }
 	if( !jar_mod_load( &instance->modctx, data, (int) size ) ) { TRACKED_FREE( internals->memctx, instance ); return 0; }
@@ -9322,7 +11128,7 @@ audio_instance* audioformat_xm( void* data, size_t size )
 	internal::internals_t* internals = internal::internals();
 
 	size_t size_required = jar_xm_get_memory_needed_for_context( (char const*) data, size );
-	xm_instance* instance = (xm_instance*) TRACKED_MALLOC( internals->memctx, sizeof( xm_instance ) + size_required );
+	xm_instance* instance = (xm_instance*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ), sizeof( xm_instance ) + size_required );
 	char* mempool = (char*)( instance + 1 );
 	if( jar_xm_create_context_mempool( &instance->musicptr, (char const*) data, size, 44100, mempool, size_required ) != 0 ) 
 		{
@@ -9416,14 +11222,14 @@ pixie::audio::audio( float* sample_pairs, int sample_pairs_count, bool take_owne
 	size_t size = sample_pairs_count * sizeof( float ) * 2;        
 	if( take_ownership_of_memory )
 		{
-		binary* bin = (binary*) TRACKED_MALLOC( internals->memctx, sizeof( binary ) + sizeof( int ) ); 
+		binary* bin = (binary*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ), sizeof( binary ) + sizeof( int ) ); 
 		bin->data = (u8*) sample_pairs;
 		bin->size = size;
 		internal.bin = refcount::make_ref( bin, internal::samples_delete, (int*)( bin + 1 ), 0 );
 		}
 	else
 		{
-		void* storage = TRACKED_MALLOC( internals->memctx, sizeof( binary ) + sizeof( int ) + size ); 
+		void* storage = TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_AUDIO ), sizeof( binary ) + sizeof( int ) + size ); 
 		binary* bin = (binary*)storage;
 		bin->data = (u8*) ( ( (uintptr_t) storage ) + sizeof( binary ) + sizeof( int ) );
 		bin->size = size;
@@ -11728,6 +13534,87 @@ void resources::resource_destroy( resource_key* key, pixie::bitmap* instance )
 	}
 
 
+resources::RESOURCES_U64 resources::resource_size( pixie::bitmap* instance )
+	{
+	RESOURCES_U64 size = sizeof( pixie::internal::bitmap_and_refcount );
+	for( int i = 0; i < instance->cel_count(); ++i ) 
+		size += (RESOURCES_U64)( instance->pitch_x( i ) * instance->pitch_y( i ) * 2 ); // pixels and mask
+	return size;
+	}
+
+
+// file reading stays on the update thread, only the image decoding and palette matching is done in the background
+void* resources::resource_request( pixie::bitmap*, pixie::string const& filename )
+	{
+	using namespace pixie;
+	internal::internals_t* internals = internal::internals();
+
+	// atlas entries are cheap to set up, so they are just created right away
+	if( internals->atlas_bitmaps.find( filename ) ) return 0;
+	ref<binary> bin = bload( filename );
+	if( !bin ) return 0;
+
+	internal::bitmap_request_t* request = (internal::bitmap_request_t*) TRACKED_MALLOC( internal::tagged_memctx( internals->memctx, MEM_TAG_BITMAP ), sizeof( internal::bitmap_request_t ) );
+	new (request) internal::bitmap_request_t();
+	thread_atomic_int_store( &request->done, 0 );
+	thread_signal_init( &request->signal );
+	request->bin = bin;
+	memcpy( request->palette, internals->palette, sizeof( request->palette ) );
+	request->external_ctx = ( (internal::memtrack_t*) internals->memctx )->external_ctx;
+	request->width = 0;
+	request->height = 0;
+	request->pixels = 0;
+	request->instance = 0;
+
+	// compiled bitmaps are cheap to set up, so they are created right away from the file which is already loaded, and
+	// the request is complete from the start
+	char const header[] = "PIXIE_PIX";
+	if( bin->size >= sizeof( header ) && memcmp( bin->data, header, sizeof( header ) ) == 0 )
+		{
+		request->instance = internal::load_bitmap( filename, bin );
+		request->bin = ref<binary>();
+		thread_atomic_int_store( &request->done, 1 );
+		return request;
+		}
+
+	if( !internals->bitmap_decoders_started ) internal::start_bitmap_decoders( internals );
+	thread_queue_produce( &internals->bitmap_decode_queue, request, THREAD_QUEUE_WAIT_INFINITE );
+	return request;
+	}
+
+
+bool resources::resource_poll( pixie::bitmap** instance, void* request_ptr, bool wait )
+	{
+	using namespace pixie;
+	internal::internals_t* internals = internal::internals();
+	internal::bitmap_request_t* request = (internal::bitmap_request_t*) request_ptr;
+
+	// the decoder raises the signal just before setting done, so once the signal is seen, there's only a moment left to 
+	// wait for done. the request can't be freed before done is set, as the decoder might still be raising the signal
+	if( !wait && !thread_atomic_int_load( &request->done ) ) return false;
+	while( !thread_atomic_int_load( &request->done ) )
+		{
+		if( thread_signal_wait( &request->signal, 1000 ) )
+			while( !thread_atomic_int_load( &request->done ) ) thread_yield();
+		}
+
+	// a failed load or decode completes without an instance, which resource<T>::failed reports
+	*instance = request->instance;
+	PIXIE_ASSERT( request->instance || request->pixels, "Failed to decode bitmap" );
+	if( request->pixels )
+		{
+		void* storage = internals->pool_bitmap_and_refcount.create();
+		*instance = new (storage) bitmap( request->width, request->height, request->pixels, request->pixels + request->width * request->height );
+		PIXIE_FREE( request->external_ctx, request->pixels );
+		}
+
+	thread_signal_term( &request->signal );
+	request->~bitmap_request_t();
+	TRACKED_FREE( internals->memctx, request );
+	return true;
+	}
+
+
 void resources::resource_create( pixie::font** instance, pixie::string const& filename )
 	{
 	pixie::internal::internals_t* internals = pixie::internal::internals();
@@ -11814,6 +13701,188 @@ void pixie::unpin_resources()
 	}
 
 
+void pixie::resource_cache_budget( size_t bytes )
+	{
+	internal::internals_t* internals = internal::internals();
+	internals->resource_sys.cache_budget( bytes );
+	}
+
+
+pixie::resource_cache_stats_t pixie::resource_cache_stats()
+	{
+	internal::internals_t* internals = internal::internals();
+	return internals->resource_sys.cache_stats();
+	}
+
+
+float pixie::state_load_time()
+	{
+	internal::internals_t* internals = internal::internals();
+	return internals->state_load_time;
+	}
+
+
+namespace pixie { namespace internal {
+
+char const* preload_type_names[] = { "bitmap", "font", "audio" };
+
+
+void preload_state( void const* state_id, string const& manifest )
+	{
+	internals_t* internals = internals();
+	for( int i = 0; i < internals->state_preloads.count(); ++i )
+		{
+		if( internals->state_preloads[ i ].state_id == state_id )
+			{
+			internals->state_preloads.remove( i );
+			break;
+			}
+		}
+
+	state_preload_t preload;
+	preload.state_id = state_id;
+	preload.manifest = manifest;
+	preload.loaded = false;
+	preload.recording = false;
+	internals->state_preloads.add( preload );
+	}
+
+
+void record_resource( preload_type_t type, string const& filename )
+	{
+	if( type == PRELOAD_NONE ) return;
+	internals_t* internals = internals();
+	if( internals->recording_count <= 0 ) return;
+	
+	for( int i = 0; i < internals->state_preloads.count(); ++i )
+		{
+		state_preload_t& preload = internals->state_preloads[ i ];
+		if( !preload.recording ) continue;
+		bool found = false;
+		for( int j = 0; j < preload.filenames.count(); ++j )
+			{
+			if( preload.types[ j ] == type && preload.filenames[ j ] == filename )
+				{
+				found = true;
+				break;
+				}
+			}
+		if( !found )
+			{
+			preload.types.add( type );
+			preload.filenames.add( filename );
+			}
+		}
+	}
+
+
+static void load_manifest( state_preload_t* preload )
+	{
+	preload->loaded = true;
+	if( !file_exists( preload->manifest ) ) return;
+	ref<binary> bin = bload( preload->manifest );
+	if( !bin ) return;
+
+	char const* data = (char const*) bin->data;
+	size_t pos = 0;
+	while( pos < bin->size )
+		{
+		size_t end = pos;
+		while( end < bin->size && data[ end ] != '\n' ) ++end;
+		size_t len = end;
+		while( len > pos && ( data[ len - 1 ] == '\r' || data[ len - 1 ] == ' ' ) ) --len;
+		
+		for( int i = 0; i < sizeof( preload_type_names ) / sizeof( *preload_type_names ); ++i )
+			{
+			size_t name_len = strlen( preload_type_names[ i ] );
+			if( len - pos > name_len + 1 && strncmp( data + pos, preload_type_names[ i ], name_len ) == 0 && data[ pos + name_len ] == ' ' )
+				{
+				preload->types.add( (preload_type_t) i );
+				preload->filenames.add( string( data + pos + name_len + 1, data + len ) );
+				break;
+				}
+			}
+		pos = end + 1;
+		}
+	}
+
+
+static void save_manifest( state_preload_t* preload )
+	{
+	FILE* fp = fopen( preload->manifest.c_str(), "w" );
+	PIXIE_ASSERTF( fp, ( "Failed to save preload manifest: %s", preload->manifest.c_str() ) );
+	if( !fp ) return;
+	for( int i = 0; i < preload->filenames.count(); ++i )
+		fprintf( fp, "%s %s\n", preload_type_names[ preload->types[ i ] ], preload->filenames[ i ].c_str() );
+	fclose( fp );
+	}
+
+
+void state_transition( void* user_data, gamestate::transition type, void const* state_id )
+	{
+	internals_t* internals = (internals_t*) user_data;
+	state_preload_t* preload = 0;
+	for( int i = 0; i < internals->state_preloads.count(); ++i )
+		{
+		if( internals->state_preloads[ i ].state_id == state_id )
+			{
+			preload = &internals->state_preloads[ i ];
+			break;
+			}
+		}
+
+	if( type == gamestate::TRANSITION_IN )
+		{
+		u64 start = app_time_count( 0 );
+		if( preload )
+			{
+			if( !preload->loaded ) load_manifest( preload );
+			if( preload->filenames.count() == 0 )
+				{
+				// nothing to preload yet, so record what the state uses instead
+				preload->recording = true;
+				++internals->recording_count;
+				}
+			else
+				{
+				// request all bitmaps first, so that images which need decoding (not compiled .pix files) are decoded on the
+				// decoder threads while fonts and audio load. all file reads still happen here, one after the other. then
+				// pin everything until the state is left
+				string_id group( preload->manifest );
+				array<resource<bitmap> > bitmaps;
+				for( int i = 0; i < preload->filenames.count(); ++i )
+					{
+					if( preload->types[ i ] == PRELOAD_BITMAP ) bitmaps.add( resource<bitmap>( async, preload->filenames[ i ] ) );
+					}
+				for( int i = 0; i < preload->filenames.count(); ++i )
+					{
+					if( preload->types[ i ] == PRELOAD_FONT ) pin_resource( resource<font>( preload->filenames[ i ] ), group );
+					else if( preload->types[ i ] == PRELOAD_AUDIO ) pin_resource( resource<audio>( preload->filenames[ i ] ), group );
+					}
+				for( int i = 0; i < bitmaps.count(); ++i )
+					{
+					(void)(bitmap*) bitmaps[ i ];
+					pin_resource( bitmaps[ i ], group );
+					}
+				}
+			}
+		internals->state_load_time = (float)( (double)( app_time_count( 0 ) - start ) / (double) app_time_freq( 0 ) );
+		}
+	else if( type == gamestate::TRANSITION_OUT && preload )
+		{
+		unpin_resource( string_id( preload->manifest ) );
+		if( preload->recording )
+			{
+			preload->recording = false;
+			--internals->recording_count;
+			if( preload->filenames.count() > 0 ) save_manifest( preload );
+			}
+		}
+	}
+
+} /* namespace internal */ } /* namespace pixie */
+
+
 //------------------
 //  default_palette
 //------------------
@@ -11885,19 +13954,19 @@ pixie::u32 pixie::internal::default_palette[ 256 ] =
 #include "app.h"
 
 #define ASSETSYS_IMPLEMENTATION
-#define ASSETSYS_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define ASSETSYS_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_RESOURCE ), size )
 #define ASSETSYS_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define ASSETSYS_ASSERT PIXIE_ASSERT
 #include "assetsys.h"
 
 #define AUDIOSYS_IMPLEMENTATION
-#define AUDIOSYS_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define AUDIOSYS_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_AUDIO ), size )
 #define AUDIOSYS_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define AUDIOSYS_ASSERT PIXIE_ASSERT
 #include "audiosys.h"
 
 #define ARRAY_IMPLEMENTATION
-#define ARRAY_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define ARRAY_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_CONTAINERS ), size )
 #define ARRAY_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #include "array.hpp"
 
@@ -11945,13 +14014,13 @@ pixie::u32 pixie::internal::default_palette[ 256 ] =
 #include "gamestate.hpp"
 
 #define HANDLES_IMPLEMENTATION
-#define HANDLES_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define HANDLES_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_CONTAINERS ), size )
 #define HANDLES_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define HANDLES_ASSERT PIXIE_ASSERT
 #include "handles.h"
 
 #define HASHTABLE_IMPLEMENTATION
-#define HASHTABLE_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define HASHTABLE_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_CONTAINERS ), size )
 #define HASHTABLE_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define HASHTABLE_ASSERT PIXIE_ASSERT
 #include "hashtable.h"
@@ -11977,25 +14046,25 @@ pixie::u32 pixie::internal::default_palette[ 256 ] =
 #include "math_util.hpp"
 
 #define MEMPOOL_IMPLEMENTATION
-#define MEMPOOL_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define MEMPOOL_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_CONTAINERS ), size )
 #define MEMPOOL_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define MEMPOOL_ASSERT PIXIE_ASSERT
 #include "mempool.hpp"
 
 #define OBJREPO_IMPLEMENTATION
-#define OBJREPO_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define OBJREPO_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_CONTAINERS ), size )
 #define OBJREPO_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define OBJREPO_ASSERT PIXIE_ASSERT
 #include "objrepo.hpp"
 
 #define PALDITHER_IMPLEMENTATION
-#define PALDITHER_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define PALDITHER_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_BITMAP ), size )
 #define PALDITHER_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define PALDITHER_ASSERT PIXIE_ASSERT
 #include "paldither.h"
 
 #define PALETTIZE_IMPLEMENTATION
-#define PALETTIZE_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define PALETTIZE_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_BITMAP ), size )
 #define PALETTIZE_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define PALETTIZE_ASSERT PIXIE_ASSERT
 #include "palettize.h"
@@ -12030,7 +14099,7 @@ void refcount_free( void* p )
 #include "refcount.hpp"
 
 #define RESOURCES_IMPLEMENTATION
-#define RESOURCES_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define RESOURCES_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_RESOURCE ), size )
 #define RESOURCES_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define RESOURCES_ASSERT PIXIE_ASSERT
 #include "resources.hpp"
@@ -12039,13 +14108,13 @@ void refcount_free( void* p )
 #include "rnd.h"
 
 #define STRPOOL_IMPLEMENTATION
-#define STRPOOL_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define STRPOOL_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_STRINGS ), size )
 #define STRPOOL_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #define STRPOOL_ASSERT PIXIE_ASSERT
 #include "strpool.h"
 
 #define STRPOOL_HPP_IMPLEMENTATION
-#define STRPOOL_HPP_MALLOC( ctx, size ) TRACKED_MALLOC( ctx, size )
+#define STRPOOL_HPP_MALLOC( ctx, size ) TRACKED_MALLOC( pixie::internal::tagged_memctx( ctx, pixie::MEM_TAG_STRINGS ), size )
 #define STRPOOL_HPP_FREE( ctx, ptr ) TRACKED_FREE( ctx, ptr )
 #include "strpool.hpp"
 
@@ -12100,11 +14169,10 @@ inline u32 argb32_blend( u32 color1, u32 color2, u8 alpha )
 
 namespace pixie { namespace internal { 
 
-void* mem_sized_realloc( void* p, size_t oldsz, void* n )
+void* mem_sized_realloc( void* memctx, void* p, size_t oldsz, void* n )
 	{
-	pixie::internal::internals_t* internals = pixie::internal::internals();
 	memcpy( n, p, oldsz );
-	if( p ) TRACKED_FREE( internals->memctx, p );
+	if( p ) TRACKED_FREE( memctx, p );
 	return n;
 	}
 
@@ -12116,7 +14184,7 @@ void* mem_sized_realloc( void* p, size_t oldsz, void* n )
 #define DR_WAV_IMPLEMENTATION
 #define DR_WAV_NO_STDIO
 #define DRWAV_ASSERT( x ) PIXIE_ASSERT( x, "dr_wav PIXIE_ASSERT" )
-#define DRWAV_MALLOC( sz ) TRACKED_MALLOC( pixie::internal::internals()->memctx, sz )
+#define DRWAV_MALLOC( sz ) TRACKED_MALLOC( pixie::internal::tagged_memctx( pixie::internal::internals()->memctx, pixie::MEM_TAG_AUDIO ), sz )
 #define DRWAV_FREE( p ) TRACKED_FREE( pixie::internal::internals()->memctx, p )
 #include "dr_wav.h"
 #undef DR_WAV_IMPLEMENTATION
@@ -12173,9 +14241,9 @@ void* mem_sized_realloc( void* p, size_t oldsz, void* n )
 #define STB_IMAGE_IMPLEMENTATION
 #pragma push_macro("L")
 #undef L
-#define STBI_MALLOC( sz ) TRACKED_MALLOC( pixie::internal::internals()->memctx, sz )
-#define STBI_REALLOC_SIZED( p, oldsz, newsz ) pixie::internal::mem_sized_realloc( p, oldsz, TRACKED_MALLOC( pixie::internal::internals()->memctx, newsz ) )
-#define STBI_FREE( p ) TRACKED_FREE( pixie::internal::internals()->memctx, p )
+#define STBI_MALLOC( sz ) TRACKED_MALLOC( pixie::internal::image_memctx(), sz )
+#define STBI_REALLOC_SIZED( p, oldsz, newsz ) pixie::internal::mem_sized_realloc( pixie::internal::image_memctx(), p, oldsz, TRACKED_MALLOC( pixie::internal::image_memctx(), newsz ) )
+#define STBI_FREE( p ) TRACKED_FREE( pixie::internal::image_memctx(), p )
 #define STBI_ASSERT( x ) PIXIE_ASSERT( x, "stb_image PIXIE_ASSERT" )
 #include "stb_image.h"
 #pragma pop_macro("L")
@@ -12249,6 +14317,44 @@ char const* format_assert_message( char const* format, ... )
 		return false;
 	    }
 
+
+	void* map_file( char const* filename, size_t* size, void** handle )
+		{
+		HANDLE file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL );
+		if( file == INVALID_HANDLE_VALUE ) return 0;
+
+		LARGE_INTEGER file_size;
+		if( !GetFileSizeEx( file, &file_size ) || file_size.QuadPart == 0 ) 
+			{
+			CloseHandle( file );
+			return 0;
+			}
+
+		// map as copy-on-write, so bitmaps referencing the mapped data can still be drawn to
+		HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+		CloseHandle( file );
+		if( !mapping ) return 0;
+
+		void* data = MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+		if( !data )
+			{
+			CloseHandle( mapping );
+			return 0;
+			}
+
+		*size = (size_t) file_size.QuadPart;
+		*handle = (void*) mapping;
+		return data;
+		}
+
+
+	void unmap_file( void* data, size_t size, void* handle )
+		{
+		(void) size;
+		UnmapViewOfFile( data );
+		CloseHandle( (HANDLE) handle );
+		}
+
 #else /* _WIN32 */
 
 	#error Platform not supported
@@ -114,9 +114,10 @@ enum build_action
 	BUILD_ACTION_BUILD,
 	BUILD_ACTION_REBUILD,
 	BUILD_ACTION_CLEAN,
+	BUILD_ACTION_WATCH,
 	};
 
-int build( build_action action, char const* input_path, char const* build_path, char const* output_path, compiler_list* compilers = 0, int compilers_count = 0 );
+int build( build_action action, char const* input_path, char const* build_path, char const* output_path, compiler_list* compilers = 0, int compilers_count = 0, char const* pack_filename = 0 );
 
 using strpool::str; using strpool::trim; using strpool::ltrim; 
 using strpool::rtrim; using strpool::left; using strpool::right; using strpool::mid	; using strpool::instr; 
@@ -361,6 +362,7 @@ template< typename T > int pixie_build::find( pod_array<T> const& haystack, T co
 #define _CRT_SECURE_NO_WARNINGS
 #include <math.h>
 #include <stdarg.h>
+#include <stdio.h>
 
 
 namespace pixie_build { namespace internal { 
@@ -380,6 +382,18 @@ pixie_build::internal::internals_t* pixie_build::internal::internals()
 	return (internals_t*) ptr;
 	}
 	
+namespace pixie_build { namespace internal { 
+
+struct atlas_source
+	{
+	string atlas;
+	string built_file;
+	string name;
+	};
+
+} /* namespace internal */ } /* namespace pixie_build */
+
+
 struct pixie_build::internal::internals_t final    
 	{
 	internals_t();
@@ -391,6 +405,8 @@ struct pixie_build::internal::internals_t final
 	strpool::internal::string_pool string_pool;
 	strpool::internal::string_pool string_id_pool;
 	rnd_pcg_t rng_instance;
+
+	array<atlas_source> atlas_sources;
 	};
 
 
@@ -1102,6 +1118,234 @@ compilation_result compiler_pixie_palette( compile_context const* context )
 	}
 
 
+// Compressed pix files (version 2) have the same header as raw ones (version 1), with type 1 instead of 0. Each cel is
+// stored as offset_x, offset_y, pitch_x, pitch_y, pixels_size, mask_format, mask_size, followed by the rle encoded 
+// pixels and mask. The mask format is 0 for unmasked, 1 for one bit per pixel and 2 for one byte per pixel.
+// RLE control bytes: 0x80 | (n-3) repeats the next byte n times, (n-1) copies the next n bytes as they are.
+
+void pix_rle_encode( u8 const* src, int count, pod_array<u8>* out )
+	{
+	int i = 0;
+	while( i < count )
+		{
+		int run = 1;
+		while( i + run < count && run < 130 && src[ i + run ] == src[ i ] ) ++run;
+		if( run >= 3 )
+			{
+			out->add( (u8)( 0x80 | ( run - 3 ) ) );
+			out->add( src[ i ] );
+			i += run;
+			}
+		else
+			{
+			int start = i;
+			while( i < count && i - start < 128 && !( i + 2 < count && src[ i ] == src[ i + 1 ] && src[ i ] == src[ i + 2 ] ) ) ++i;
+			out->add( (u8)( i - start - 1 ) );
+			for( int j = start; j < i; ++j ) out->add( src[ j ] );
+			}
+		}
+	}
+
+
+void pix_append( pod_array<u8>* out, void const* data, int size )
+	{
+	for( int i = 0; i < size; ++i ) out->add( ( (u8 const*) data )[ i ] );
+	}
+
+
+ref<binary> pix_compress( u8 const* input, size_t input_size )
+	{
+	char const header[] = "PIXIE_PIX";
+	int version = 2;
+	int const* info = (int const*)( input + sizeof( header ) + sizeof( version ) );
+	int cel_count = info[ 3 ];
+	bool is_masked = info[ 4 ] != 0;
+
+	pod_array<u8> out( (int) input_size );
+	pix_append( &out, header, sizeof( header ) );
+	pix_append( &out, &version, sizeof( version ) );
+	int out_info[ 5 ] = { 1 /* rle */, info[ 1 ], info[ 2 ], cel_count, info[ 4 ] };
+	pix_append( &out, out_info, sizeof( out_info ) );
+
+	u8 const* data = (u8 const*)( info + 5 );
+	for( int i = 0; i < cel_count; ++i )
+		{
+		int cel[ 7 ];
+		memcpy( cel, data, sizeof( int ) * 4 ); data += sizeof( int ) * 4;
+		int count = cel[ 2 ] * cel[ 3 ];
+		u8 const* pixels = data; data += count;
+		u8 const* mask = is_masked ? data : 0; data += is_masked ? count : 0;
+		
+		// pixels under a fully transparent mask are never drawn, so repeat the previous one to make longer runs 
+		pod_array<u8> cel_pixels( pixels, count );
+		if( mask ) 
+			for( int j = 0; j < count; ++j ) 
+				if( mask[ j ] == 0 ) cel_pixels[ j ] = j > 0 ? cel_pixels[ j - 1 ] : (u8) 0;
+
+		int mask_format = 0;
+		pod_array<u8> cel_mask;
+		if( mask ) 
+			{
+			mask_format = 1;
+			for( int j = 0; j < count; ++j ) 
+				if( mask[ j ] != 0 && mask[ j ] != 0xff ) mask_format = 2;
+
+			if( mask_format == 1 )
+				{
+				cel_mask.resize( ( count + 7 ) / 8, 0 );
+				for( int j = 0; j < count; ++j ) 
+					if( mask[ j ] ) cel_mask[ j >> 3 ] |= (u8)( 0x80 >> ( j & 7 ) );
+				}
+			else
+				{
+				cel_mask = pod_array<u8>( mask, count );
+				}
+			}
+
+		pod_array<u8> packed_pixels;
+		pod_array<u8> packed_mask;
+		pix_rle_encode( cel_pixels.data(), cel_pixels.count(), &packed_pixels );
+		pix_rle_encode( cel_mask.data(), cel_mask.count(), &packed_mask );
+		cel[ 4 ] = packed_pixels.count();
+		cel[ 5 ] = mask_format;
+		cel[ 6 ] = packed_mask.count();
+		pix_append( &out, cel, sizeof( cel ) );
+		pix_append( &out, packed_pixels.data(), packed_pixels.count() );
+		pix_append( &out, packed_mask.data(), packed_mask.count() );
+		}
+
+	ref<binary> bin = bnew( (size_t) out.count() );
+	memcpy( bin->data, out.data(), bin->size );
+	return bin;
+	}
+
+
+// Delta pix files (version 3) have type 2, and store each cel as offset_x, offset_y, pitch_x, pitch_y, base, patch_x,
+// patch_y, patch_w, patch_h, followed by the pixels and mask of the patch. A base of -1 means a key cel, where the patch
+// covers the whole cel. Otherwise the cel is a copy of cel 'base', with the patch area (relative to the top left of the
+// cel) replaced. A patch of zero size makes it an exact copy, and can refer to any earlier cel, but a cel with a patch 
+// always refers to a key cel with the same offset and pitch.
+
+ref<binary> pix_delta( u8 const* input, size_t input_size, bool delta )
+	{
+	char const header[] = "PIXIE_PIX";
+	int version = 3;
+	int const* info = (int const*)( input + sizeof( header ) + sizeof( version ) );
+	int cel_count = info[ 3 ];
+	bool is_masked = info[ 4 ] != 0;
+
+	struct cel_t { int const* info; u8 const* pixels; u8 const* mask; int base; };
+	pod_array<cel_t> cels( cel_count );
+	u8 const* data = (u8 const*)( info + 5 );
+	for( int i = 0; i < cel_count; ++i )
+		{
+		cel_t cel;
+		cel.info = (int const*) data; data += sizeof( int ) * 4;
+		int count = cel.info[ 2 ] * cel.info[ 3 ];
+		cel.pixels = data; data += count;
+		cel.mask = is_masked ? data : 0; data += is_masked ? count : 0;
+		cel.base = -1;
+		cels.add( cel );
+		}
+
+	pod_array<u8> out( (int) input_size );
+	pix_append( &out, header, sizeof( header ) );
+	pix_append( &out, &version, sizeof( version ) );
+	int out_info[ 5 ] = { 2 /* delta */, info[ 1 ], info[ 2 ], cel_count, info[ 4 ] };
+	pix_append( &out, out_info, sizeof( out_info ) );
+
+	bool is_shared = false;
+	for( int i = 0; i < cel_count; ++i )
+		{
+		cel_t& cel = cels[ i ];
+		int pitch_x = cel.info[ 2 ];
+		int pitch_y = cel.info[ 3 ];
+		int count = pitch_x * pitch_y;
+		int patch[ 5 ] = { -1, 0, 0, pitch_x, pitch_y };
+
+		for( int j = 0; j < i; ++j )
+			{
+			if( memcmp( cels[ j ].info, cel.info, sizeof( int ) * 4 ) != 0 ) continue;
+			if( memcmp( cels[ j ].pixels, cel.pixels, (size_t) count ) != 0 ) continue;
+			if( cel.mask && memcmp( cels[ j ].mask, cel.mask, (size_t) count ) != 0 ) continue;
+			patch[ 0 ] = j;
+			patch[ 3 ] = 0;
+			patch[ 4 ] = 0;
+			break;
+			}
+
+		// only patch cels where the changed area is less than half the cel
+		int best_area = count / 2;
+		for( int j = 0; delta && patch[ 0 ] < 0 && j < i; ++j )
+			{
+			if( cels[ j ].base >= 0 || memcmp( cels[ j ].info, cel.info, sizeof( int ) * 4 ) != 0 ) continue;
+			int x_min = pitch_x;
+			int x_max = -1;
+			int y_min = pitch_y;
+			int y_max = -1;
+			for( int y = 0; y < pitch_y; ++y ) 
+				{
+				for( int x = 0; x < pitch_x; ++x ) 
+					{
+					int k = x + y * pitch_x;
+					bool visible = !cel.mask || cel.mask[ k ] || cels[ j ].mask[ k ];
+					if( ( cel.mask && cel.mask[ k ] != cels[ j ].mask[ k ] ) || ( visible && cel.pixels[ k ] != cels[ j ].pixels[ k ] ) )
+						{
+						x_min = x < x_min ? x : x_min;
+						y_min = y < y_min ? y : y_min;
+						x_max = x > x_max ? x : x_max;
+						y_max = y > y_max ? y : y_max;
+						}
+					}
+				}
+			int area = x_max < x_min ? 0 : ( x_max - x_min + 1 ) * ( y_max - y_min + 1 );
+			if( area < best_area )
+				{
+				best_area = area;
+				patch[ 0 ] = j;
+				patch[ 1 ] = area ? x_min : 0;
+				patch[ 2 ] = area ? y_min : 0;
+				patch[ 3 ] = area ? x_max - x_min + 1 : 0;
+				patch[ 4 ] = area ? y_max - y_min + 1 : 0;
+				}
+			}
+
+		cel.base = patch[ 0 ];
+		is_shared = is_shared || cel.base >= 0;
+		pix_append( &out, cel.info, sizeof( int ) * 4 );
+		pix_append( &out, patch, sizeof( patch ) );
+		for( int y = 0; y < patch[ 4 ]; ++y )
+			pix_append( &out, cel.pixels + patch[ 1 ] + ( patch[ 2 ] + y ) * pitch_x, patch[ 3 ] );
+		for( int y = 0; cel.mask && y < patch[ 4 ]; ++y )
+			pix_append( &out, cel.mask + patch[ 1 ] + ( patch[ 2 ] + y ) * pitch_x, patch[ 3 ] );
+		}
+
+	// only worth using if any of the cels could be shared or patched
+	if( !is_shared ) return ref<binary>::ref();
+
+	ref<binary> bin = bnew( (size_t) out.count() );
+	memcpy( bin->data, out.data(), bin->size );
+	return bin;
+	}
+
+
+// compression "rle" writes compressed pix files, "none" raw ones, and by default identical cels are shared, and if
+// delta is set, cels which differ from an earlier cel only in a small area are stored as a patch over that cel
+void save_pix( u8 const* data, size_t size, string const& filename, string const& compression, bool delta = false )
+	{
+	ref<binary> output;
+	if( compression == "rle" )
+		output = pix_compress( data, size );
+	else if( compression != "none" )
+		output = pix_delta( data, size, delta );
+
+	if( output )
+		file_save_data( output->data, output->size, filename.c_str(), FILE_MODE_BINARY );
+	else
+		file_save_data( data, size, filename.c_str(), FILE_MODE_BINARY );
+	}
+
+
 compilation_result compiler_pixie_bitmap_single( compile_context const* context )
 	{		
 	compilation_result result = { 0 };
@@ -1109,6 +1353,7 @@ compilation_result compiler_pixie_bitmap_single( compile_context const* context
 	string format;
 	string palette;
 	string dither;
+	string compression;
 	for( int i = 0; i < context->parameters.count(); ++i )
 		{
 		string_id name( context->parameters[ i ].name );
@@ -1119,6 +1364,10 @@ compilation_result compiler_pixie_bitmap_single( compile_context const* context
 				{
 				format = value;
 				}
+			str_case( "compression" )
+				{
+				compression = value;
+				}
 			str_case( "palette" )
 				{
 				palette = value;
@@ -1133,10 +1382,11 @@ compilation_result compiler_pixie_bitmap_single( compile_context const* context
 	string input_file = path_join( context->input_root, context->path, context->input );
 
 	string output_file = path_join( context->output_root, context->path, basename( context->input ) ) + ".pix";
-	if( !file_exists( output_file.c_str() ) || file_more_recent( input_file.c_str(), output_file.c_str() ) )
+	string palette_input = path_join( context->input_root, palette );
+	if( !file_exists( output_file.c_str() ) || file_more_recent( input_file.c_str(), output_file.c_str() ) || 
+		( palette != "" && file_more_recent( palette_input.c_str(), output_file.c_str() ) ) )
 		{
 		string palette_file = path_join( context->build_root, dirname( palette ), basename( palette ) ) + ".plut";
-		string palette_input = path_join( context->input_root, palette );
 		if( !file_exists( palette_file.c_str() ) || file_more_recent( palette_input.c_str(), palette_file.c_str() ) )
 			{
 			logf( palette + "\n" );
@@ -1257,7 +1507,7 @@ compilation_result compiler_pixie_bitmap_single( compile_context const* context
 		info[ 4 ] = is_masked ? 1 : 0;
 		
 		create_path( path_join( context->output_root, context->path ).c_str() );
-		file_save_data( output, size, output_file.c_str(), FILE_MODE_BINARY );
+		save_pix( output, size, output_file, compression );
 		free( output );
 		paldither_palette_destroy( pal );		
 		}
@@ -1293,10 +1543,24 @@ compilation_result compiler_pixie_bitmap_strip( compile_context const* context )
 
 	pixie_build::sort( &inputs );
 
+	// the individual frames are always built uncompressed, as they are combined into a strip below
+	string compression;
+	bool delta = false;
+	compile_context single_context = *context;
+	single_context.output_root = single_context.build_root;
+	single_context.parameters.clear();
+	for( int i = 0; i < context->parameters.count(); ++i )
+		{
+		if( context->parameters[ i ].name == "compression" )
+			compression = context->parameters[ i ].value;
+		else if( context->parameters[ i ].name == "delta" )
+			delta = context->parameters[ i ].value == "yes";
+		else
+			single_context.parameters.add( context->parameters[ i ] );
+		}
+
 	for( int i = 0; i < inputs.count(); ++i )
 		{
-		compile_context single_context = *context;
-		single_context.output_root = single_context.build_root;
 		single_context.input = inputs[ i ];
 		compiler_pixie_bitmap_single( &single_context );
 		}	
@@ -1307,7 +1571,7 @@ compilation_result compiler_pixie_bitmap_strip( compile_context const* context )
 		{
 		for( int i = 0; i < inputs.count(); ++i )
 			{
-			string build_file = path_join( context->build_root, context->path, basename( context->input ) ) + ".pix";	
+			string build_file = path_join( context->build_root, context->path, basename( inputs[ i ] ) ) + ".pix";	
 			if( file_more_recent( build_file.c_str(), output_file.c_str() ) )
 				{
 				need_to_build = true;
@@ -1374,7 +1638,7 @@ compilation_result compiler_pixie_bitmap_strip( compile_context const* context )
 			size += pitch_x * pitch_y * ( is_masked ? 2 : 1 );
 			}
 		create_path( path_join( context->output_root, context->path ).c_str() );
-		file_save_data( output, size, output_file.c_str(), FILE_MODE_BINARY );
+		save_pix( output, size, output_file, compression, delta );
 		free( output );
 		}
 	
@@ -1382,6 +1646,41 @@ compilation_result compiler_pixie_bitmap_strip( compile_context const* context )
 	}
 	
 	
+// bitmaps with an "atlas" parameter are built to the build folder rather than the output folder, and are then packed 
+// into a shared atlas file once all other files have been built (see build_atlases)
+compilation_result compile_bitmap( compile_context const* context, compilation_result (*compiler)( compile_context const* ), string const& output_name )
+	{
+	string atlas;
+	for( int i = 0; i < context->parameters.count(); ++i )
+		if( context->parameters[ i ].name == "atlas" ) atlas = context->parameters[ i ].value;
+
+	if( atlas == "" ) return compiler( context );
+
+	// the atlas packer reads raw pix files, and shares identical cels itself
+	compile_context atlas_context = *context;
+	atlas_context.output_root = context->build_root;
+	atlas_context.parameters.clear();
+	for( int i = 0; i < context->parameters.count(); ++i )
+		{
+		string_id const& name = context->parameters[ i ].name;
+		if( name != "atlas" && name != "compression" && name != "delta" ) 
+			atlas_context.parameters.add( context->parameters[ i ] );
+		}
+	compiler_param compression;
+	compression.name = "compression";
+	compression.value = "none";
+	atlas_context.parameters.add( compression );
+
+	compilation_result result = compiler( &atlas_context );
+
+	internal::atlas_source& source = internal::internals()->atlas_sources.add();
+	source.atlas = atlas;
+	source.built_file = path_join( context->build_root, context->path, output_name );
+	source.name = path_join( context->output_root, context->path, output_name );
+	return result;
+	}
+
+
 compilation_result compiler_pixie_bitmap( compile_context const* context )
 	{
 	string name = basename( context->input );
@@ -1446,16 +1745,408 @@ compilation_result compiler_pixie_bitmap( compile_context const* context )
 		next_frame = stripped_name + "_" + next_frame;
 		next_frame = path_join( context->input_root, context->path, next_frame ) + extname( context->input );
 		if( file_exists( next_frame.c_str() ) )
-			return compiler_pixie_bitmap_strip( context );		
+			return compile_bitmap( context, compiler_pixie_bitmap_strip, stripped_name + ".pix" );		
 		}
 	
-	return compiler_pixie_bitmap_single( context );		
+	return compile_bitmap( context, compiler_pixie_bitmap_single, name + ".pix" );		
 	}
 	
 
-int build( build_action action, char const* input_path, char const* build_path, char const* output_path, compiler_list* compilers, int compilers_count )
+// checks that a file is a raw (uncompressed) pix file, the same way load_bitmap does, and that its cels fit in the file
+bool pix_validate_raw( ref<binary> const& file )
+	{
+	char const header[] = "PIXIE_PIX";
+	if( file->size < sizeof( header ) + 6 * sizeof( int ) || memcmp( file->data, header, sizeof( header ) ) != 0 ) 
+		return false;
+
+	int const* info = (int const*)( (u8 const*) file->data + sizeof( header ) );
+	int const version = *info++;
+	if( version < 1 || version > 3 || info[ 0 ] != 0 ) return false;
+	if( info[ 1 ] < 0 || info[ 2 ] < 0 || info[ 3 ] < 0 ) return false;
+
+	u8 const* src = (u8 const*)( info + 5 );
+	u8 const* end = (u8 const*) file->data + file->size;
+	for( int i = 0; i < info[ 3 ]; ++i )
+		{
+		int cel[ 4 ];
+		if( (size_t)( end - src ) < sizeof( cel ) ) return false;
+		memcpy( cel, src, sizeof( cel ) ); src += sizeof( cel );
+		if( cel[ 2 ] < 0 || cel[ 3 ] < 0 || ( cel[ 3 ] > 0 && cel[ 2 ] > 0x7fffffff / cel[ 3 ] ) ) return false;
+		size_t const count = (size_t) cel[ 2 ] * (size_t) cel[ 3 ];
+		if( (size_t)( end - src ) < count ) return false;
+		src += count;
+		if( info[ 4 ] )
+			{
+			if( (size_t)( end - src ) < count ) return false;
+			src += count;
+			}
+		}
+	return true;
+	}
+
+
+// Atlas files hold the cels of many bitmaps in one shared block of pixel data:
+//   "PIXIE_ATL\0", int version, int entry_count, int names_offset, int data_offset
+//   entries - int name_offset, width, height, cel_count, is_masked, followed by cel_count cels of
+//             int offset_x, offset_y, pitch_x, pitch_y, pixels_offset, mask_offset (-1 for unmasked)
+//   zero terminated bitmap names - the filename the bitmap would otherwise have been written to
+//   pixel data - the trimmed cels packed back to back, in the order they were built, pixels followed by mask
+//                identical cels (within or across bitmaps) are only stored once, and share the same offsets
+// Names are relative to the start of the names block, and pixel/mask offsets to the start of the pixel data.
+
+int pack_atlas( string const& atlas_file, array<internal::atlas_source> const& sources )
 	{
-	(void) action, input_path, build_path, output_path, compilers, compilers_count;
+	char const header[] = "PIXIE_PIX";
+	int version = 1;
+
+	// files which can't be used are left out of the atlas, so the remaining bitmaps still get packed
+	int retval = 0;
+	int entry_count = 0;
+	pod_array<u8> entries;
+	pod_array<u8> names;
+	pod_array<u8> data;
+	pod_array<int> stored_cels; // count, pixels_offset, mask_offset for each unique cel
+	for( int i = 0; i < sources.count(); ++i )
+		{
+		ref<binary> file = bload( sources[ i ].built_file );
+		if( !file ) 
+			{
+			logf( "%s(%d) : error: failed to load '%s' for atlas '%s'\n", __FILE__, __LINE__, sources[ i ].built_file.c_str(), atlas_file.c_str() );
+			retval = -1;
+			continue;
+			}
+		if( !pix_validate_raw( file ) )
+			{
+			logf( "%s(%d) : error: '%s' is not a valid raw pix file, leaving it out of atlas '%s'\n", __FILE__, __LINE__, sources[ i ].built_file.c_str(), atlas_file.c_str() );
+			retval = -1;
+			continue;
+			}
+		++entry_count;
+
+		int const* info = (int const*)( (u8 const*) file->data + sizeof( header ) + sizeof( version ) );
+		int cel_count = info[ 3 ];
+		bool is_masked = info[ 4 ] != 0;
+		int entry[ 5 ] = { names.count(), info[ 1 ], info[ 2 ], cel_count, info[ 4 ] };
+		pix_append( &entries, entry, sizeof( entry ) );
+		pix_append( &names, sources[ i ].name.c_str(), len( sources[ i ].name ) + 1 );
+
+		u8 const* src = (u8 const*)( info + 5 );
+		for( int j = 0; j < cel_count; ++j )
+			{
+			int cel[ 6 ];
+			memcpy( cel, src, sizeof( int ) * 4 ); src += sizeof( int ) * 4;
+			int count = cel[ 2 ] * cel[ 3 ];
+			u8 const* pixels = src; src += count;
+			u8 const* mask = is_masked ? src : 0; src += is_masked ? count : 0;
+			cel[ 4 ] = -1;
+			for( int k = 0; k < stored_cels.count(); k += 3 )
+				{
+				if( stored_cels[ k ] != count || ( stored_cels[ k + 2 ] < 0 ) != ( mask == 0 ) ) continue;
+				if( memcmp( data.data() + stored_cels[ k + 1 ], pixels, (size_t) count ) != 0 ) continue;
+				if( mask && memcmp( data.data() + stored_cels[ k + 2 ], mask, (size_t) count ) != 0 ) continue;
+				cel[ 4 ] = stored_cels[ k + 1 ];
+				cel[ 5 ] = stored_cels[ k + 2 ];
+				break;
+				}
+			if( cel[ 4 ] < 0 )
+				{
+				cel[ 4 ] = data.count();
+				pix_append( &data, pixels, count );
+				cel[ 5 ] = -1;
+				if( mask )
+					{
+					cel[ 5 ] = data.count();
+					pix_append( &data, mask, count );
+					}
+				stored_cels.add( count );
+				stored_cels.add( cel[ 4 ] );
+				stored_cels.add( cel[ 5 ] );
+				}
+			pix_append( &entries, cel, sizeof( cel ) );
+			}
+		}
+
+	char const atlas_header[] = "PIXIE_ATL";
+	int atlas_info[ 4 ] = { 1 /* version */, entry_count, 0, 0 };
+	atlas_info[ 2 ] = (int)( sizeof( atlas_header ) + sizeof( atlas_info ) ) + entries.count();
+	atlas_info[ 3 ] = atlas_info[ 2 ] + names.count();
+
+	pod_array<u8> output( atlas_info[ 3 ] + data.count() );
+	pix_append( &output, atlas_header, sizeof( atlas_header ) );
+	pix_append( &output, atlas_info, sizeof( atlas_info ) );
+	pix_append( &output, entries.data(), entries.count() );
+	pix_append( &output, names.data(), names.count() );
+	pix_append( &output, data.data(), data.count() );
+	
+	create_path( dirname( atlas_file ).c_str() );
+	file_save_data( output.data(), (size_t) output.count(), atlas_file.c_str(), FILE_MODE_BINARY );
+	return retval;
+	}
+
+
+int build_atlases( string const& output, array<internal::atlas_source> const& sources )
+	{
+	int retval = 0;
+	array<string> atlases;
+	for( int i = 0; i < sources.count(); ++i )
+		if( find( atlases, sources[ i ].atlas ) < 0 ) atlases.add( sources[ i ].atlas );
+
+	for( int i = 0; i < atlases.count(); ++i )
+		{
+		string atlas_file = path_join( output, atlases[ i ] ) + ".atlas";
+		bool need_to_build = !file_exists( atlas_file );
+		array<internal::atlas_source> atlas_sources;
+		for( int j = 0; j < sources.count(); ++j )
+			{
+			if( sources[ j ].atlas != atlases[ i ] ) continue;
+			atlas_sources.add( sources[ j ] );
+			if( file_more_recent( sources[ j ].built_file.c_str(), atlas_file.c_str() ) ) need_to_build = true;
+			}
+
+		if( need_to_build ) 
+			{
+			logf( atlas_file + "\n" );
+			if( pack_atlas( atlas_file, atlas_sources ) != 0 ) retval = -1;
+			}
+		}
+
+	return retval;
+	}
+
+
+
+// Pack files hold all built output in a single archive, laid out so it can be memory mapped by the runtime:
+//   "PIXIE_PAK\0", int version, int file_count, int slot_count, int names_offset - padded to PACK_HEADER_SIZE
+//   pack_slot[ slot_count ] - open addressing hash table (linear probing) of file paths
+//   zero terminated file paths
+//   file data - each file starts on a PACK_ALIGNMENT boundary, and is followed by at least one zero byte
+
+static int const PACK_HEADER_SIZE = 32;
+static size_t const PACK_ALIGNMENT = 16;
+static u32 const PACK_EMPTY_SLOT = 0xffffffffU;
+
+struct pack_slot
+	{
+	u32 hash;
+	u32 name_offset;
+	u64 data_offset;
+	u64 data_size;
+	};
+
+
+u32 pack_hash( char const* str )
+	{
+	// FNV-1a, with backslashes hashed as forward slashes - must match the lookup in pixie.hpp
+	u32 hash = 2166136261U;
+	while( *str )
+		{
+		char c = *str++;
+		hash = ( hash ^ (u32)(u8)( c == '\\' ? '/' : c ) ) * 16777619U;
+		}
+	return hash;
+	}
+
+
+// returns false if any of the folders couldn't be read, in which case the list is incomplete
+bool pack_collect_files( string const& path, array<string>* files )
+	{
+	dir_t* dir = dir_open( path.c_str() );
+	if( !dir ) 
+		{
+		logf( "%s(%d) : error: failed to open folder '%s'\n", __FILE__, __LINE__, path.c_str() );
+		return false;
+		}
+	bool result = true;
+	dir_entry_t* ent = dir_read( dir );
+	while( ent )
+	    {
+	    if( dir_is_folder( ent ) && strcmp( dir_name( ent ), "." ) != 0 && strcmp( dir_name( ent ), ".." ) != 0 )
+			result = pack_collect_files( path_join( path, dir_name( ent ) ), files ) && result;
+	    else if( dir_is_file( ent ) )
+			files->add( path_join( path, dir_name( ent ) ) );
+	    ent = dir_read( dir );
+	    }
+	dir_close( dir );
+	return result;
+	}
+
+
+int pack_dir( string const& input, string const& pack_filename )
+	{
+	if( file_exists( pack_filename ) && !contains_more_recent_file( input.c_str(), pack_filename.c_str() ) ) return 0;
+
+	array<string> files;
+	if( !pack_collect_files( input, &files ) ) return -1;
+	pixie_build::sort( &files );
+
+	int slot_count = 16;
+	while( slot_count < files.count() * 2 ) slot_count *= 2;
+	pod_array<pack_slot> slots( slot_count );
+	for( int i = 0; i < slot_count; ++i ) 
+		{
+		pack_slot empty = { 0, PACK_EMPTY_SLOT, 0, 0 };
+		slots.add( empty );
+		}
+
+	size_t names_offset = PACK_HEADER_SIZE + slot_count * sizeof( pack_slot );
+	size_t names_size = 0;
+	for( int i = 0; i < files.count(); ++i ) names_size += len( files[ i ] ) + 1;
+	size_t data_offset = ( names_offset + names_size + PACK_ALIGNMENT - 1 ) & ~( PACK_ALIGNMENT - 1 );
+
+	FILE* fp = fopen( pack_filename.c_str(), "wb" );
+	if( !fp ) 
+		{
+		logf( "%s(%d) : error: failed to create pack file '%s'\n", __FILE__, __LINE__, pack_filename.c_str() );
+		return -1;
+		}
+
+	logf( pack_filename + "\n" );
+
+	// file data goes first, as the directory can't be written until all the offsets are known
+	u8 const padding[ PACK_ALIGNMENT ] = { 0 };
+	bool ok = fseek( fp, (long) data_offset, SEEK_SET ) == 0;
+	size_t offset = data_offset;
+	size_t name_offset = names_offset;
+	for( int i = 0; ok && i < files.count(); ++i )
+		{
+		ref<binary> file = bload( files[ i ] );
+		if( !file )
+			{
+			logf( "%s(%d) : error: failed to load '%s' for pack file '%s'\n", __FILE__, __LINE__, files[ i ].c_str(), pack_filename.c_str() );
+			ok = false;
+			}
+		else
+			{
+			u32 hash = pack_hash( files[ i ].c_str() );
+			int slot = (int)( hash & ( slot_count - 1 ) );
+			while( slots[ slot ].name_offset != PACK_EMPTY_SLOT ) slot = ( slot + 1 ) & ( slot_count - 1 );
+			slots[ slot ].hash = hash;
+			slots[ slot ].name_offset = (u32) name_offset;
+			slots[ slot ].data_offset = (u64) offset;
+			slots[ slot ].data_size = (u64) file->size;
+			
+			size_t padded_size = ( file->size + 1 + PACK_ALIGNMENT - 1 ) & ~( PACK_ALIGNMENT - 1 );
+			ok = ok && fwrite( file->data, 1, file->size, fp ) == file->size;
+			ok = ok && fwrite( padding, 1, padded_size - file->size, fp ) == padded_size - file->size;
+			offset += padded_size;
+			}
+		name_offset += len( files[ i ] ) + 1;
+		}
+
+	char const header[] = "PIXIE_PAK";
+	int info[ 4 ] = { 1 /* version */, files.count(), slot_count, (int) names_offset };
+	size_t const header_padding = PACK_HEADER_SIZE - sizeof( header ) - sizeof( info );
+	ok = ok && fseek( fp, 0, SEEK_SET ) == 0;
+	ok = ok && fwrite( header, 1, sizeof( header ), fp ) == sizeof( header );
+	ok = ok && fwrite( info, 1, sizeof( info ), fp ) == sizeof( info );
+	ok = ok && fwrite( padding, 1, header_padding, fp ) == header_padding;
+	ok = ok && fwrite( slots.data(), sizeof( pack_slot ), (size_t) slot_count, fp ) == (size_t) slot_count;
+	for( int i = 0; ok && i < files.count(); ++i ) 
+		ok = fwrite( files[ i ].c_str(), 1, (size_t) len( files[ i ] ) + 1, fp ) == (size_t) len( files[ i ] ) + 1;
+	ok = fclose( fp ) == 0 && ok;
+
+	// don't leave a broken pack behind, as it would look up to date to the next build
+	if( !ok )
+		{
+		logf( "%s(%d) : error: failed to write pack file '%s'\n", __FILE__, __LINE__, pack_filename.c_str() );
+		::remove( pack_filename.c_str() );
+		return -1;
+		}
+
+	return 0;
+	}
+
+
+int build_pass( build_t* build, char const* pack_filename )
+	{
+	internal::internals_t* internals = internal::internals();
+	internals->atlas_sources.clear();
+
+	config cfg;
+	compile_counts counts = build_dir( build, cfg, build->root_input, build->root_build, build->root_output );
+	int retval = ( counts.failed > 0 ? -1 : 0 );
+	if( build_atlases( build->root_output, internals->atlas_sources ) != 0 ) retval = -1;
+	if( retval == 0 && pack_filename ) retval = pack_dir( build->root_output, pack_filename );
+	return retval;
+	}
+
+
+// Watch mode rebuilds whenever anything in the input folder changes, once no further changes have happened for 
+// WATCH_DEBOUNCE_MS. Only out of date files are rebuilt, same as for a normal build, and the paths of all output files
+// written by the rebuild are appended, one per line, to "<output>.updates", for a running game to pick up through
+// pixie::resource_updates.
+
+static int const WATCH_DEBOUNCE_MS = 250;
+
+void* watch_create( char const* path );
+void watch_destroy( void* watch );
+bool watch_wait( void* watch, int timeout_ms );
+u64 watch_file_time( char const* path );
+
+
+// sorted list of all files in the output folder, with the last write time of each
+void watch_collect_times( string const& path, array<string>* files, pod_array<u64>* times )
+	{
+	files->clear();
+	times->clear();
+	pack_collect_files( path, files );
+	pixie_build::sort( files );
+	for( int i = 0; i < files->count(); ++i )
+		times->add( watch_file_time( (*files)[ i ].c_str() ) );
+	}
+
+
+int watch( build_t* build, char const* pack_filename )
+	{
+	void* watch = watch_create( build->root_input.c_str() );
+	if( !watch )
+		{
+		logf( "%s(%d) : error: failed to watch folder '%s'\n", __FILE__, __LINE__, build->root_input.c_str() );
+		return -1;
+		}
+
+	string updates_file = build->root_output + ".updates";
+	array<string> files;
+	pod_array<u64> times;
+	watch_collect_times( build->root_output, &files, &times );
+	logf( "Watching '%s' for changes\n", build->root_input.c_str() );
+	while( watch_wait( watch, -1 ) )
+		{
+		while( watch_wait( watch, WATCH_DEBOUNCE_MS ) ) { /* wait for changes to settle */ }
+		build_pass( build, pack_filename );
+
+		// the files written by this rebuild are the ones which are new, or were written to since the previous pass. 
+		// comparing each file against its own earlier time means it doesn't matter how fine the timestamps are
+		array<string> new_files;
+		pod_array<u64> new_times;
+		watch_collect_times( build->root_output, &new_files, &new_times );
+		FILE* fp = fopen( updates_file.c_str(), "a" );
+		if( !fp )
+			{
+			// keep the old times, so the files from this pass are reported by the next one instead
+			logf( "%s(%d) : error: failed to open updates file '%s'\n", __FILE__, __LINE__, updates_file.c_str() );
+			continue;
+			}
+		int j = 0;
+		for( int i = 0; i < new_files.count(); ++i )
+			{
+			while( j < files.count() && files[ j ] < new_files[ i ] ) ++j;
+			if( j >= files.count() || files[ j ] != new_files[ i ] || times[ j ] != new_times[ i ] ) 
+				fprintf( fp, "%s\n", new_files[ i ].c_str() );
+			}
+		fclose( fp );
+		files = new_files;
+		times = new_times;
+		}
+
+	watch_destroy( watch );
+	return -1;
+	}
+
+
+int build( build_action action, char const* input_path, char const* build_path, char const* output_path, compiler_list* compilers, int compilers_count, char const* pack_filename )
+	{
+	(void) action, input_path, build_path, output_path, compilers, compilers_count, pack_filename;
 
 	static thread_atomic_int_t init_count; 
 	if( thread_atomic_int_inc( &init_count ) == 0 ) pixie_build::internal::internals_tls = thread_tls_create();
@@ -1496,12 +2187,11 @@ int build( build_action action, char const* input_path, char const* build_path,
 		assert( !"Not implemented yet." ); // TODO: implement clean
 		}
 
-	if( action == BUILD_ACTION_BUILD || action == BUILD_ACTION_REBUILD )
-		{
-		config cfg;
-		compile_counts counts = build_dir( &build, cfg, input, builddir, output );
-		retval = ( counts.failed > 0 ? -1 : 0 );
-		}
+	if( action == BUILD_ACTION_BUILD || action == BUILD_ACTION_REBUILD || action == BUILD_ACTION_WATCH )
+		retval = build_pass( &build, pack_filename );
+
+	if( action == BUILD_ACTION_WATCH ) 
+		retval = watch( &build, pack_filename );
 		
 	log_destroy( internals->log );
 	free( internals->log_buffer );
@@ -1602,6 +2292,47 @@ int pixie_build::clamp( int x, int min_val, int max_val )
 #include "vecmath.hpp"
 
 
+#ifdef _WIN32
+
+	// windows.h is already included by file_util.h
+
+	void* pixie_build::watch_create( char const* path )
+		{
+		HANDLE handle = FindFirstChangeNotificationA( path, TRUE, FILE_NOTIFY_CHANGE_FILE_NAME | 
+			FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE );
+		return handle == INVALID_HANDLE_VALUE ? 0 : (void*) handle;
+		}
+
+
+	void pixie_build::watch_destroy( void* watch )
+		{
+		FindCloseChangeNotification( (HANDLE) watch );
+		}
+
+
+	// returns false if there were no changes before the timeout (a negative timeout waits forever)
+	bool pixie_build::watch_wait( void* watch, int timeout_ms )
+		{
+		DWORD result = WaitForSingleObject( (HANDLE) watch, timeout_ms < 0 ? INFINITE : (DWORD) timeout_ms );
+		if( result != WAIT_OBJECT_0 ) return false;
+		FindNextChangeNotification( (HANDLE) watch );
+		return true;
+		}
+
+
+	// last write time in 100 nanosecond units, or 0 if the file can't be found
+	u64 pixie_build::watch_file_time( char const* path )
+		{
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if( !GetFileAttributesExA( path, GetFileExInfoStandard, &data ) ) return 0;
+		return ( ( (u64) data.ftLastWriteTime.dwHighDateTime ) << 32 ) | (u64) data.ftLastWriteTime.dwLowDateTime;
+		}
+
+#else 
+	#error Platform not supported
+#endif
+
+
 #pragma warning( push )
 #pragma warning( disable: 4619 ) // there is no warning number 'nnnn'
 #pragma warning( disable: 4100 ) // unreferenced formal parameter
@@ -8,6 +8,15 @@ refcount.hpp - v0.1 - Simple reference counting pointer wrapper for C++.
 Do this:
 	#define REFCOUNT_IMPLEMENTATION
 before you include this file in *one* C++ file to create the implementation.
+
+The reference count is stored in the same allocation as the instance (for make_new, and for any make_ref call which 
+passes a count pointer into the instance storage and a null destroy_count), so a ref costs a single allocation. 
+
+Define
+	#define REFCOUNT_THREAD_SAFE
+before including this file (consistently, in every file) to use atomic increments/decrements for the count, so that 
+refs to the same instance can be copied and released from different threads. Note that this only makes the count
+itself thread safe, not the ref object or the instance it points to.
 */
 
 #ifndef refcount_hpp
@@ -93,6 +102,9 @@ template< typename T, typename P0, typename P1, typename P2, typename P3, typena
 #define _CRT_NONSTDC_NO_DEPRECATE 
 #define _CRT_SECURE_NO_WARNINGS
 #include <stddef.h>
+#if defined( REFCOUNT_THREAD_SAFE ) && defined( _MSC_VER )
+	#include <intrin.h>
+#endif
 
 // placement new
 #if !defined( PLACEMENT_NEW_OPERATOR_DEFINED ) && !defined( __PLACEMENT_NEW_INLINE )
@@ -106,12 +118,45 @@ namespace refcount { namespace internal {
 void* mem_alloc( size_t size );
 void mem_free( void* ptr );
 
+inline void count_inc( int* count )
+	{
+	#if !defined( REFCOUNT_THREAD_SAFE )
+		++(*count);
+	#elif defined( _MSC_VER )
+		_InterlockedIncrement( (long volatile*) count );
+	#else
+		__sync_add_and_fetch( count, 1 );
+	#endif
+	}
+
+// returns the new count
+inline int count_dec( int* count )
+	{
+	#if !defined( REFCOUNT_THREAD_SAFE )
+		return --(*count);
+	#elif defined( _MSC_VER )
+		return (int) _InterlockedDecrement( (long volatile*) count );
+	#else
+		return __sync_sub_and_fetch( count, 1 );
+	#endif
+	}
+
+template< typename T > void release( T* instance, void (*destroy_instance)( void* ), int* count, void (*destroy_count)( int* ) )
+	{
+	if( count && count_dec( count ) == 0 ) 
+		{ 
+		if( destroy_instance ) destroy_instance( instance );
+		if( destroy_count ) destroy_count( count );
+		} 
+	}
+
 template< typename T > void alloc_helper( void** ptr, int** count )
 	{
-	size_t size = sizeof( T ) + sizeof( int ) ;
+	size_t count_offset = ( sizeof( T ) + sizeof( int ) - 1 ) & ~( sizeof( int ) - 1 ); // keep the count aligned
+	size_t size = count_offset + sizeof( int );
 	uintptr_t storage = (uintptr_t) mem_alloc( size );
 	*ptr = (void*) storage;
-	*count = (int*)( storage + sizeof( T ) );
+	*count = (int*)( storage + count_offset );
 	}
 
 template< typename T > void destroy_helper( void* ptr ) 
@@ -160,7 +205,7 @@ template< typename T > ref<T>::ref( ref<T> const& other ):
 	count_( other.count_ ),
 	destroy_count_( other.destroy_count_ )
 	{ 
-	if( count_ ) ++(*count_); 
+	if( count_ ) internal::count_inc( count_ ); 
 	}
 
 
@@ -168,20 +213,17 @@ template< typename T > ref<T>& ref<T>::operator=( ref<T> const& other )
 	{ 
 	if( instance_ != other.instance_ ) 
 		{ 
-		if( count_ )
-			{
-			--(*count_); 
-			if( *count_ == 0 ) 
-				{ 
-				if( destroy_instance_ ) destroy_instance_( instance_ );
-				if( destroy_count_ ) destroy_count_( count_ );
-				} 
-			}
+		// take the new reference before releasing the old one, in case other is owned by the old instance
+		if( other.count_ ) internal::count_inc( other.count_ ); 
+		T* instance = instance_;
+		void (*destroy_instance)( void* ) = destroy_instance_;
+		int* count = count_;
+		void (*destroy_count)( int* ) = destroy_count_;
 		instance_ = other.instance_; 
 		destroy_instance_ = other.destroy_instance_; 
 		count_ = other.count_; 
 		destroy_count_ = other.destroy_count_;
-		if( count_ ) ++(*count_); 
+		internal::release( instance, destroy_instance, count, destroy_count );
 		} 
 	return *this; 
 	}
@@ -189,15 +231,7 @@ template< typename T > ref<T>& ref<T>::operator=( ref<T> const& other )
 
 template< typename T > ref<T>::~ref() 
 	{ 
-	if( count_ )
-		{
-		--(*count_); 
-		if( *count_ == 0 ) 
-			{ 
-			if( destroy_instance_ ) destroy_instance_( instance_ );
-			if( destroy_count_ ) destroy_count_( count_ );
-			} 
-		}
+	internal::release( instance_, destroy_instance_, count_, destroy_count_ );
 	}
 
 
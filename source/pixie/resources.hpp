@@ -29,6 +29,22 @@ struct resource_system
 	resource_system( void* memctx = 0 );
 	~resource_system();
 
+	// Resources which are no longer referenced are kept around (if they have a non-anonymous key) until the total size
+	// of all cached resources exceeds the budget, at which point the least recently used ones are destroyed. The size
+	// of a resource is given by resource_size, which defaults to sizeof( T ). The default budget of 0 disables caching
+	void cache_budget( RESOURCES_U64 bytes );
+
+	struct cache_stats_t
+		{
+		int hits; // requests which revived a cached, unreferenced resource
+		int misses; // requests which had to create the resource
+		int evictions;
+		int cached_count;
+		RESOURCES_U64 cached_size;
+		RESOURCES_U64 budget;
+		};
+	cache_stats_t cache_stats() const;
+
 	private:
 		template< typename T > friend struct resource;
 		internal::system_t* internals_;			
@@ -48,6 +64,14 @@ struct resource_key
 	};
 
 
+// Pass as the first parameter when constructing a resource, to have it created in the background. The resource type
+// needs to provide resource_request/resource_poll (see below), and the resource stays pending until it is polled as 
+// ready, or until it is first dereferenced, which waits for it to complete. A request which completes without setting
+// an instance is a failed load, which can be checked with failed().
+struct async_t {};
+static async_t const async = async_t();
+
+
 template< typename T > struct resource
 	{
 	resource( resource_system* system );
@@ -83,24 +107,29 @@ template< typename T > struct resource
 	template< typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9 > 
 	resource( resource_system* system, P0 const& p0, P1 const& p1, P2 const& p2, P3 const& p3, P4 const& p4, P5 const& p5, P6 const& p6, P7 const& p7, P8 const& p8, P9 const& p9 );
 
+	template< typename P0 > 
+	resource( resource_system* system, async_t, P0 const& p0 );
+
 	resource( resource const& other );
 	resource const& operator=( resource const& other );
 
 	operator T*() const;
 	T* operator->() const;
 	
-	bool empty() const { return !instance_; }
+	bool empty() const { return !(T*)*this; }
+	bool ready() const;
+	bool failed() const; // completed without an instance, e.g. if an async load couldn't be decoded
 	
 	struct list
 		{
 		int count;
 		T** items;
 		};
-	static list resource_list();
+	static list resource_list( resource_system* system ); // referenced resources only, valid until resources are next requested or released
 			
 	private:
 		resource_system* system_;
-		T* instance_;
+		mutable T* instance_; // 0 while pending
 		int handle_;
 		int type_;
 	};
@@ -131,6 +160,8 @@ namespace resources { namespace internal {
 
 typedef void* (*create_func_t)( char const* filename );
 typedef void (*destroy_func_t)( resource_key* key, void* instance );
+typedef bool (*poll_func_t)( void** instance, void* request, bool wait );
+typedef RESOURCES_U64 (*size_func_t)( void* instance );
 
 void** get_resource_list( system_t* system, type_id_t type, int* count );
 		
@@ -140,16 +171,29 @@ struct info_t
 	int handle;
 	int type;
 	};
-info_t inject( system_t* system, type_id_t type, resource_key const* key, destroy_func_t destroy );
+info_t inject( system_t* system, type_id_t type, resource_key const* key, destroy_func_t destroy, size_func_t size );
 void* get_instance( system_t* system, int type, int handle );
 int inc_ref( system_t* system, int type, int handle );
 int dec_ref( system_t* system, int type, int handle );
+bool is_pending( system_t* system, int type, int handle );
+void set_pending( system_t* system, int type, int handle, void* request, poll_func_t poll );
+void* complete( system_t* system, int type, int handle, bool wait );
 
 template< typename T > void destroy_template( resource_key* key, void* const instance ) 
 	{ 
 	resources::resource_destroy( key, (T*) instance ); 
 	}
 
+template< typename T > bool poll_template( void** instance, void* request, bool wait ) 
+	{ 
+	return resources::resource_poll( (T**) instance, request, wait ); 
+	}
+
+template< typename T > RESOURCES_U64 size_template( void* const instance ) 
+	{ 
+	return resources::resource_size( (T*) instance ); 
+	}
+
 } /* namespace internal */ } /* namespace resources */
 
 
@@ -164,6 +208,12 @@ template< typename T > resource_key make_key( T*, char const* filename )
 	}
 
 
+template< typename T > RESOURCES_U64 resource_size( T* )
+	{
+	return sizeof( T );
+	}
+
+
 template< typename T > resource<T>::resource( resource_system* system ):
 	system_( system ), instance_( 0 ), handle_( 0 ), type_( 0 )
 	{
@@ -176,7 +226,8 @@ resource<T>::resource( resource_system* system, P0 const& p0 ):
 	{
 	resource_key key = make_key( (T*)0, p0 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0 );
 		
 	instance_ = (T*) *info.instance;
@@ -192,7 +243,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1 ):
 	{
 	resource_key key = make_key( (T*)0, p0, p1 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1 );
 		
 	instance_ = (T*) *info.instance;
@@ -208,7 +260,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2 );
 		
 	instance_ = (T*) *info.instance;
@@ -224,7 +277,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2, p3 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2, p3 );
 		
 	instance_ = (T*) *info.instance;
@@ -240,7 +294,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2, p3, p4 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2, p3, p4 );
 		
 	instance_ = (T*) *info.instance;
@@ -256,7 +311,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2, p3, p4, p5 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2, p3, p4, p5 );
 		
 	instance_ = (T*) *info.instance;
@@ -272,7 +328,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2, p3, p4, p5, p6 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2, p3, p4, p5, p6 );
 		
 	instance_ = (T*) *info.instance;
@@ -288,7 +345,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2, p3, p4, p5, p6, p7 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2, p3, p4, p5, p6, p7 );
 		
 	instance_ = (T*) *info.instance;
@@ -304,7 +362,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2, p3, p4, p5, p6, p7, p8 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2, p3, p4, p5, p6, p7, p8 );
 		
 	instance_ = (T*) *info.instance;
@@ -320,7 +379,8 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	{
 	resource_key key = make_key( (T*)0, p0, p1, p2, p3, p4, p5, p6, p7, p8, p9 );
 
-	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T> );
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 ) internal::complete( system_->internals_, info.type, info.handle, true );
 	if( *info.instance == 0 ) resources::resource_create( (T**)info.instance, p0, p1, p2, p3, p4, p5, p6, p7, p8, p9 );
 		
 	instance_ = (T*) *info.instance;
@@ -330,6 +390,30 @@ resource<T>::resource( resource_system* system, P0 const& p0, P1 const& p1, P2 c
 	}
 	
 
+template< typename T > template< typename P0 > 
+resource<T>::resource( resource_system* system, async_t, P0 const& p0 ):
+	system_( system )
+	{
+	resource_key key = make_key( (T*)0, p0 );
+
+	// if the resource already exists, or is already pending, it is shared as usual
+	internal::info_t info = internal::inject( system_->internals_, type_id<T>(), &key, (internal::destroy_func_t) internal::destroy_template<T>, internal::size_template<T> );
+	if( *info.instance == 0 && !internal::is_pending( system_->internals_, info.type, info.handle ) ) 
+		{
+		void* request = resources::resource_request( (T*)0, p0 );
+		if( request )
+			internal::set_pending( system_->internals_, info.type, info.handle, request, internal::poll_template<T> );
+		else
+			resources::resource_create( (T**)info.instance, p0 );
+		}
+		
+	instance_ = (T*) *info.instance;
+	handle_ = info.handle;
+	type_ = info.type;
+	internal::inc_ref( system_->internals_, type_, handle_ );
+	}
+
+
 template< typename T > resource<T>::resource( resource const& other ):
 	system_( other.system_ ),
 	instance_( other.instance_ ),
@@ -363,22 +447,37 @@ template< typename T > resource<T> const& resource<T>::operator=( resource const
 
 template< typename T > resource<T>::operator T*() const
 	{
+	if( !instance_ && handle_ ) instance_ = (T*) internal::complete( system_->internals_, type_, handle_, true );
 	return instance_;
 	}
 
 
 template< typename T > T* resource<T>::operator->() const
 	{
+	if( !instance_ && handle_ ) instance_ = (T*) internal::complete( system_->internals_, type_, handle_, true );
 	RESOURCES_ASSERT( instance_, "Invalid instance" );
 	return instance_;
 	}
 
 
-template< typename T > typename resource<T>::list resource<T>::resource_list()
+template< typename T > bool resource<T>::ready() const
+	{
+	if( !instance_ && handle_ ) instance_ = (T*) internal::complete( system_->internals_, type_, handle_, false );
+	return !internal::is_pending( system_->internals_, type_, handle_ );
+	}
+
+
+template< typename T > bool resource<T>::failed() const
+	{
+	return handle_ && ready() && !instance_;
+	}
+
+
+template< typename T > typename resource<T>::list resource<T>::resource_list( resource_system* system )
 	{
 	list list;
 	list.count = 0;
-	list.items = (T**) internal::get_resource_list( system_, type_id<T>(), &list.count );	
+	list.items = (T**) internal::get_resource_list( system->internals_, type_id<T>(), &list.count );	
 	return list;
 	}
 
@@ -419,6 +518,13 @@ struct list_t
 		destroy_func_t destroy;
 		int ref_count;
 		int handle;
+		void* request; // non-zero while the resource is pending
+		poll_func_t poll;
+		size_func_t size;
+		bool cached; // no longer referenced, but kept until evicted
+		RESOURCES_U64 cached_size;
+		int lru_prev; // handles of neighbouring cached resources, -1 if none
+		int lru_next;
 		};
 
 	info_t* info;
@@ -426,6 +532,9 @@ struct list_t
 	int count;
 	int capacity;
 
+	void** referenced; // instances without the cached ones, for get_resource_list
+	int referenced_capacity;
+
 	hashtable_t lookup;
 	};
 
@@ -442,6 +551,12 @@ struct system_t
 	int handle_capacity;
 
 	int handles_freelist;
+
+	// unreferenced resources, most recently released first. handles_types maps a handle to its list
+	int* handle_types;
+	int lru_head;
+	int lru_tail;
+	resource_system::cache_stats_t stats;
 	};
 
 
@@ -459,23 +574,37 @@ static void initialize( system_t* system, void* memctx )
 
 	system->handles = (int*) RESOURCES_MALLOC( system->memctx, system->handle_capacity * sizeof( *system->handles ) );
 	RESOURCES_ASSERT( system->handles, "Allocation failed" );
+
+	system->handle_types = (int*) RESOURCES_MALLOC( system->memctx, system->handle_capacity * sizeof( *system->handle_types ) );
+	RESOURCES_ASSERT( system->handle_types, "Allocation failed" );
+
+	system->lru_head = -1;
+	system->lru_tail = -1;
+	memset( &system->stats, 0, sizeof( system->stats ) );
 	}
 
 
 static void terminate( system_t* system )
 	{
 	RESOURCES_FREE( system->memctx, system->handles );
+	RESOURCES_FREE( system->memctx, system->handle_types );
 
 	for( int i = 0; i < system->list_count; ++i )
 		{
 		list_t& list = system->lists[ i ];
 		for( int j = 0; j < list.count; ++j )
 			{
+			if( list.info[ j ].request ) 
+				{
+				list.info[ j ].poll( &list.instances[ j ], list.info[ j ].request, true );
+				list.info[ j ].request = 0;
+				}
 			list.info[ j ].destroy( &list.info[ j ].key, list.instances[ j ] );
 			if( list.info[ j ].key.destroy ) list.info[ j ].key.destroy( list.info[ j ].key.instance );
 			}
 		RESOURCES_FREE( system->memctx, list.info );
 		RESOURCES_FREE( system->memctx, list.instances );
+		if( list.referenced ) RESOURCES_FREE( system->memctx, list.referenced );
 		hashtable_term( &list.lookup );
 		}
 
@@ -490,8 +619,27 @@ void** get_resource_list( system_t* system, type_id_t const type, int* count )
 		list_t& current_list = system->lists[ i ];
 		if( current_list.type == type )
 			{
-			*count = current_list.count;
-			return current_list.instances;
+			if( system->stats.cached_count == 0 )
+				{
+				*count = current_list.count;
+				return current_list.instances;
+				}
+
+			// cached resources are no longer referenced by anyone, so they are left out
+			if( current_list.referenced_capacity < current_list.capacity )
+				{
+				if( current_list.referenced ) RESOURCES_FREE( system->memctx, current_list.referenced );
+				current_list.referenced_capacity = current_list.capacity;
+				current_list.referenced = (void**) RESOURCES_MALLOC( system->memctx, 
+					current_list.referenced_capacity * sizeof( *current_list.referenced ) );
+				RESOURCES_ASSERT( current_list.referenced, "Allocation failed" );
+				}
+
+			int referenced_count = 0;
+			for( int j = 0; j < current_list.count; ++j )
+				if( !current_list.info[ j ].cached ) current_list.referenced[ referenced_count++ ] = current_list.instances[ j ];
+			*count = referenced_count;
+			return current_list.referenced;
 			}
 		}
 
@@ -553,7 +701,38 @@ HASHTABLE_U64 murmur_hash_64( const void * key, size_t len, HASHTABLE_U64 seed )
 	}
 
 
-info_t inject( system_t* system, type_id_t type, resource_key const* key, destroy_func_t destroy )
+static list_t::info_t& lru_info( system_t* system, int const handle )
+	{
+	return system->lists[ system->handle_types[ handle ] ].info[ system->handles[ handle ] ];
+	}
+
+
+static void lru_unlink( system_t* system, list_t::info_t& info )
+	{
+	if( info.lru_prev >= 0 ) lru_info( system, info.lru_prev ).lru_next = info.lru_next; else system->lru_head = info.lru_next;
+	if( info.lru_next >= 0 ) lru_info( system, info.lru_next ).lru_prev = info.lru_prev; else system->lru_tail = info.lru_prev;
+	info.lru_prev = -1;
+	info.lru_next = -1;
+	info.cached = false;
+	system->stats.cached_size -= info.cached_size;
+	--system->stats.cached_count;
+	}
+
+
+static void lru_push( system_t* system, list_t::info_t& info, void* instance )
+	{
+	info.cached = true;
+	info.cached_size = info.size( instance );
+	info.lru_prev = -1;
+	info.lru_next = system->lru_head;
+	if( system->lru_head >= 0 ) lru_info( system, system->lru_head ).lru_prev = info.handle; else system->lru_tail = info.handle;
+	system->lru_head = info.handle;
+	system->stats.cached_size += info.cached_size;
+	++system->stats.cached_count;
+	}
+
+
+info_t inject( system_t* system, type_id_t type, resource_key const* key, destroy_func_t destroy, size_func_t size )
 	{
 	// find the list for this resource type
 	list_t* list = 0;
@@ -591,6 +770,8 @@ info_t inject( system_t* system, type_id_t type, resource_key const* key, destro
 		RESOURCES_ASSERT( current_list->instances, "Allocation failed" );
 		current_list->info = (list_t::info_t*) RESOURCES_MALLOC( system->memctx, current_list->capacity * sizeof( *current_list->info ) );
 		RESOURCES_ASSERT( current_list->info, "Allocation failed" );
+		current_list->referenced = 0;
+		current_list->referenced_capacity = 0;
 		hashtable_init( &current_list->lookup, sizeof( int ), current_list->capacity, system->memctx );
 		list = current_list;
 		}
@@ -601,6 +782,12 @@ info_t inject( system_t* system, type_id_t type, resource_key const* key, destro
 		int* item_index = (int*) hashtable_find( &list->lookup, key->handle );
 		if( item_index )
 			{
+			if( list->info[ *item_index ].cached ) 
+				{
+				++system->stats.hits;
+				lru_unlink( system, list->info[ *item_index ] );
+				}
+
 			info_t ret;
 			ret.instance = &list->instances[ *item_index ];
 			ret.handle = list->info[ *item_index ].handle + 1;
@@ -610,6 +797,7 @@ info_t inject( system_t* system, type_id_t type, resource_key const* key, destro
 		}
 		
 	// resource does not exist, so create it
+	if( key->handle != 0 ) ++system->stats.misses;
 
 	// acquire a handle for the new resource
 	int handle = system->handles_freelist;
@@ -624,6 +812,12 @@ info_t inject( system_t* system, type_id_t type, resource_key const* key, destro
 			memcpy( new_handles, system->handles, system->handle_count * sizeof( *system->handles ) );
 			RESOURCES_FREE( system->memctx, system->handles );
 			system->handles = new_handles;
+
+			int* new_handle_types = (int*) RESOURCES_MALLOC( system->memctx, system->handle_capacity * sizeof( *system->handle_types ) );
+			RESOURCES_ASSERT( new_handle_types, "Allocation failed" );
+			memcpy( new_handle_types, system->handle_types, system->handle_count * sizeof( *system->handle_types ) );
+			RESOURCES_FREE( system->memctx, system->handle_types );
+			system->handle_types = new_handle_types;
 			}
 		
 		handle = system->handle_count++;
@@ -657,12 +851,20 @@ info_t inject( system_t* system, type_id_t type, resource_key const* key, destro
 	int const index = list->count++;
 	list->instances[ index ] = 0; // the instance pointer is set to 0 to signal to the caller that resource_create must be called
 	system->handles[ handle ] = index; // point the handle to the correct index - will allow moving of list entries
+	system->handle_types[ handle ] = list_index;
 	
 	list_t::info_t& info = list->info[ index ];
 	info.key = *key;
 	info.destroy = destroy;
 	info.ref_count = 0;
 	info.handle = handle;
+	info.request = 0;
+	info.poll = 0;
+	info.size = size;
+	info.cached = false;
+	info.cached_size = 0;
+	info.lru_prev = -1;
+	info.lru_next = -1;
 
 	// unless the key is an "anonymous" key (handle is 0), insert it into lookup table
 	if( key->handle != 0 )
@@ -702,6 +904,63 @@ int inc_ref( system_t* system, int const type, int const handle )
 	}
 
 
+// destroys the resource at the specified index, and removes it by swapping in the last item
+static void remove_resource( system_t* system, int const type, int const index )
+	{
+	list_t& list = system->lists[ type ];
+
+	// destroy instances (key and resource)
+	if( list.info[ index ].destroy && list.instances[ index ] ) 
+		list.info[ index ].destroy( &list.info[ index ].key, list.instances[ index ] );
+	if( list.info[ index ].key.destroy && list.info[ index ].key.instance ) 
+		list.info[ index ].key.destroy( list.info[ index ].key.instance );
+
+	// unless the key is an "anonymous" key (handle is 0), remove it from lookup table
+	resource_key* key = &list.info[ index ].key;
+	if( key->handle != 0 )
+		hashtable_remove( &list.lookup, key->handle );
+		
+	// update lookup table for last item (to be swapped)
+	resource_key* last_key = &list.info[ list.count - 1 ].key;
+	if( last_key->handle != 0 )
+		{
+		int* last_index = (int*)hashtable_find( &list.lookup, last_key->handle );
+		if( last_index ) *last_index = index; // now points to the element we are about to remove
+		}
+
+	// store the handle of the items being swapped
+	int removed_handle = list.info[ index ].handle;
+	int swapped_handle = list.info[ list.count - 1 ].handle;
+
+	// swap items, replacing the element we are removing with the last element
+	list.info[ index ] = list.info[ list.count - 1 ];
+	list.instances[ index ] = list.instances[ list.count - 1 ];
+	--list.count;
+
+	// update the handle for the swapped item
+	system->handles[ swapped_handle ] = index;
+
+	// release the handle used by the removed item
+	system->handles[ removed_handle ] = system->handles_freelist;
+	system->handles_freelist = removed_handle;
+	}
+
+
+// destroys least recently used resources until the cache is within budget
+static void evict( system_t* system )
+	{
+	while( system->lru_tail >= 0 && system->stats.cached_size > system->stats.budget )
+		{
+		int const handle = system->lru_tail;
+		int const type = system->handle_types[ handle ];
+		int const index = system->handles[ handle ];
+		lru_unlink( system, system->lists[ type ].info[ index ] );
+		remove_resource( system, type, index );
+		++system->stats.evictions;
+		}
+	}
+
+
 int dec_ref( system_t* system, int const type, int const handle )
 	{
 	if( handle == 0 ) return 0;
@@ -717,49 +976,75 @@ int dec_ref( system_t* system, int const type, int const handle )
 	--ref_count;
 	if( ref_count <= 0 )
 		{
-		// remove item by swapping in last item
-		
-		// destroy instances (key and resource)
-		if( list.info[ index ].destroy && list.instances[ index ] ) 
-			list.info[ index ].destroy( &list.info[ index ].key, list.instances[ index ] );
-		if( list.info[ index ].key.destroy && list.info[ index ].key.instance ) 
-			list.info[ index ].key.destroy( list.info[ index ].key.instance );
-
-		// unless the key is an "anonymous" key (handle is 0), remove it from lookup table
-		resource_key* key = &list.info[ index ].key;
-		if( key->handle != 0 )
-			hashtable_remove( &list.lookup, key->handle );
-			
-		// update lookup table for last item (to be swapped)
-		resource_key* last_key = &list.info[ list.count - 1 ].key;
-		if( last_key->handle != 0 )
+		// a pending request still needs to finish before the resource can be cached or destroyed. waiting always completes
+		// it, and the poll frees the request, so it must not be polled again if the resource is revived from the cache
+		if( list.info[ index ].request )
 			{
-			int* last_index = (int*)hashtable_find( &list.lookup, last_key->handle );
-			if( last_index ) *last_index = index; // now points to the element we are about to remove
+			list.info[ index ].poll( &list.instances[ index ], list.info[ index ].request, true );
+			list.info[ index ].request = 0;
 			}
 
-		// store the handle of the items being swapped
-		int removed_handle = list.info[ index ].handle;
-		int swapped_handle = list.info[ list.count - 1 ].handle;
-
-		// swap items, replacing the element we are removing with the last element
-		list.info[ index ] = list.info[ list.count - 1 ];
-		list.instances[ index ] = list.instances[ list.count - 1 ];
-		--list.count;
-
-		// update the handle for the swapped item
-		system->handles[ swapped_handle ] = index;
-
-		// release the handle used by the removed item
-		system->handles[ removed_handle ] = system->handles_freelist;
-		system->handles_freelist = removed_handle;
-		
+		// keep it around if there is a budget for it, and it can be found again (not an anonymous key)
+		if( system->stats.budget > 0 && list.info[ index ].key.handle != 0 && list.instances[ index ] )
+			{
+			lru_push( system, list.info[ index ], list.instances[ index ] );
+			evict( system );
+			}
+		else
+			{
+			remove_resource( system, type, index );
+			}
 		return 0;
 		}
 
 	return ref_count;
 	}
 
+
+bool is_pending( system_t* system, int const type, int const handle )
+	{
+	if( handle == 0 ) return false;
+	RESOURCES_ASSERT( handle - 1 >= 0 && handle - 1 < system->handle_count, "Invalid handle" );
+
+	int const index = system->handles[ handle - 1 ];
+	RESOURCES_ASSERT( type >= 0 && type < system->list_count, "Invalid type" );
+	RESOURCES_ASSERT( index >= 0 && index < system->lists[ type ].count, "Invalid index" );
+
+	return system->lists[ type ].info[ index ].request != 0;
+	}
+
+
+void set_pending( system_t* system, int const type, int const handle, void* request, poll_func_t poll )
+	{
+	RESOURCES_ASSERT( handle - 1 >= 0 && handle - 1 < system->handle_count, "Invalid handle" );
+
+	int const index = system->handles[ handle - 1 ];
+	RESOURCES_ASSERT( type >= 0 && type < system->list_count, "Invalid type" );
+	RESOURCES_ASSERT( index >= 0 && index < system->lists[ type ].count, "Invalid index" );
+
+	system->lists[ type ].info[ index ].request = request;
+	system->lists[ type ].info[ index ].poll = poll;
+	}
+
+
+// polls the pending request for a resource (if any), and returns the instance, or 0 if it is still pending
+void* complete( system_t* system, int const type, int const handle, bool wait )
+	{
+	if( handle == 0 ) return 0;
+	RESOURCES_ASSERT( handle - 1 >= 0 && handle - 1 < system->handle_count, "Invalid handle" );
+
+	int const index = system->handles[ handle - 1 ];
+	RESOURCES_ASSERT( type >= 0 && type < system->list_count, "Invalid type" );
+	list_t& list = system->lists[ type ];
+	RESOURCES_ASSERT( index >= 0 && index < list.count, "Invalid index" );
+
+	list_t::info_t& info = list.info[ index ];
+	if( info.request && info.poll( &list.instances[ index ], info.request, wait ) ) 
+		info.request = 0;
+
+	return list.instances[ index ];
+	}
+
 } /* namespace internal */ } /* namespace resources */
 
 
@@ -780,6 +1065,19 @@ resource_system::~resource_system()
 	}
 
 
+void resource_system::cache_budget( RESOURCES_U64 bytes )
+	{
+	internals_->stats.budget = bytes;
+	internal::evict( internals_ );
+	}
+
+
+resource_system::cache_stats_t resource_system::cache_stats() const
+	{
+	return internals_->stats;
+	}
+
+
 } /* namespace resources */
 
 
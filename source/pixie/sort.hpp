@@ -18,11 +18,18 @@ implementation has significantly better performance, due to inlining of the
 compare function. I am not an expert in sorting though, so tests might be 
 faulty. In any case, it works well for my use cases, with a tiny code 
 footprint, for those times when STL is not an option.
+
+Also includes a stable merge sort, and an LSD radix sort for integer and float keys (which is also stable), both of 
+which need a temporary buffer of the same size as the array to sort.
 */
 
 #ifndef sort_hpp
 #define sort_hpp
 
+#ifndef SORT_U64
+	#define SORT_U64 unsigned long long
+#endif
+
 namespace sort_ns {
 
 
@@ -30,6 +37,14 @@ template< typename T > void sort( T* array, int count );
 
 template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void sort( T* array, int count );
 
+template< typename T > void stable_sort( T* array, int count, T* temp );
+
+template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void stable_sort( T* array, int count, T* temp );
+
+template< typename T > void radix_sort( T* array, int count, T* temp );
+
+template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ) > void radix_sort( T* array, int count, T* temp );
+
 
 } /* namespace sort_ns */
 
@@ -69,6 +84,29 @@ Sorts the given array, containing `count` items. `COMPARE_FUNC` is a custom comp
 elements for sorting. It must return a negative integer value if the first argument is less than the second, 
 a positive integer value if the first argument is greater than the second and zero if the arguments are equal.
 
+
+stable_sort
+-----------
+
+	template< typename T > void stable_sort( T* array, int count, T* temp );
+	template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > void stable_sort( T* array, int count, T* temp );
+
+Same as `sort`, but elements which compare equal keep their relative order. `temp` must have room for `count` items,
+and its contents are overwritten. Implemented as a bottom-up merge sort.
+
+
+radix_sort
+----------
+
+	template< typename T > void radix_sort( T* array, int count, T* temp );
+	template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ) > void radix_sort( T* array, int count, T* temp );
+
+Sorts the given array in ascending order of its keys, using an LSD radix sort, which is stable. The first version 
+sorts an array of integers, floats or doubles by value. The second version sorts by a key returned by `KEY_FUNC`, 
+which must be an integer, float or double type (for example, a field of a struct). `temp` must have room for `count` 
+items, and its contents are overwritten. It takes one pass over the array for each byte of the key, but passes where
+all keys have the same value for that byte are skipped. NaN keys are sorted to the ends.
+
 **/
 
 /*
@@ -187,6 +225,154 @@ void sort( T* array, int count )
 	}
 
 
+template< typename T, int (*COMPARE_FUNC)( T const&, T const& ) > 
+void stable_sort( T* array, int count, T* temp )
+	{
+	// insertion sort on small runs
+	int const run = 16;
+	for( int start = 0; start < count; start += run )
+		{
+		T* a = array + start;
+		int n = count - start < run ? count - start : run;
+		for( int i = 1; i < n; ++i )
+			{
+			T t = a[ i ];
+			int j = i;
+			for( ; j > 0 && COMPARE_FUNC( a[ j - 1 ], t ) > 0; --j ) a[ j ] = a[ j - 1 ];
+			a[ j ] = t;
+			}
+		}
+
+	// merge runs of doubling width, back and forth between array and temp
+	T* src = array;
+	T* dst = temp;
+	for( int width = run; width < count; width *= 2 )
+		{
+		for( int start = 0; start < count; start += width * 2 )
+			{
+			int mid = start + width < count ? start + width : count;
+			int end = start + width * 2 < count ? start + width * 2 : count;
+			int l = start;
+			int r = mid;
+			int o = start;
+			if( mid < end && COMPARE_FUNC( src[ mid - 1 ], src[ mid ] ) <= 0 ) // already in order
+				{
+				while( o < end ) dst[ o++ ] = src[ l++ ];
+				continue;
+				}
+			while( l < mid && r < end ) dst[ o++ ] = COMPARE_FUNC( src[ r ], src[ l ] ) < 0 ? src[ r++ ] : src[ l++ ];
+			while( l < mid ) dst[ o++ ] = src[ l++ ];
+			while( r < end ) dst[ o++ ] = src[ r++ ];
+			}
+		T* t = src; src = dst; dst = t;
+		}
+
+	if( src != array ) 
+		for( int i = 0; i < count; ++i ) array[ i ] = src[ i ];
+	}
+
+
+template< typename T > 
+void stable_sort( T* array, int count, T* temp ) 
+	{ 
+	stable_sort< T, &sort_default_cmp<T> >( array, count, temp ); 
+	}
+
+
+namespace internal {
+
+// map keys to unsigned integers with the same ordering
+inline unsigned int radix_bits( unsigned char key ) { return key; }
+inline unsigned int radix_bits( unsigned short key ) { return key; }
+inline unsigned int radix_bits( unsigned int key ) { return key; }
+inline SORT_U64 radix_bits( unsigned long key ) { return (SORT_U64) key; }
+inline SORT_U64 radix_bits( unsigned long long key ) { return (SORT_U64) key; }
+inline unsigned int radix_bits( signed char key ) { return (unsigned char)( key ^ 0x80 ); }
+inline unsigned int radix_bits( char key ) { return (unsigned char)( key ^ 0x80 ); }
+inline unsigned int radix_bits( short key ) { return (unsigned short)( key ^ 0x8000 ); }
+inline unsigned int radix_bits( int key ) { return ( (unsigned int) key ) ^ 0x80000000u; }
+inline SORT_U64 radix_bits( long key ) { return ( (SORT_U64)(long long) key ) ^ ( ( (SORT_U64) 1 ) << 63 ); }
+inline SORT_U64 radix_bits( long long key ) { return ( (SORT_U64) key ) ^ ( ( (SORT_U64) 1 ) << 63 ); }
+
+inline unsigned int radix_bits( float key ) 
+	{ 
+	union { float f; unsigned int u; } bits; 
+	bits.f = key;
+	// flip all bits of negative numbers, and only the sign bit of positive ones
+	return bits.u ^ ( ( bits.u & 0x80000000u ) ? 0xffffffffu : 0x80000000u );
+	}
+
+inline SORT_U64 radix_bits( double key ) 
+	{ 
+	union { double f; SORT_U64 u; } bits; 
+	bits.f = key;
+	SORT_U64 const sign = ( (SORT_U64) 1 ) << 63;
+	return bits.u ^ ( ( bits.u & sign ) ? ~( (SORT_U64) 0 ) : sign );
+	}
+
+
+template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ), typename BITS > 
+void radix_sort( T* array, int count, T* temp, BITS )
+	{
+	int const passes = (int) sizeof( BITS );
+	int histogram[ sizeof( BITS ) ][ 256 ] = { 0 };
+	for( int i = 0; i < count; ++i )
+		{
+		BITS bits = radix_bits( KEY_FUNC( array[ i ] ) );
+		for( int pass = 0; pass < passes; ++pass ) 
+			++histogram[ pass ][ ( bits >> ( pass * 8 ) ) & 0xff ];
+		}
+
+	T* src = array;
+	T* dst = temp;
+	for( int pass = 0; pass < passes; ++pass )
+		{
+		int* offsets = histogram[ pass ];
+		if( offsets[ ( radix_bits( KEY_FUNC( src[ 0 ] ) ) >> ( pass * 8 ) ) & 0xff ] == count ) continue; // all same
+		
+		int sum = 0;
+		for( int i = 0; i < 256; ++i ) 
+			{ 
+			int n = offsets[ i ]; 
+			offsets[ i ] = sum; 
+			sum += n; 
+			}
+
+		for( int i = 0; i < count; ++i )
+			dst[ offsets[ ( radix_bits( KEY_FUNC( src[ i ] ) ) >> ( pass * 8 ) ) & 0xff ]++ ] = src[ i ];
+
+		T* t = src; src = dst; dst = t;
+		}
+
+	if( src != array ) 
+		for( int i = 0; i < count; ++i ) array[ i ] = src[ i ];
+	}
+
+
+template< typename T > 
+inline T radix_default_key( T const& value ) 
+	{ 
+	return value; 
+	}
+
+} /* namespace internal */
+
+
+template< typename T, typename KEY, KEY (*KEY_FUNC)( T const& ) > 
+void radix_sort( T* array, int count, T* temp )
+	{
+	if( count < 2 ) return;
+	internal::radix_sort< T, KEY, KEY_FUNC >( array, count, temp, internal::radix_bits( KEY() ) );
+	}
+
+
+template< typename T > 
+void radix_sort( T* array, int count, T* temp ) 
+	{ 
+	radix_sort< T, T, &internal::radix_default_key<T> >( array, count, temp ); 
+	}
+
+
 } /* namespace sort_ns */
 
 
@@ -11,6 +11,15 @@ before you include this file in *one* C/C++ file to create the implementation.
 
 Dependencies: 
 	strpool.h
+
+A string_pool created with `concurrent` set splits its strings over a number of shards (picked by a hash of the 
+string), each with its own spin lock, so strings can be created, copied and released from several threads at once.
+The shard index is stored in the top bits of the handle, so equal strings still get equal handles. In concurrent mode,
+the allocator (STRPOOL_HPP_MALLOC/STRPOOL_HPP_FREE) must be thread safe. `temp_buffer` gives each thread a buffer of 
+its own, which the thread should free with `release_thread_temp_buffer` when it is done with strings.
+
+The global pools behind `string` and `string_id` are created on first use, which is safe to do from any thread. To 
+make them concurrent, define STRPOOL_HPP_CONCURRENT as 1 before including the implementation.
 */
 
 #ifndef strpool_hpp
@@ -99,17 +108,18 @@ inline void* operator new( size_t, void* p ) throw() { return p; } inline void o
 
 namespace strpool { namespace internal {
 
-int entry_count( strpool_t* pool );
-
 struct string_pool
 	{
-	string_pool( bool case_sensitive, void* memctx = 0 );
+	string_pool( bool case_sensitive, void* memctx = 0, bool concurrent = false );
 	~string_pool();
 
 	void defrag();
 	void nuke();
+	int entry_count();
+	bool concurrent() const;
 			
 	u64 get_handle( char const* string_type, int length );
+	u64 acquire_handle( char const* string_type, int length ); // get_handle and inc_ref_count in one step
 
 	void inc_ref_count( u64 handle );
 	void dec_ref_count( u64 handle );
@@ -120,11 +130,20 @@ struct string_pool
 	char* temp_buffer( int len );
 				
 	private:
-		template< typename POOL > 
-		friend internal::string_pool& pool_instance( bool destroy );
+		enum { SHARD_BITS = 4, MAX_SHARDS = 1 << SHARD_BITS };
+		struct shard_t { struct strpool_t* pool; long volatile lock; };
+
+		u64 local_handle( u64 handle ) const;
+		shard_t* lock_shard( u64 handle );
+		shard_t* lock_shard( char const* str, int length );
+		void unlock_shard( shard_t* shard );
+		void init_shards();
+		void term_shards();
 
 		void* memctx_;
-		struct strpool_t* pool_;
+		bool case_sensitive_;
+		int shard_count_;
+		shard_t* shards_;
 		char* temp_buffer_;
 		int temp_buffer_size_;
 	};
@@ -135,50 +154,62 @@ char* strncpy( char* dest, char const* source, size_t count );
 int memcmp( void const* buf1, void const* buf2, size_t count );
 void* allocate( size_t size );
 void release( void* ptr );
+void create_instance( string_pool* volatile* instance, bool case_sensitive );
+void release_thread_temp_buffer();
+
+inline string_pool* load_instance( string_pool* volatile* instance )
+	{
+	#if defined( _MSC_VER )
+		return *instance; // volatile reads have acquire semantics on msvc
+	#else
+		return __atomic_load_n( instance, __ATOMIC_ACQUIRE );
+	#endif
+	}
 				
 template< typename POOL >
 internal::string_pool& pool_instance( bool destroy = false )
 	{
-	static string_pool* instance = 0;
+	static string_pool* volatile instance = 0;
 	if( destroy )
 		{
-		if( instance && entry_count( instance->pool_ ) == 0 )
+		// concurrent pools stay around when they run empty, as another thread could be about to use them
+		string_pool* pool = load_instance( &instance );
+		if( pool && !pool->concurrent() && pool->entry_count() == 0 )
 			{
-			instance->~string_pool();
-			release( instance );
+			pool->~string_pool();
+			release( pool );
 			instance = 0;
 			}
 		}
-	else if( !instance )
+	else if( !load_instance( &instance ) )
 		{
-		instance = (string_pool*) allocate( sizeof( *instance ) );
-		new (instance) string_pool( true );
+		create_instance( &instance, true );
 		}
 
-	return *instance;
+	return *load_instance( &instance );
 	}	
 
 
 template<>
 inline internal::string_pool& pool_instance<STRINGID_POOL>( bool destroy )
 	{
-	static string_pool* instance = 0;
+	static string_pool* volatile instance = 0;
 	if( destroy )
 		{
-		if( instance && entry_count( instance->pool_ ) == 0 )
+		string_pool* pool = load_instance( &instance );
+		if( pool && !pool->concurrent() && pool->entry_count() == 0 )
 			{
-			instance->~string_pool();
-			release( instance );
+			pool->~string_pool();
+			release( pool );
 			instance = 0;
 			}
 		}
-	else if( !instance )
+	else if( !load_instance( &instance ) )
 		{
-		instance = (string_pool*) allocate( sizeof( *instance ) );
-		new (instance) string_pool( false );
+		create_instance( &instance, false );
 		}
 
-	return *instance;
+	return *load_instance( &instance );
 	}	
 
 
@@ -235,8 +266,7 @@ string_type<POOL>::string_type( string_type const& other ):
 template< typename POOL > template< typename OTHER_POOL > 
 string_type<POOL>::string_type( string_type<OTHER_POOL> const& other )
 	{
-	handle_ = internal::pool_instance<POOL>().get_handle( other.c_str(), other.length() );
-	if( handle_ ) internal::pool_instance<POOL>().inc_ref_count( handle_ );
+	handle_ = internal::pool_instance<POOL>().acquire_handle( other.c_str(), other.length() );
 
 	#ifndef NDEBUG
 		internal::strncpy( debug_, c_str(), sizeof( debug_ ) );
@@ -255,8 +285,7 @@ string_type<POOL>::string_type( char* str )
 		}
 	else
 		{
-		handle_ = internal::pool_instance<POOL>().get_handle( str, (int) len );
-		if( handle_ ) internal::pool_instance<POOL>().inc_ref_count( handle_ );
+		handle_ = internal::pool_instance<POOL>().acquire_handle( str, (int) len );
 		}
 
 	#ifndef NDEBUG
@@ -276,8 +305,7 @@ string_type<POOL>::string_type( char const* str )
 		}
 	else
 		{
-		handle_ = internal::pool_instance<POOL>().get_handle( str, (int) len );
-		if( handle_ ) internal::pool_instance<POOL>().inc_ref_count( handle_ );
+		handle_ = internal::pool_instance<POOL>().acquire_handle( str, (int) len );
 		}
 
 	#ifndef NDEBUG
@@ -303,8 +331,7 @@ string_type<POOL>::string_type( char const* begin, char const* end ) :
 		}
 	else
 		{
-		handle_ = internal::pool_instance<POOL>().get_handle( begin, (int) len );
-		if( handle_ ) internal::pool_instance<POOL>().inc_ref_count( handle_ );
+		handle_ = internal::pool_instance<POOL>().acquire_handle( begin, (int) len );
 		}
 
 	#ifndef NDEBUG
@@ -406,74 +433,223 @@ char* string_type<POOL>::temp_buffer( int const len )
 
 #include "strpool.h"
 
+#ifndef STRPOOL_HPP_CONCURRENT
+	#define STRPOOL_HPP_CONCURRENT 0
+#endif
+
+#include <stdlib.h>
+
+#if defined( _MSC_VER )
+	#include <intrin.h>
+	extern "C" __declspec( dllimport ) int __stdcall SwitchToThread( void );
+	#define STRPOOL_HPP_TRY_LOCK( lock ) ( _InterlockedCompareExchange( (lock), 1, 0 ) == 0 )
+	#define STRPOOL_HPP_UNLOCK( lock ) ( _InterlockedExchange( (lock), 0 ) )
+	#define STRPOOL_HPP_YIELD() ( SwitchToThread() )
+	#define STRPOOL_HPP_CAS_PTR( ptr, expected, desired ) \
+		( _InterlockedCompareExchangePointer( (void* volatile*)(ptr), (desired), (expected) ) )
+	#define STRPOOL_HPP_THREAD_LOCAL __declspec( thread )
+	#define STRPOOL_HPP_LOCKED( lock ) ( *(lock) )
+#else
+	#include <sched.h>
+	#define STRPOOL_HPP_TRY_LOCK( lock ) ( __sync_val_compare_and_swap( (lock), 0, 1 ) == 0 )
+	#define STRPOOL_HPP_UNLOCK( lock ) ( __sync_lock_release( (lock) ) )
+	#define STRPOOL_HPP_YIELD() ( sched_yield() )
+	#define STRPOOL_HPP_CAS_PTR( ptr, expected, desired ) ( __sync_val_compare_and_swap( (ptr), (expected), (desired) ) )
+	#define STRPOOL_HPP_THREAD_LOCAL __thread
+	#define STRPOOL_HPP_LOCKED( lock ) ( __atomic_load_n( (lock), __ATOMIC_RELAXED ) )
+#endif
+
 namespace strpool { namespace internal {
 
-int entry_count( strpool_t* pool )
+// spin lock, which yields to other threads if it has to spin for longer
+static void strpool_hpp_lock( long volatile* lock )
 	{
-	return pool->entry_count;
+	int spins = 0;
+	while( !STRPOOL_HPP_TRY_LOCK( lock ) ) 
+		while( STRPOOL_HPP_LOCKED( lock ) ) 
+			if( ++spins >= 64 ) { STRPOOL_HPP_YIELD(); spins = 0; }
 	}
 
 
-string_pool::string_pool( bool case_sensitive, void* memctx ):
+// concurrent pools can't share one temp buffer between threads, so each thread gets its own. it isn't tied to a pool, 
+// so it comes from the plain heap rather than a pool's memctx
+static STRPOOL_HPP_THREAD_LOCAL char* thread_temp_buffer = 0;
+static STRPOOL_HPP_THREAD_LOCAL int thread_temp_buffer_size = 0;
+
+
+string_pool::string_pool( bool case_sensitive, void* memctx, bool concurrent ):
 	memctx_( memctx ),
+	case_sensitive_( case_sensitive ),
+	shard_count_( concurrent ? MAX_SHARDS : 1 ),
 	temp_buffer_size_( 256 )
 	{
-	strpool_config_t config = strpool_default_config;
-	config.memctx = memctx;
-	config.ignore_case = case_sensitive ? 0 : 1;
-	pool_ = (strpool_t*) STRPOOL_HPP_MALLOC( memctx, sizeof( strpool_t ) );
-	strpool_init( pool_, &config );
+	shards_ = (shard_t*) STRPOOL_HPP_MALLOC( memctx, sizeof( shard_t ) * shard_count_ );
+	for( int i = 0; i < shard_count_; ++i )
+		{
+		shards_[ i ].pool = (strpool_t*) STRPOOL_HPP_MALLOC( memctx, sizeof( strpool_t ) );
+		shards_[ i ].lock = 0;
+		}
+	init_shards();
 	temp_buffer_ = (char*) STRPOOL_HPP_MALLOC( memctx, (size_t) temp_buffer_size_ );
 	}
 	
 string_pool::~string_pool()
 	{
-	strpool_term( pool_ );
-	STRPOOL_HPP_FREE( memctx_, pool_ );
+	term_shards();
+	for( int i = 0; i < shard_count_; ++i )
+		STRPOOL_HPP_FREE( memctx_, shards_[ i ].pool );
+	STRPOOL_HPP_FREE( memctx_, shards_ );
 	STRPOOL_HPP_FREE( memctx_, temp_buffer_ );
 	}
 
+void string_pool::init_shards()
+	{
+	strpool_config_t config = strpool_default_config;
+	config.memctx = memctx_;
+	config.ignore_case = case_sensitive_ ? 0 : 1;
+	if( shard_count_ > 1 ) config.counter_bits = 64 - SHARD_BITS - config.index_bits; // leave room for the shard index
+	for( int i = 0; i < shard_count_; ++i )
+		strpool_init( shards_[ i ].pool, &config );
+	}
+
+void string_pool::term_shards()
+	{
+	for( int i = 0; i < shard_count_; ++i )
+		strpool_term( shards_[ i ].pool );
+	}
+
+string_pool::shard_t* string_pool::lock_shard( STRPOOL_U64 const handle )
+	{
+	shard_t* shard = &shards_[ shard_count_ > 1 ? (int)( handle >> ( 64 - SHARD_BITS ) ) : 0 ];
+	if( shard_count_ > 1 ) strpool_hpp_lock( &shard->lock );
+	return shard;
+	}
+
+string_pool::shard_t* string_pool::lock_shard( char const* const str, int const length )
+	{
+	if( shard_count_ <= 1 ) return shards_;
+
+	// FNV-1a, lowercased for case insensitive pools so that equal strings end up in the same shard
+	unsigned int hash = 2166136261u;
+	for( int i = 0; i < length; ++i )
+		{
+		unsigned char c = (unsigned char) str[ i ];
+		if( !case_sensitive_ && c >= 'A' && c <= 'Z' ) c = (unsigned char)( c - 'A' + 'a' );
+		hash = ( hash ^ c ) * 16777619u;
+		}
+	shard_t* shard = &shards_[ ( hash ^ ( hash >> 16 ) ) & ( shard_count_ - 1 ) ];
+	strpool_hpp_lock( &shard->lock );
+	return shard;
+	}
+
+STRPOOL_U64 string_pool::local_handle( STRPOOL_U64 const handle ) const
+	{
+	return shard_count_ > 1 ? handle & ( ~(STRPOOL_U64) 0 >> SHARD_BITS ) : handle;
+	}
+
+void string_pool::unlock_shard( shard_t* const shard )
+	{
+	if( shard_count_ > 1 ) STRPOOL_HPP_UNLOCK( &shard->lock );
+	}
+
 void string_pool::defrag()
 	{
-	strpool_defrag( pool_ );
+	for( int i = 0; i < shard_count_; ++i )
+		{
+		shard_t* shard = lock_shard( ( (STRPOOL_U64) i ) << ( 64 - SHARD_BITS ) );
+		strpool_defrag( shard->pool );
+		unlock_shard( shard );
+		}
 	}
 
 void string_pool::nuke()
 	{
-	strpool_term( pool_ );
-	strpool_init( pool_, &strpool_default_config );
+	term_shards();
+	init_shards();
+	}
+
+int string_pool::entry_count()
+	{
+	int count = 0;
+	for( int i = 0; i < shard_count_; ++i )
+		count += shards_[ i ].pool->entry_count;
+	return count;
 	}
 
 STRPOOL_U64 string_pool::get_handle( char const* const str, int const length )
 	{
-	return strpool_inject( pool_, str, length );
+	shard_t* shard = lock_shard( str, length );
+	STRPOOL_U64 handle = strpool_inject( shard->pool, str, length );
+	unlock_shard( shard );
+	if( !handle ) return 0;
+	return handle | ( ( (STRPOOL_U64)( shard - shards_ ) ) << ( 64 - SHARD_BITS ) );
+	}
+
+STRPOOL_U64 string_pool::acquire_handle( char const* const str, int const length )
+	{
+	// done under one lock, so another thread can not discard the string in between
+	shard_t* shard = lock_shard( str, length );
+	STRPOOL_U64 handle = strpool_inject( shard->pool, str, length );
+	if( handle ) strpool_incref( shard->pool, handle );
+	unlock_shard( shard );
+	if( !handle ) return 0;
+	return handle | ( ( (STRPOOL_U64)( shard - shards_ ) ) << ( 64 - SHARD_BITS ) );
 	}
 
 void string_pool::inc_ref_count( STRPOOL_U64 const handle )
 	{
-	strpool_incref( pool_, handle );
+	shard_t* shard = lock_shard( handle );
+	strpool_incref( shard->pool, local_handle( handle ) );
+	unlock_shard( shard );
 	}
 
 void string_pool::dec_ref_count( STRPOOL_U64 const handle )
 	{
-	if( strpool_decref( pool_, handle ) <= 0 )
+	shard_t* shard = lock_shard( handle );
+	STRPOOL_U64 const pool_handle = local_handle( handle );
+	if( strpool_decref( shard->pool, pool_handle ) <= 0 )
 		{
-		strpool_discard( pool_, handle );
+		strpool_discard( shard->pool, pool_handle );
 		}
+	unlock_shard( shard );
 	}
 
 char const* string_pool::get_string( STRPOOL_U64 const handle )
 	{
-	return strpool_cstr( pool_, handle );
+	// the string data itself is not moved by other threads adding strings, only by defrag
+	shard_t* shard = lock_shard( handle );
+	char const* str = strpool_cstr( shard->pool, local_handle( handle ) );
+	unlock_shard( shard );
+	return str;
 	}
 
 int string_pool::get_length( STRPOOL_U64 const handle )
 	{
-	return strpool_length( pool_, handle );
+	shard_t* shard = lock_shard( handle );
+	int length = strpool_length( shard->pool, local_handle( handle ) );
+	unlock_shard( shard );
+	return length;
+	}
+
+bool string_pool::concurrent() const
+	{
+	return shard_count_ > 1;
 	}
 
+
 char* string_pool::temp_buffer( int const len )
 	{
+	if( shard_count_ > 1 )
+		{
+		if( thread_temp_buffer_size < len + 1 ) 
+			{
+			thread_temp_buffer_size = len + 1 > 256 ? len + 1 : 256;
+			::free( thread_temp_buffer );
+			thread_temp_buffer = (char*) ::malloc( (size_t) thread_temp_buffer_size );
+			}
+		return thread_temp_buffer;
+		}
+
 	if( temp_buffer_size_ < len + 1 ) 
 		{
 		temp_buffer_size_ = len + 1;
@@ -491,6 +667,28 @@ int memcmp( void const* const buf1, void const* const buf2, size_t const count )
 void* allocate( size_t size ) { return STRPOOL_HPP_MALLOC( 0, size ); }
 void release( void* ptr ) { return STRPOOL_HPP_FREE( 0, ptr ); }
 
+
+// if several threads create the same global pool at once, the first one to publish it wins, and the others throw theirs
+// away. destroying the global pools is still for shutdown only, when no other threads use them
+void create_instance( string_pool* volatile* instance, bool case_sensitive )
+	{
+	string_pool* pool = (string_pool*) allocate( sizeof( *pool ) );
+	new (pool) string_pool( case_sensitive, 0, STRPOOL_HPP_CONCURRENT != 0 );
+	if( STRPOOL_HPP_CAS_PTR( instance, (string_pool*) 0, pool ) != 0 )
+		{
+		pool->~string_pool();
+		release( pool );
+		}
+	}
+
+
+void release_thread_temp_buffer()
+	{
+	::free( thread_temp_buffer );
+	thread_temp_buffer = 0;
+	thread_temp_buffer_size = 0;
+	}
+
 } /* namespace internal */ } /* namespace strpool */
 
 #endif /* STRPOOL_HPP_IMPLEMENTATION */
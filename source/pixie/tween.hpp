@@ -23,7 +23,7 @@ namespace tween_ns {
 	#define TWEEN_U64 unsigned long long 
 #endif
 
-namespace internal { struct system_t; }
+namespace internal { struct system_t; struct tweener_instance; }
 
 struct tweener;
 
@@ -65,6 +65,10 @@ struct tweener
 	template< typename T > 
 	tweener property( refcount::ref< tween_ns::property<T> > const& prop, T const& target, T (*lerp_func)( T, T, float ) = 0  );
 
+	// plain float variables are interpolated directly, without going through a property. the first four per tween are 
+	// stored in the tween itself, any more than that, or any added after a regular property, are added as regular properties
+	tweener property( float* variable, float target );
+
 	tweener delay( float duration );
 
 	typedef float (*ease_func_t)( float );
@@ -183,13 +187,7 @@ struct tweener
 		friend tweener tween_system::tween( float );
 		tweener( internal::system_t* system, float duration );
 
-		struct instance
-			{
-			~instance();
-			TWEEN_U64 handle;
-			internal::system_t* system;
-			};
-		refcount::ref<instance> instance_;
+		refcount::ref<internal::tweener_instance> instance_; // pooled by the tween_system, so must not outlive it
 		internal::system_t* system_;
 	};
 
@@ -230,13 +228,14 @@ struct interpolator
 	{
 	virtual ~interpolator() { };
 	virtual void update( float t ) = 0;
+	bool pooled;
 	};
 
 
 template< typename T > struct interpolator_ref : interpolator
 	{
 	private:
-		friend refcount::ref<interpolator_ref>;
+		friend struct tween_ns::tweener;
 
 		virtual void update( float t )
 			{
@@ -268,7 +267,7 @@ template< typename T > struct interpolator_ref : interpolator
 template< typename T > struct interpolator_ptr : interpolator
 	{
 	private:
-		friend refcount::ref<interpolator_ptr>;
+		friend struct tween_ns::tweener;
 
 		virtual void update( float t )
 			{
@@ -297,7 +296,23 @@ template< typename T > struct interpolator_ptr : interpolator
 	};
 
 
-void add_interpolator( struct system_t* system, TWEEN_U64 handle, refcount::ref<interpolator> const& interp );
+struct detached_tweeners_t;
+
+struct tweener_instance
+	{
+	TWEEN_U64 handle;
+	system_t* system; // null if the system has been destroyed, and the instance then belongs to `detached`
+	detached_tweeners_t* detached;
+	tweener_instance* prev;
+	tweener_instance* next;
+	int count;
+	};
+
+
+// interpolators are constructed in place in storage from the system's pool, falling back to a separate 
+// allocation for types which are larger than TWEEN_INTERPOLATOR_SIZE
+void* alloc_interpolator( system_t* system, size_t size, bool* pooled );
+void add_interpolator( system_t* system, TWEEN_U64 handle, interpolator* interp );
 
 
 template< typename T > struct variable : property<T>
@@ -463,8 +478,11 @@ namespace tween_ns {
 
 template< typename T > tweener tweener::property( tween_ns::property<T>* const prop, T const& target, T (* const lerp_func)( T, T, float ) ) 
 	{ 
-	refcount::ref<internal::interpolator> interp = 
-		refcount::ref< internal::interpolator_ptr<T> >::make_new( prop, target, lerp_func );
+	if( !system_ ) return *this;
+	bool pooled;
+	void* storage = internal::alloc_interpolator( system_, sizeof( internal::interpolator_ptr<T> ), &pooled );
+	internal::interpolator* interp = new (storage) internal::interpolator_ptr<T>( prop, target, lerp_func );
+	interp->pooled = pooled;
 	add_interpolator( system_, instance_->handle, interp );
 	return *this; 
 	}
@@ -472,8 +490,11 @@ template< typename T > tweener tweener::property( tween_ns::property<T>* const p
 
 template< typename T > tweener tweener::property( refcount::ref< tween_ns::property<T> > const& prop, T const& target, T (* const lerp_func)( T, T, float ) ) 
 	{ 
-	refcount::ref<internal::interpolator> interp = 
-		refcount::ref< internal::interpolator_ref<T> >::make_new( prop, target, lerp_func );
+	if( !system_ ) return *this;
+	bool pooled;
+	void* storage = internal::alloc_interpolator( system_, sizeof( internal::interpolator_ref<T> ), &pooled );
+	internal::interpolator* interp = new (storage) internal::interpolator_ref<T>( prop, target, lerp_func );
+	interp->pooled = pooled;
 	add_interpolator( system_, instance_->handle, interp );
 	return *this; 
 	}
@@ -761,9 +782,71 @@ template< typename T, typename U > refcount::ref< property<T> > make_property( r
 	#define TWEEN_FREE( ctx, ptr ) ( (void)ctx,::free( ptr ) )
 #endif
 
+#ifndef TWEEN_INTERPOLATOR_SIZE
+	#define TWEEN_INTERPOLATOR_SIZE 128
+#endif
+
 #include "handles.h"
 
 namespace tween_ns { namespace internal {
+
+// fixed size slots, allocated in blocks which are kept until the system is destroyed. the first 16 bytes of each 
+// block links the blocks together, and free slots are linked through their first bytes
+struct pool_t
+	{
+	void* blocks;
+	void* free_slots;
+	size_t slot_size;
+	};
+
+
+static void pool_init( pool_t* pool, size_t slot_size )
+	{
+	pool->blocks = 0;
+	pool->free_slots = 0;
+	pool->slot_size = ( slot_size + 15 ) & ~(size_t) 15;
+	}
+
+
+static void pool_term( pool_t* pool, void* memctx )
+	{
+	while( pool->blocks )
+		{
+		void* next = *(void**) pool->blocks;
+		TWEEN_FREE( memctx, pool->blocks );
+		pool->blocks = next;
+		}
+	}
+
+
+static void* pool_alloc( pool_t* pool, void* memctx )
+	{
+	if( !pool->free_slots )
+		{
+		int const slots_per_block = 64;
+		char* block = (char*) TWEEN_MALLOC( memctx, 16 + pool->slot_size * slots_per_block );
+		*(void**) block = pool->blocks;
+		pool->blocks = block;
+		for( int i = slots_per_block - 1; i >= 0; --i )
+			{
+			void* slot = block + 16 + pool->slot_size * i;
+			*(void**) slot = pool->free_slots;
+			pool->free_slots = slot;
+			}
+		}
+
+	void* slot = pool->free_slots;
+	pool->free_slots = *(void**) slot;
+	return slot;
+	}
+
+
+static void pool_free( pool_t* pool, void* slot )
+	{
+	*(void**) slot = pool->free_slots;
+	pool->free_slots = slot;
+	}
+
 	
 struct instance_t
 	{
@@ -780,8 +863,13 @@ struct instance_t
 	int repeat;
 	int interpolators_capacity;
 	int interpolators_count;
-	refcount::ref<interpolator> interpolators[ 8 ];
-	refcount::ref<interpolator>* interpolators_large;
+	interpolator* interpolators[ 8 ];
+	interpolator** interpolators_large;
+	int lanes_count;
+	int lanes_started;
+	float lanes_from[ 4 ];
+	float lanes_to[ 4 ];
+	float* lanes_targets[ 4 ];
 	refcount::ref<funccall::func_call> on_complete;
 	refcount::ref<funccall::func_call> on_repeat;
 	refcount::ref<funccall::func_call> on_update;
@@ -796,6 +884,20 @@ struct system_t
 	instance_t* instances;
 	int instances_capacity;
 	int instances_count;
+
+	pool_t interpolator_pool;
+	pool_t tweener_pool;
+	tweener_instance* tweeners; // live tweener instances, so they can be detached if the system goes first
+	bool updating;
+	};
+
+
+// tweeners which outlive their system keep the pool their instances live in, and the last one released frees it
+struct detached_tweeners_t
+	{
+	void* memctx;
+	pool_t pool;
+	int count;
 	};
 
 
@@ -813,19 +915,31 @@ static void init( instance_t* instance )
 	}
 
 
-static void deinit( instance_t* instance, bool free_mem, void* memctx )
+static void release_interpolator( system_t* system, interpolator* interp )
+	{
+	bool pooled = interp->pooled;
+	interp->~interpolator();
+	if( pooled ) 
+		pool_free( &system->interpolator_pool, interp );
+	else
+		TWEEN_FREE( system->memctx, interp );
+	}
+
+
+// when an instance has been copied to another slot, its interpolators now belong to the copy, and must not be released 
+static void deinit( system_t* system, instance_t* instance, bool release_interpolators )
 	{
 	instance->on_complete = refcount::ref<funccall::func_call>();
 	instance->on_repeat = refcount::ref<funccall::func_call>();
 	instance->on_update = refcount::ref<funccall::func_call>();
 
-	refcount::ref<interpolator>* interpolators = 
-		instance->interpolators_large ? instance->interpolators_large : instance->interpolators;
-		
+	if( !release_interpolators ) return;
+
+	interpolator** interpolators = instance->interpolators_large ? instance->interpolators_large : instance->interpolators;
 	for( int j = 0; j < instance->interpolators_count; ++j )
-		interpolators[ j ] = refcount::ref<interpolator>();
+		release_interpolator( system, interpolators[ j ] );
 		
-	if( free_mem ) if( instance->interpolators_large ) TWEEN_FREE( memctx, instance->interpolators_large );
+	if( instance->interpolators_large ) TWEEN_FREE( system->memctx, instance->interpolators_large );
 	}
 
 
@@ -858,14 +972,14 @@ static void remove( system_t* system, int index )
 
 	if( index != system->instances_count )
 		{
-		deinit( &system->instances[ index ], true, system->memctx );
+		deinit( system, &system->instances[ index ], true );
 		system->instances[ index ] = system->instances[ system->instances_count ];
-		deinit( &system->instances[ system->instances_count ], false, system->memctx );
+		deinit( system, &system->instances[ system->instances_count ], false );
 		handles_update( &system->handles, handles_from_u64( &system->handles, system->instances[ index ].handle ), index );
 		}
 	else
 		{
-		deinit( &system->instances[ system->instances_count ], true, system->memctx );
+		deinit( system, &system->instances[ system->instances_count ], true );
 		}
 	}
 
@@ -875,119 +989,183 @@ static void unregister( system_t* system, TWEEN_U64 const handle )
 	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
 	if( index < 0 ) return;
 
+	// while updating, removal is left to the update loop, as callbacks may release tweeners
 	instance_t* instance = &system->instances[ index ];
-	if( instance->done )	
+	if( instance->done && !system->updating )	
 		remove( system, index );
 	else
 		instance->is_safe_to_remove = true;
 	}
 
 
-void add_interpolator( struct system_t* system, TWEEN_U64 const handle, refcount::ref<interpolator> const& interp )
+// called when the last tweener referencing the instance goes away
+static void release_tweener( void* ptr )
+	{
+	tweener_instance* instance = (tweener_instance*) ptr;
+	system_t* system = instance->system;
+	if( !system )
+		{
+		detached_tweeners_t* detached = instance->detached;
+		if( --detached->count == 0 )
+			{
+			pool_term( &detached->pool, detached->memctx );
+			TWEEN_FREE( detached->memctx, detached );
+			}
+		return;
+		}
+
+	if( instance->prev ) instance->prev->next = instance->next; else system->tweeners = instance->next;
+	if( instance->next ) instance->next->prev = instance->prev;
+	unregister( system, instance->handle );
+	pool_free( &system->tweener_pool, instance );
+	}
+
+
+static instance_t* find( system_t* system, TWEEN_U64 const handle )
 	{
 	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
+	return index < 0 ? 0 : &system->instances[ index ];
+	}
+
+
+static bool add_lane( system_t* system, TWEEN_U64 const handle, float* variable, float target )
+	{
+	instance_t* instance = find( system, handle );
+	if( !instance ) return true;
+	if( instance->lanes_count >= (int)( sizeof( instance->lanes_targets ) / sizeof( *instance->lanes_targets ) ) ) return false;
+
+	// the lanes are written before the interpolators, so once there are interpolators, floats have to be added after them
+	// to keep properties updated in the order they were added
+	if( instance->interpolators_count > 0 ) return false;
+	instance->lanes_targets[ instance->lanes_count ] = variable;
+	instance->lanes_to[ instance->lanes_count ] = target;
+	++instance->lanes_count;
+	return true;
+	}
+
+
+// the floats are written as part of updating their own tween, rather than gathered up across tweens. gathering them into 
+// separate arrays and writing them back costs more than interpolating them four at a time saves
+static void update_lanes( instance_t* instance, float const t )
+	{
+	// like the interpolators, the start value is taken on the first update rather than when the tween is created
+	int const all_started = ( 1 << instance->lanes_count ) - 1;
+	if( instance->lanes_started != all_started )
+		{
+		for( int i = 0; i < instance->lanes_count; ++i )
+			if( !( instance->lanes_started & ( 1 << i ) ) ) instance->lanes_from[ i ] = *instance->lanes_targets[ i ];
+		instance->lanes_started = all_started;
+		}
+
+	for( int i = 0; i < instance->lanes_count; ++i )
+		*instance->lanes_targets[ i ] = instance->lanes_from[ i ] + ( instance->lanes_to[ i ] - instance->lanes_from[ i ] ) * t;
+	}
+
+
+void* alloc_interpolator( system_t* system, size_t size, bool* pooled )
+	{
+	*pooled = size <= TWEEN_INTERPOLATOR_SIZE;
+	return *pooled ? pool_alloc( &system->interpolator_pool, system->memctx ) : TWEEN_MALLOC( system->memctx, size );
+	}
+
+
+void add_interpolator( system_t* system, TWEEN_U64 const handle, interpolator* interp )
+	{
+	instance_t* instance = find( system, handle );
+	if( !instance ) 
+		{
+		release_interpolator( system, interp );
+		return;
+		}
 
-	instance_t* instance = &system->instances[ index ];
 	if( instance->interpolators_count >= instance->interpolators_capacity )
 		{
 		instance->interpolators_capacity *= 2;
+		interpolator** new_large = (interpolator**) TWEEN_MALLOC( system->memctx, instance->interpolators_capacity * sizeof( interpolator* ) );
 		if( instance->interpolators_large )
 			{
-			refcount::ref<interpolator>* new_large = (refcount::ref<interpolator>*) TWEEN_MALLOC( system->memctx, instance->interpolators_capacity * sizeof( refcount::ref<interpolator> ) );
-			memcpy( new_large, instance->interpolators_large, instance->interpolators_count * sizeof( refcount::ref<interpolator> ) );
+			memcpy( new_large, instance->interpolators_large, instance->interpolators_count * sizeof( interpolator* ) );
 			TWEEN_FREE( system->memctx, instance->interpolators_large );
-			instance->interpolators_large = new_large;
 			}
 		else
 			{
-			instance->interpolators_large = (refcount::ref<interpolator>*) TWEEN_MALLOC( system->memctx, instance->interpolators_capacity * sizeof( refcount::ref<interpolator> ) );
-			memcpy( instance->interpolators_large, instance->interpolators, instance->interpolators_count * sizeof( refcount::ref<interpolator> ) );
+			memcpy( new_large, instance->interpolators, instance->interpolators_count * sizeof( interpolator* ) );
 			}
+		instance->interpolators_large = new_large;
 		}
 
-	refcount::ref<interpolator>* interpolators = instance->interpolators_large ? instance->interpolators_large : instance->interpolators;
+	interpolator** interpolators = instance->interpolators_large ? instance->interpolators_large : instance->interpolators;
 	interpolators[ instance->interpolators_count++ ] = interp;
 	}
 
 
 static bool completed( system_t* system, TWEEN_U64 handle )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return true;
-	return system->instances[ index ].done;
+	instance_t* instance = find( system, handle );
+	return instance ? instance->done : true;
 	}
 
 
 static void duration_set( system_t* system, TWEEN_U64 handle, float duration )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].duration = duration;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->duration = duration;
 	}
 
 
 static void delay_set( system_t* system, TWEEN_U64 handle, float duration )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].delay = duration;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->delay = duration;
 	}
 
 
 static void ease_set( system_t* system, TWEEN_U64 handle, tweener::ease_func_t ease )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].ease = ease;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->ease = ease;
 	}
 
 
 static void on_complete_set( system_t* system, TWEEN_U64 handle, refcount::ref<funccall::func_call> const& handler )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].on_complete = handler;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->on_complete = handler;
 	}
 
 
 static void on_repeat_set( system_t* system, TWEEN_U64 handle, refcount::ref<funccall::func_call> const& handler )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].on_repeat = handler;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->on_repeat = handler;
 	}
 
 
 static void on_update_set( system_t* system, TWEEN_U64 handle, refcount::ref<funccall::func_call> const& handler )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].on_update = handler;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->on_update = handler;
 	}
 
 
 static void repeat_set( system_t* system, TWEEN_U64 handle, int times )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].repeat = times;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->repeat = times;
 	}
 
 
 static void pingpong_set( system_t* system, TWEEN_U64 handle, bool value )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].pingpong = value;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->pingpong = value;
 	}
 
 
 static void reverse_set( system_t* system, TWEEN_U64 handle, bool value )
 	{
-	int index = handles_index( &system->handles, handles_from_u64( &system->handles, handle ) );
-	if( index < 0 ) return;
-	system->instances[ index ].reverse = value;
+	instance_t* instance = find( system, handle );
+	if( instance ) instance->reverse = value;
 	}
 
 } /* namespace internal */ } /* namespace tween_ns */
@@ -1000,9 +1178,14 @@ tween_system::tween_system( void* memctx )
 	internals_->memctx = memctx;
 	internals_->instances_count = 0;
 	internals_->instances_capacity = 256;
+	internals_->updating = false;
 	internals_->instances = (internal::instance_t*) TWEEN_MALLOC( internals_->memctx, internals_->instances_capacity * sizeof( internal::instance_t ) );
 	
 	handles_init( &internals_->handles, internals_->instances_capacity, memctx );	
+
+	internal::pool_init( &internals_->interpolator_pool, TWEEN_INTERPOLATOR_SIZE );
+	internal::pool_init( &internals_->tweener_pool, sizeof( internal::tweener_instance ) );
+	internals_->tweeners = 0;
 	}
 
 
@@ -1013,9 +1196,31 @@ tween_system::~tween_system()
 	for( int i = 0; i < internals_->instances_count; ++i )
 		{
 		internal::instance_t* instance = &internals_->instances[ i ];
-		internal::deinit( instance, true, internals_->memctx );
+		internal::deinit( internals_, instance, true );
 		}
 	
+	internal::pool_term( &internals_->interpolator_pool, internals_->memctx );
+
+	if( internals_->tweeners )
+		{
+		// tweeners which are still referenced keep their instances until they are released
+		internal::detached_tweeners_t* detached = (internal::detached_tweeners_t*) TWEEN_MALLOC( internals_->memctx, 
+			sizeof( internal::detached_tweeners_t ) );
+		detached->memctx = internals_->memctx;
+		detached->pool = internals_->tweener_pool;
+		detached->count = 0;
+		for( internal::tweener_instance* instance = internals_->tweeners; instance; instance = instance->next )
+			{
+			instance->system = 0;
+			instance->detached = detached;
+			++detached->count;
+			}
+		}
+	else
+		{
+		internal::pool_term( &internals_->tweener_pool, internals_->memctx );
+		}
+
 	TWEEN_FREE( internals_->memctx, internals_->instances );
 	TWEEN_FREE( internals_->memctx, internals_ );
 	}
@@ -1023,9 +1228,17 @@ tween_system::~tween_system()
 
 void tween_system::update( float const delta_time )
 	{
+	internals_->updating = true;
 	for( int i = 0; i < internals_->instances_count; ++i )
 		{
 		internal::instance_t* instance = &internals_->instances[ i ];
+		if( instance->done && instance->is_safe_to_remove )
+			{
+			remove( internals_, i );
+			--i;
+			continue;
+			}
+
 		if( !instance->done )
 			{
 			if( instance->elapsed_delay < instance->delay )
@@ -1034,17 +1247,21 @@ void tween_system::update( float const delta_time )
 				continue;
 				}
 
+			// callbacks can start new tweens, which might move the instances array, so get the instance again after each call
 			if( instance->on_update ) instance->on_update->call();
+			instance = &internals_->instances[ i ];
 
 			instance->elapsed_time += delta_time;
 
 			float t = instance->elapsed_time / instance->duration;
 			t = t < 0.0f ? 0.0f : t;
 			t = t > 1.0f ? 1.0f : t;
-			t = instance->reverse ? t = 1.0f - t : t;
-			t = instance->ease( t );
+			t = instance->reverse ? 1.0f - t : t;
+			t = instance->ease == internal::default_ease ? t : instance->ease( t );
+
+			if( instance->lanes_count > 0 ) internal::update_lanes( instance, t );
 
-			refcount::ref<internal::interpolator>* interpolators = 
+			internal::interpolator** interpolators = 
 				instance->interpolators_large ? instance->interpolators_large : instance->interpolators;
 
 			for( int j = 0; j < instance->interpolators_count; ++j )
@@ -1055,6 +1272,7 @@ void tween_system::update( float const delta_time )
 				if( instance->repeat != 0 )
 					{
 					if( instance->on_repeat ) instance->on_repeat->call();
+					instance = &internals_->instances[ i ];
 					instance->elapsed_time = 0.0f;
 					instance->reverse = instance->pingpong ? !instance->reverse : instance->reverse;
 					if( instance->repeat > 0 ) --instance->repeat;
@@ -1063,6 +1281,7 @@ void tween_system::update( float const delta_time )
 					{
 					instance->done = true;
 					if( instance->on_complete ) instance->on_complete->call();
+					instance = &internals_->instances[ i ];
 
 					if( instance->is_safe_to_remove )
 						{
@@ -1074,6 +1293,7 @@ void tween_system::update( float const delta_time )
 				}
 			}
 		}
+	internals_->updating = false;
 	}
 
 
@@ -1105,6 +1325,15 @@ bool tweener::completed() const
 	}
 
 
+tweener tweener::property( float* const variable, float const target ) 
+	{ 
+	if( !system_ ) return *this;
+	if( !internal::add_lane( system_, instance_->handle, variable, target ) ) 
+		property( make_property( variable ), target );
+	return *this; 
+	}
+
+
 tweener tweener::delay( float const duration ) 
 	{ 
 	if( !system_ ) return *this;
@@ -1172,16 +1401,16 @@ tweener tweener::on_update( refcount::ref<funccall::func_call> const& handler )
 tweener::tweener( internal::system_t* system, float const duration ) :
 	system_( system )
 	{
-	instance_ = refcount::ref<instance>::make_new();
-	instance_->handle = reg( system_ );
-	instance_->system = system_;
-	internal::duration_set( system_, instance_->handle, duration );
-	}
-
-
-tweener::instance::~instance()
-	{
-	if( !system ) internal::unregister( system, handle );
+	internal::tweener_instance* instance = (internal::tweener_instance*) internal::pool_alloc( &system_->tweener_pool, system_->memctx );
+	instance->handle = reg( system_ );
+	instance->system = system_;
+	instance->detached = 0;
+	instance->prev = 0;
+	instance->next = system_->tweeners;
+	if( system_->tweeners ) system_->tweeners->prev = instance;
+	system_->tweeners = instance;
+	instance_ = refcount::make_ref( instance, internal::release_tweener, &instance->count, 0 );
+	internal::duration_set( system_, instance->handle, duration );
 	}
 
 